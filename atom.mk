@@ -9,7 +9,12 @@ LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
 LOCAL_CFLAGS := -DSDP_API_EXPORTS -fvisibility=hidden -std=gnu99
 LOCAL_SRC_FILES := \
 	src/sdp.c \
-	src/sdp_base64.c
+	src/sdp_base64.c \
+	src/sdp_parallel.c \
+	src/sdp_parser.c \
+	src/sdp_registry.c \
+	src/sdp_scan.c
+LOCAL_LDLIBS := -lpthread
 LOCAL_LIBRARIES := \
 	libfutils \
 	libulog
@@ -25,3 +30,40 @@ LOCAL_LIBRARIES := \
 	libsdp \
 	libulog
 include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := sdp-bench
+LOCAL_CATEGORY_PATH := multimedia
+LOCAL_DESCRIPTION := Session Description Protocol library microbenchmarks
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/src
+LOCAL_CFLAGS := -std=gnu99
+LOCAL_SRC_FILES := \
+	tests/sdp_bench.c
+LOCAL_LIBRARIES := \
+	libfutils \
+	libsdp \
+	libulog
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := sdp-check
+LOCAL_CATEGORY_PATH := multimedia
+LOCAL_DESCRIPTION := Session Description Protocol library checks
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/include \
+	$(LOCAL_PATH)/src
+LOCAL_CFLAGS := -DSDP_TEST_HOOKS -std=gnu99
+# Built from the library sources for the test hooks of src/sdp.h
+LOCAL_SRC_FILES := \
+	src/sdp.c \
+	src/sdp_base64.c \
+	src/sdp_parallel.c \
+	src/sdp_parser.c \
+	src/sdp_registry.c \
+	src/sdp_scan.c \
+	tests/sdp_check.c
+LOCAL_LDLIBS := -lpthread
+LOCAL_LIBRARIES := \
+	libfutils \
+	libulog
+include $(BUILD_EXECUTABLE)
@@ -46,6 +46,9 @@ extern "C" {
 #include <errno.h>
 #include <inttypes.h>
 #include <time.h>
+#ifndef _WIN32
+#	include <sys/uio.h>
+#endif /* !_WIN32 */
 
 #include <futils/list.h>
 
@@ -81,10 +84,69 @@ enum sdp_rtcp_xr_rtt_report_mode {
 };
 
 
+/* RTCP extended report blocks (RFC 3611 ch. 5.1); the reports with a
+ * maximum size come first */
+enum sdp_rtcp_xr_report {
+	SDP_RTCP_XR_REPORT_LOSS_RLE = 0,
+	SDP_RTCP_XR_REPORT_DUP_RLE,
+	SDP_RTCP_XR_REPORT_PKT_RECEIPT_TIMES,
+	/* Receiver reference time, see sdp_rtcp_xr.rtt_report */
+	SDP_RTCP_XR_REPORT_RTT,
+	SDP_RTCP_XR_REPORT_STATS_LOSS,
+	SDP_RTCP_XR_REPORT_STATS_DUP,
+	SDP_RTCP_XR_REPORT_STATS_JITTER,
+	SDP_RTCP_XR_REPORT_STATS_TTL,
+	SDP_RTCP_XR_REPORT_STATS_HL,
+	SDP_RTCP_XR_REPORT_VOIP_METRICS,
+	SDP_RTCP_XR_REPORT_DJB_METRICS,
+
+	SDP_RTCP_XR_REPORT_MAX,
+};
+
+
+/* Number of reports with a maximum size */
+#define SDP_RTCP_XR_SIZED_REPORT_COUNT (SDP_RTCP_XR_REPORT_RTT + 1)
+
+/* Bit of a report in sdp_rtcp_xr.reports */
+#define SDP_RTCP_XR_REPORT_BIT(_report) (1u << (_report))
+
+
+/* Part of the source text of a session description kept by the session
+ * object (see SDP_READ_FLAG_LAZY_ATTRS) */
+struct sdp_view {
+	uint32_t offset;
+	uint32_t len;
+};
+
+
 struct sdp_attr {
 	char *key;
 	char *value;
 
+	/* Lazy attribute: key and value are NULL until the attribute is
+	 * materialized (see sdp_attr_materialize()), the views locate them
+	 * in the source text; NULL otherwise */
+	const char *text;
+	struct sdp_view key_view;
+	struct sdp_view value_view;
+
+	/* Typed attribute: object decoded from the value by the parse
+	 * function of its type (see struct sdp_attr_type), NULL otherwise */
+	const struct sdp_attr_type *type;
+	void *data;
+
+	struct list_node node;
+};
+
+
+/* Line of a type the session and media objects do not model (b=, k=, r=,
+ * z=, t= or unknown) or attribute of the other formats of a media, kept
+ * with the SDP_READ_FLAG_RAW_LINES flag and written back unchanged; value
+ * is the text after '<type>=' */
+struct sdp_raw_line {
+	char type;
+	char *value;
+
 	struct list_node node;
 };
 
@@ -108,16 +170,33 @@ struct sdp_time_npt {
 	uint32_t usec;
 };
 
+/* SMPTE timecode types (frame rates), see RFC 2326 chapter 3.5 */
+enum sdp_time_smpte_type {
+	/* 30 frames per second (smpte) */
+	SDP_TIME_SMPTE_TYPE_30 = 0,
+	/* 29.97 frames per second with drop frames (smpte-30-drop) */
+	SDP_TIME_SMPTE_TYPE_30_DROP,
+	/* 25 frames per second (smpte-25) */
+	SDP_TIME_SMPTE_TYPE_25,
+
+	SDP_TIME_SMPTE_TYPE_MAX,
+};
+
 /* SMPTE Relative Timestamps, see RFC 2326 chapter 3.5 */
 struct sdp_time_smpte {
 	int infinity;
 	uint64_t sec;
 	unsigned int frames;
+	/* Hundredths of a frame */
+	unsigned int subframes;
+	/* Same type for the start and stop times of a range */
+	enum sdp_time_smpte_type type;
 };
 
 /* Absolute Time (UTC, ISO 8601), see RFC 2326 chapter 3.7 */
 struct sdp_time_absolute {
 	int infinity;
+	/* Seconds since 1970-01-01T00:00:00Z; earlier times are rejected */
 	uint64_t sec;
 	uint32_t usec;
 };
@@ -153,22 +232,24 @@ struct sdp_h264_fmtp {
 
 /* RFC 3611 and RFC 7005 RTCP extended reports */
 struct sdp_rtcp_xr {
-	int valid;
-	int loss_rle_report;
-	unsigned int loss_rle_report_max_size;
-	int dup_rle_report;
-	unsigned int dup_rle_report_max_size;
-	int pkt_receipt_times_report;
-	unsigned int pkt_receipt_times_report_max_size;
-	enum sdp_rtcp_xr_rtt_report_mode rtt_report;
-	unsigned int rtt_report_max_size;
-	int stats_summary_report_loss;
-	int stats_summary_report_dup;
-	int stats_summary_report_jitter;
-	int stats_summary_report_ttl;
-	int stats_summary_report_hl;
-	int voip_metrics_report;
-	int djb_metrics_report;
+	/* Bitfield of SDP_RTCP_XR_REPORT_BIT() values */
+	uint16_t reports;
+	uint8_t valid;
+	/* Receiver reference time report mode, enum
+	 * sdp_rtcp_xr_rtt_report_mode; the SDP_RTCP_XR_REPORT_RTT report is
+	 * only written if the mode is not SDP_RTCP_XR_RTT_REPORT_NONE */
+	uint8_t rtt_report;
+	/* Maximum sizes of the reports, indexed by enum sdp_rtcp_xr_report;
+	 * 0 if unspecified */
+	uint32_t max_size[SDP_RTCP_XR_SIZED_REPORT_COUNT];
+};
+
+
+/* Session-level values inherited by a media (see struct sdp_media) */
+enum sdp_media_inherit {
+	SDP_MEDIA_INHERIT_CONNECTION_ADDR = (1 << 0),
+	SDP_MEDIA_INHERIT_START_MODE = (1 << 1),
+	SDP_MEDIA_INHERIT_RTCP_XR = (1 << 2),
 };
 
 
@@ -180,6 +261,9 @@ struct sdp_media {
 	unsigned int dst_stream_port;
 	unsigned int dst_control_port;
 	unsigned int payload_type;
+	/* Formats of the media line after payload_type, space-separated and
+	 * written back unchanged (SDP_READ_FLAG_RAW_LINES); NULL if none */
+	char *fmts;
 	char *control_url;
 	enum sdp_start_mode start_mode;
 	struct sdp_range range;
@@ -195,13 +279,29 @@ struct sdp_media {
 	/* RTCP extended reports */
 	struct sdp_rtcp_xr rtcp_xr;
 
+	/* Bitfield of enum sdp_media_inherit: values undefined at the media
+	 * level when reading a description, taken from the session level.
+	 * They are not copied: the media fields stay unset and the
+	 * sdp_media_get_*() accessors give the session values; a value set
+	 * later on the media is its own and is written */
+	unsigned int inherited;
+
 	unsigned int attr_count;
 	struct list_node attrs;
 
+	/* Unmodeled media-level lines, in source order (see
+	 * SDP_READ_FLAG_RAW_LINES for their position when writing) */
+	unsigned int raw_line_count;
+	struct list_node raw_lines;
+
 	struct list_node node;
 };
 
 
+/* Internal state of a session read with SDP_READ_FLAG_LAZY_MEDIA */
+struct sdp_lazy_media;
+
+
 struct sdp_session {
 	int deletion;
 	uint64_t session_id;
@@ -228,6 +328,22 @@ struct sdp_session {
 	struct list_node attrs;
 	unsigned int media_count;
 	struct list_node medias;
+
+	/* Unmodeled session-level lines, in source order; the t= lines
+	 * replace the default 't=0 0' when writing */
+	unsigned int raw_line_count;
+	struct list_node raw_lines;
+
+	/* Copy of the source text and index of its lines, kept when the
+	 * session is read with the SDP_READ_FLAG_LAZY_ATTRS or
+	 * SDP_READ_FLAG_LAZY_MEDIA flags */
+	char *text;
+	size_t text_len;
+	struct sdp_view *lines;
+	unsigned int line_count;
+
+	/* Media sections not built yet (SDP_READ_FLAG_LAZY_MEDIA) */
+	struct sdp_lazy_media *lazy_media;
 };
 
 
@@ -237,6 +353,9 @@ SDP_API struct sdp_session *sdp_session_new(void);
 SDP_API int sdp_session_destroy(struct sdp_session *session);
 
 
+/* The copy is not lazy: the media not built yet in a session read with
+ * SDP_READ_FLAG_LAZY_MEDIA are built in the copy (the source session is
+ * unchanged), and the lazy attributes are materialized */
 SDP_API int sdp_session_copy(const struct sdp_session *src,
 			     struct sdp_session *dst);
 
@@ -268,15 +387,99 @@ SDP_API int sdp_media_destroy(struct sdp_media *media);
 SDP_API int sdp_media_copy(const struct sdp_media *src, struct sdp_media *dst);
 
 
+/**
+ * Get the connection address of a media, or the session-level one if the
+ * media has none.
+ * @param media: media description object handle
+ * @param session: session description object handle of the media
+ * @param multicast: optional multicast flag of the address (output)
+ * @return the connection address, or NULL if there is none
+ */
+SDP_API const char *
+sdp_media_get_connection_addr(const struct sdp_media *media,
+			      const struct sdp_session *session,
+			      int *multicast);
+
+
+/**
+ * Get the start mode of a media, or the session-level one if the media
+ * has none.
+ * @param media: media description object handle
+ * @param session: session description object handle of the media
+ * @return the start mode, SDP_START_MODE_UNSPECIFIED if there is none
+ */
+SDP_API enum sdp_start_mode
+sdp_media_get_start_mode(const struct sdp_media *media,
+			 const struct sdp_session *session);
+
+
+/**
+ * Get the RTCP extended reports of a media, or the session-level ones if
+ * the media has none.
+ * @param media: media description object handle
+ * @param session: session description object handle of the media
+ * @return the RTCP extended reports, or NULL if there are none
+ */
+SDP_API const struct sdp_rtcp_xr *
+sdp_media_get_rtcp_xr(const struct sdp_media *media,
+		      const struct sdp_session *session);
+
+
 SDP_API struct sdp_attr *sdp_attr_new(void);
 
 
 SDP_API int sdp_attr_destroy(struct sdp_attr *attr);
 
 
+/* Lazy attributes are materialized in the destination attribute */
 SDP_API int sdp_attr_copy(const struct sdp_attr *src, struct sdp_attr *dst);
 
 
+/**
+ * Materialize a lazy attribute: its key and value become owned strings
+ * and it no longer depends on the source text of the session. This is a
+ * no-op if the attribute is not lazy.
+ * @param attr: attribute handle
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_attr_materialize(struct sdp_attr *attr);
+
+
+/**
+ * Materialize a lazy session: build all the media not built yet and turn
+ * all the lazy attributes of the session and its media into owned strings.
+ * @param session: session description object handle
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_session_materialize(struct sdp_session *session);
+
+
+/**
+ * Get the number of media of a session, including the media that are not
+ * built yet in a session read with the SDP_READ_FLAG_LAZY_MEDIA flag.
+ * @param session: session description object handle
+ * @return the number of media
+ */
+SDP_API unsigned int
+sdp_session_media_get_count(const struct sdp_session *session);
+
+
+/**
+ * Get a media of a session by its index in the description. In a session
+ * read with the SDP_READ_FLAG_LAZY_MEDIA flag, the media is parsed and
+ * built on the first call, and added to the medias list of the session.
+ * @param session: session description object handle
+ * @param idx: index of the media, from 0 to sdp_session_media_get_count()
+ *             excluded
+ * @param ret_obj: media handle (output)
+ * @return 0 on success, negative errno value in case of error
+ *         (-ENOENT if there is no media with this index)
+ */
+SDP_API int sdp_session_media_get(struct sdp_session *session,
+				  unsigned int idx,
+				  struct sdp_media **ret_obj);
+
+
 SDP_API int sdp_session_attr_add(struct sdp_session *session,
 				 struct sdp_attr **ret_obj);
 
@@ -289,6 +492,23 @@ SDP_API int sdp_session_attr_remove(struct sdp_session *session,
 				    struct sdp_attr *attr);
 
 
+/**
+ * Add an unmodeled line at the end of the session level, written after the
+ * connection data.
+ * @param session: session description object handle
+ * @param type: line type, e.g. 'b' or 't'
+ * @param value: line value, copied
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_session_raw_line_add(struct sdp_session *session,
+				     char type,
+				     const char *value);
+
+
+SDP_API int sdp_session_raw_line_remove(struct sdp_session *session,
+					struct sdp_raw_line *line);
+
+
 SDP_API int sdp_session_media_add(struct sdp_session *session,
 				  struct sdp_media **ret_obj);
 
@@ -313,14 +533,619 @@ SDP_API int sdp_media_attr_remove(struct sdp_media *media,
 				  struct sdp_attr *attr);
 
 
+/**
+ * Add an unmodeled line at the end of the media level, written after the
+ * connection data.
+ * @param media: media object handle
+ * @param type: line type, e.g. 'b' or 'k'
+ * @param value: line value, copied
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_media_raw_line_add(struct sdp_media *media,
+				   char type,
+				   const char *value);
+
+
+SDP_API int sdp_media_raw_line_remove(struct sdp_media *media,
+				      struct sdp_raw_line *line);
+
+
 SDP_API int sdp_description_read(const char *session_desc,
 				 struct sdp_session **ret_obj);
 
 
+/**
+ * Parse a session description from a length-delimited buffer.
+ * The buffer does not need to be null-terminated; it is neither copied nor
+ * modified. A null character within the buffer ends the description.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param ret_obj: session description object handle (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_read_n(const char *buf,
+				   size_t len,
+				   struct sdp_session **ret_obj);
+
+
+/* Parts of the session description that the reader can skip */
+enum sdp_read_skip {
+	/* Do not decode the H.264 sprop-parameter-sets (the sps and pps of
+	 * struct sdp_h264_fmtp are left empty) */
+	SDP_READ_SKIP_PARAM_SETS = (1 << 0),
+	/* Ignore the range attribute */
+	SDP_READ_SKIP_RANGE = (1 << 1),
+	/* Ignore the rtcp-xr attribute */
+	SDP_READ_SKIP_RTCP_XR = (1 << 2),
+	/* Do not store the generic attributes (attrs lists) */
+	SDP_READ_SKIP_ATTRS = (1 << 3),
+};
+
+
+enum sdp_read_flag {
+	/* The session keeps a copy of the source text and an index of its
+	 * lines; the generic attributes are not copied but are views into
+	 * the source text (see struct sdp_attr). The views are valid as long
+	 * as the session exists: an attribute must be materialized before
+	 * it is removed from the session and kept. Not supported by the
+	 * sdp_parser functions */
+	SDP_READ_FLAG_LAZY_ATTRS = (1 << 0),
+	/* The session keeps a copy of the source text and only the session
+	 * level is parsed; the media sections are located but their media
+	 * objects are built on first access by sdp_session_media_get(), in
+	 * the medias list of the session. Until then, the medias list and
+	 * media_count only hold the media built so far (see
+	 * sdp_session_media_get_count()), and the errors in a media section
+	 * are only reported when it is built. Adding or removing a media
+	 * builds all the media first, and the session is no longer lazy.
+	 * Not supported by the sdp_parser functions */
+	SDP_READ_FLAG_LAZY_MEDIA = (1 << 1),
+	/* The lines of types not modeled by the session and media objects
+	 * are kept in the raw_lines lists of their level, and the formats of
+	 * a media line after the first one in the fmts field of the media;
+	 * sdp_description_write() writes them back unchanged. The rtpmap and
+	 * fmtp attributes of these other formats are kept as raw a= lines
+	 * instead of failing the read. The writer keeps its own line order:
+	 * the raw lines of a level are in source order, but the raw a= lines
+	 * of a media come after its modeled attributes and its other raw
+	 * lines before them, whatever their order in the source text */
+	SDP_READ_FLAG_RAW_LINES = (1 << 2),
+};
+
+
+/* Bit of a media type in sdp_read_opts.skip_media_types */
+#define SDP_MEDIA_TYPE_BIT(_type) (1u << (_type))
+
+
+/* Resource limits of the reader, 0 for no limit; the read fails with
+ * -E2BIG as soon as a limit is exceeded. With SDP_READ_FLAG_LAZY_MEDIA,
+ * the attributes and memory of a media are checked when it is built */
+struct sdp_read_limits {
+	/* Size of the session description text in bytes */
+	size_t max_input_size;
+	/* Number of media sections, skipped ones included */
+	unsigned int max_media;
+	/* Number of attributes of the session level and of each media */
+	unsigned int max_attrs;
+	/* Decoded size of the parameter sets of an H.264 fmtp attribute */
+	size_t max_param_sets_size;
+	/* Memory of the session object in bytes, estimated from the objects
+	 * and the values of the lines read */
+	size_t max_heap_size;
+};
+
+
+struct sdp_read_opts {
+	/* Media sections to skip entirely, bitfield of
+	 * SDP_MEDIA_TYPE_BIT(type) values */
+	uint32_t skip_media_types;
+	/* Parts to skip, bitfield of enum sdp_read_skip values */
+	uint32_t skip;
+	/* Bitfield of enum sdp_read_flag values */
+	uint32_t flags;
+	/* Number of threads parsing the media sections, including the
+	 * calling thread; 0 or 1 parses the whole description on the calling
+	 * thread. Used by sdp_description_read_opts() only when the
+	 * description has enough media sections to benefit from it; used by
+	 * sdp_description_read_batch() to parse whole descriptions. The
+	 * number of threads is capped internally */
+	unsigned int threads;
+	/* Resource limits */
+	struct sdp_read_limits limits;
+	/* Typed attributes to decode (optional, can be NULL); the registry
+	 * is only used during the read, and until all media are built with
+	 * SDP_READ_FLAG_LAZY_MEDIA */
+	const struct sdp_attr_registry *registry;
+};
+
+
+/**
+ * Parse a session description from a length-delimited buffer, skipping
+ * the parts of the description that are not needed by the caller.
+ * Skipped media sections are not validated and do not appear in the
+ * session object.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param opts: read options (optional, can be NULL)
+ * @param ret_obj: session description object handle (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_read_opts(const char *buf,
+				      size_t len,
+				      const struct sdp_read_opts *opts,
+				      struct sdp_session **ret_obj);
+
+
+enum sdp_error_reason {
+	SDP_ERROR_REASON_NONE = 0,
+	/* Invalid value (number, payload type, attribute value...) */
+	SDP_ERROR_REASON_INVALID_VALUE,
+	/* Missing value (attribute key, encoding name, address...) */
+	SDP_ERROR_REASON_MISSING_VALUE,
+	/* Unsupported version, network type, address type, media type,
+	 * protocol, payload type or clock rate */
+	SDP_ERROR_REASON_UNSUPPORTED,
+	/* Payload type of an attribute different from the media one */
+	SDP_ERROR_REASON_PAYLOAD_TYPE_MISMATCH,
+	/* Media-level attribute at the session level */
+	SDP_ERROR_REASON_NOT_MEDIA_LEVEL,
+	/* Missing mandatory field */
+	SDP_ERROR_REASON_MISSING_FIELD,
+	/* Memory allocation failure */
+	SDP_ERROR_REASON_NO_MEMORY,
+	/* Resource limit exceeded (see struct sdp_read_limits) */
+	SDP_ERROR_REASON_LIMIT,
+
+	SDP_ERROR_REASON_MAX,
+};
+
+
+/* Position and reason of a session description parsing error */
+struct sdp_error {
+	/* Line number, starting at 1; 0 if the error is not related to a
+	 * line (missing mandatory field) */
+	unsigned int line;
+	/* Column in the line in bytes, starting at 1; 0 if the error is not
+	 * related to a line */
+	unsigned int column;
+	/* Type of the line ('v', 'o', 'm', 'a'...) or of the missing
+	 * mandatory field */
+	char type;
+	enum sdp_error_reason reason;
+};
+
+
+/**
+ * Parse a session description from a length-delimited buffer, like
+ * sdp_description_read_opts(), and give the position and reason of the
+ * error in case of failure. With the SDP_READ_FLAG_LAZY_MEDIA flag, the
+ * errors found when building a media later are not covered.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param opts: read options (optional, can be NULL)
+ * @param ret_obj: session description object handle (output)
+ * @param error: error details, only set in case of error (optional, can
+ *               be NULL)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_read_err(const char *buf,
+				     size_t len,
+				     const struct sdp_read_opts *opts,
+				     struct sdp_session **ret_obj,
+				     struct sdp_error *error);
+
+
+struct sdp_batch_item {
+	/* Session description text (input) */
+	const char *buf;
+	size_t len;
+	/* Session description object, NULL in case of error (output) */
+	struct sdp_session *session;
+	/* 0 on success, negative errno value in case of error (output) */
+	int status;
+};
+
+
+/**
+ * Parse a batch of independent session descriptions, sharing the work
+ * between opts->threads threads (the calling thread included). The threads
+ * take the next unparsed item of the array when they are done with one.
+ * The session objects of the items must be destroyed by the caller using
+ * sdp_session_destroy(), whatever the batch result.
+ * @param items: array of descriptions, the buf and len fields must be set
+ * @param count: number of items in the array
+ * @param opts: read options (optional, can be NULL)
+ * @return 0 on success (see the status field of each item for the result
+ *         of each description), negative errno value in case of error
+ */
+SDP_API int sdp_description_read_batch(struct sdp_batch_item *items,
+				       unsigned int count,
+				       const struct sdp_read_opts *opts);
+
+
+/**
+ * Split a buffer of concatenated session descriptions on the version
+ * lines ("v="). Each description spans from its version line up to the
+ * next one; the data before the first version line is ignored, and a null
+ * character ends the buffer. The descriptions are not copied, the buf
+ * and len fields of the items point into the input buffer. The array must
+ * be freed by the caller using free().
+ * @param buf: pointer to the session descriptions text
+ * @param len: length of the session descriptions text in bytes
+ * @param ret_items: array of items, NULL if empty (output)
+ * @param ret_count: number of items in the array (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_split(const char *buf,
+				  size_t len,
+				  struct sdp_batch_item **ret_items,
+				  unsigned int *ret_count);
+
+
+struct sdp_validation_report {
+	/* 0 if the session description is valid, negative errno value
+	 * otherwise */
+	int status;
+	/* Byte offset of the first invalid line or character, or length of
+	 * the description if the error is not tied to a line */
+	size_t offset;
+	/* Missing mandatory field types (e.g. "vc"), empty if none */
+	char missing[8];
+	/* Number of lines and media descriptions read */
+	unsigned int line_count;
+	unsigned int media_count;
+};
+
+
+/**
+ * Validate a session description without building a session object and
+ * without any memory allocation. The syntax of the lines, the mandatory
+ * fields, the network and address types, the media descriptions and the
+ * rtpmap and fmtp attributes are checked like sdp_description_read_n()
+ * does; additionally, the description must not contain control characters
+ * other than TAB, CR and LF before its end. H.264 parameter sets are not
+ * decoded.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param report: validation report (output, optional, can be NULL)
+ * @return 0 if the session description is valid, negative errno value
+ *         otherwise (-EPROTO for an invalid description)
+ */
+SDP_API int sdp_description_validate(const char *buf,
+				     size_t len,
+				     struct sdp_validation_report *report);
+
+
+/**
+ * Callback-driven reader: the session description is parsed line by line
+ * and each element is reported as an event, without building a session
+ * object nor allocating memory. Strings are reported as spans pointing
+ * inside the parsed text; they are not null-terminated and are only valid
+ * during the callback.
+ */
+
+/* Non-owning view on a part of the session description text */
+struct sdp_span {
+	const char *ptr;
+	size_t len;
+};
+
+
+/* Session or media-level description field */
+struct sdp_field {
+	/* Field type: 'o' (origin), 's' (session name), 'i' (session info or
+	 * media title), 'u' (URI), 'e' (email), 'p' (phone) or
+	 * 'c' (connection data) */
+	char type;
+	/* Field value; for 'o' the unicast address of the origin, for 'c'
+	 * the connection address without the TTL, for all others the text
+	 * after the '=' */
+	struct sdp_span value;
+	/* Origin only */
+	uint64_t session_id;
+	uint64_t session_version;
+	/* Connection data only */
+	int multicast;
+};
+
+
+/* All callbacks are optional; a negative errno value returned by a
+ * callback stops the parsing and is returned by the read function */
+struct sdp_read_cbs {
+	/* Session-level field; the URI, email and phone fields are always
+	 * reported at session level */
+	int (*on_session_field)(const struct sdp_field *field, void *userdata);
+
+	/* Start of a media description (m=); the following fields and
+	 * attributes are at media level */
+	int (*on_media_begin)(enum sdp_media_type type,
+			      unsigned int port,
+			      unsigned int payload_type,
+			      void *userdata);
+
+	/* Media-level field ('i' or 'c') */
+	int (*on_media_field)(const struct sdp_field *field, void *userdata);
+
+	/* Attribute (a=<key>[:<value>]), at session level before the first
+	 * on_media_begin() event and at media level afterwards; every
+	 * attribute is reported, including the ones that also have a
+	 * dedicated event, except the rtpmap and fmtp attributes reported
+	 * by on_raw_line() */
+	int (*on_attr)(struct sdp_span key,
+		       struct sdp_span value,
+		       void *userdata);
+
+	/* H.264 payload format parameters of the current media (a=fmtp when
+	 * the media encoding is H.264); the parameter sets point to decoded
+	 * data only valid during the callback */
+	int (*on_fmtp_h264)(const struct sdp_h264_fmtp *fmtp, void *userdata);
+
+	/* Line not modeled by the other events, at the same level as
+	 * on_attr(), only with the SDP_READ_FLAG_RAW_LINES flag: lines of
+	 * other types, the formats of the media line after the first one
+	 * (type 'm', right after on_media_begin()) and the rtpmap and fmtp
+	 * attributes not of the H.264 payload type (type 'a', whole
+	 * attribute text) */
+	int (*on_raw_line)(char type, struct sdp_span value, void *userdata);
+
+	/* End of a valid session description; deletion is 1 if only the
+	 * origin field is present */
+	int (*on_end)(int deletion, void *userdata);
+};
+
+
+/**
+ * Parse a session description from a length-delimited buffer and report
+ * its content through callbacks. The buffer does not need to be
+ * null-terminated; a null character within the buffer ends the description.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param cbs: reader callbacks
+ * @param userdata: user data passed to the callbacks
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_parse(const char *buf,
+				  size_t len,
+				  const struct sdp_read_cbs *cbs,
+				  void *userdata);
+
+
+/**
+ * Get the origin of a session description and whether it is a deletion
+ * description (origin field only, see sdp_description_write()) without
+ * parsing it nor allocating memory. Only the origin line is parsed, and
+ * the lines are only scanned up to the first other mandatory field found
+ * after it. The rest of the description is not validated: a full read
+ * may still fail.
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @param session_id: session id (output, optional, can be NULL)
+ * @param session_version: session version (output, optional, can be NULL)
+ * @param deletion: 1 for a deletion description, 0 otherwise (output,
+ *                  optional, can be NULL)
+ * @param server_addr: unicast address of the origin, pointing inside the
+ *                     buffer (output, optional, can be NULL)
+ * @return 0 on success, negative errno value in case of error (-EPROTO
+ *         if the origin line is missing or invalid)
+ */
+SDP_API int sdp_description_peek(const char *buf,
+				 size_t len,
+				 uint64_t *session_id,
+				 uint64_t *session_version,
+				 int *deletion,
+				 struct sdp_span *server_addr);
+
+
+/**
+ * Typed attributes: the value of the generic attributes of a registered
+ * key is decoded once when reading a description into an object of the
+ * application, kept in the data field of the attribute. The keys handled
+ * by the library (rtpmap, fmtp, control...) cannot be registered.
+ * With the threads read option, the functions can be called from several
+ * threads at once. The type must stay valid as long as attributes refer
+ * to it.
+ */
+struct sdp_attr_type {
+	/* Attribute key, without the 'a=' prefix */
+	const char *key;
+
+	/* Decode the value of an attribute (empty if the attribute has no
+	 * value) into a new object; a negative errno value fails the read
+	 * (mandatory) */
+	int (*parse)(const struct sdp_attr_type *type,
+		     struct sdp_span value,
+		     void **ret_data);
+
+	/* Write the value of an object like snprintf() does: at most 'size'
+	 * bytes including the null character ('buf' is NULL when 'size' is
+	 * 0), and return the length of the whole value or a negative errno
+	 * value; an empty value writes the attribute without value
+	 * (optional, the value string of the attribute is written if NULL) */
+	int (*write)(const struct sdp_attr_type *type,
+		     const void *data,
+		     char *buf,
+		     size_t size);
+
+	/* Copy an object (optional, the value of the attribute is decoded
+	 * again if NULL) */
+	int (*copy)(const struct sdp_attr_type *type,
+		    const void *data,
+		    void **ret_data);
+
+	/* Free an object (mandatory) */
+	void (*free)(const struct sdp_attr_type *type, void *data);
+
+	void *userdata;
+};
+
+
+struct sdp_attr_registry;
+
+
+SDP_API struct sdp_attr_registry *sdp_attr_registry_new(void);
+
+
+SDP_API int sdp_attr_registry_destroy(struct sdp_attr_registry *registry);
+
+
+/**
+ * Register a typed attribute.
+ * @param registry: registry handle
+ * @param type: attribute type, not copied
+ * @return 0 on success, negative errno value in case of error (-EEXIST if
+ *         the key is already registered or handled by the library)
+ */
+SDP_API int sdp_attr_registry_add(struct sdp_attr_registry *registry,
+				  const struct sdp_attr_type *type);
+
+
+/**
+ * Find the type registered for an attribute key.
+ * @param registry: registry handle
+ * @param key: attribute key
+ * @return the attribute type, or NULL if the key is not registered
+ */
+SDP_API const struct sdp_attr_type *
+sdp_attr_registry_find(const struct sdp_attr_registry *registry,
+		       const char *key);
+
+
+/**
+ * Incremental parser: the session description is fed in chunks of any size
+ * as they are received (e.g. RTSP DESCRIBE body or SAP payload); complete
+ * lines are parsed in place as soon as they are available, only an
+ * incomplete last line is kept by the parser until the next chunk.
+ * The parser can be reused for the next description after
+ * sdp_parser_finish().
+ */
+struct sdp_parser;
+
+
+SDP_API struct sdp_parser *sdp_parser_new(void);
+
+
+SDP_API int sdp_parser_destroy(struct sdp_parser *parser);
+
+
+/**
+ * Set the read options of the parser, used from the next description on
+ * (i.e. after the next sdp_parser_finish() call if a description is
+ * already being parsed).
+ * @param parser: parser handle
+ * @param opts: read options (optional, NULL to restore the defaults)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_parser_set_opts(struct sdp_parser *parser,
+				const struct sdp_read_opts *opts);
+
+
+/**
+ * Feed the parser with the next chunk of the session description.
+ * Once an error is returned, the following calls return the same error
+ * until sdp_parser_finish() is called.
+ * @param parser: parser handle
+ * @param buf: pointer to the chunk data
+ * @param len: chunk length in bytes
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_parser_feed(struct sdp_parser *parser,
+			    const char *buf,
+			    size_t len);
+
+
+/**
+ * Terminate the parsing of the session description and get the session
+ * object. The parser is reset and ready for a new description, whatever
+ * the result.
+ * @param parser: parser handle
+ * @param ret_obj: session description object handle (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_parser_finish(struct sdp_parser *parser,
+			      struct sdp_session **ret_obj);
+
+
+/**
+ * Parse a session description from a length-delimited buffer into an
+ * existing session object. The previous content of the session is
+ * replaced; its media, attribute and string allocations are reused for the
+ * new description when large enough, so that re-parsing a description of
+ * the same shape does not allocate any memory. The read options of the
+ * parser are used (the threads option and the SDP_READ_FLAG_LAZY_ATTRS flag
+ * are ignored). This function cannot be called while a description is
+ * being fed to the parser.
+ * In case of error the session content is unspecified, but the session
+ * can still be reused or destroyed using sdp_session_destroy().
+ * @param parser: parser handle
+ * @param session: session description object to fill
+ * @param buf: pointer to the session description text
+ * @param len: length of the session description text in bytes
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_read_into(struct sdp_parser *parser,
+				      struct sdp_session *session,
+				      const char *buf,
+				      size_t len);
+
+
 SDP_API int sdp_description_write(const struct sdp_session *session,
 				  char **ret_str);
 
 
+/**
+ * Get the length of the text that sdp_description_write() produces for a
+ * session description, without the null character. Nothing is allocated:
+ * the writer runs without storing its output, so the length is exact.
+ * @param session: session description object handle
+ * @param ret_len: pointer to the length (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_write_size(const struct sdp_session *session,
+				       size_t *ret_len);
+
+
+/**
+ * Write a session description into a buffer of the caller. The text is
+ * the same as sdp_description_write() and is null-terminated; nothing is
+ * allocated. The buffer must hold the length returned by
+ * sdp_description_write_size() plus the null character, otherwise
+ * -ENOBUFS is returned and the buffer content is unspecified.
+ * @param session: session description object handle
+ * @param buf: pointer to the buffer
+ * @param size: size of the buffer in bytes
+ * @param ret_len: optional pointer to the length of the text without the
+ *                 null character (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_write_buf(const struct sdp_session *session,
+				      char *buf,
+				      size_t size,
+				      size_t *ret_len);
+
+
+#ifndef _WIN32
+
+/**
+ * Write a session description as an array of chunks for writev() or
+ * sendmsg(). The chunks hold the text of sdp_description_write() without
+ * the null character. The long strings of the session (addresses, URLs,
+ * titles, encoding names, attribute values...) are referenced in place,
+ * the other chunks point to a scratch area allocated along with the array.
+ * The chunks are therefore only valid until the session is modified or
+ * destroyed. The number of chunks is not limited to IOV_MAX.
+ * The array must be freed by the caller using free().
+ * @param session: session description object handle
+ * @param ret_iov: pointer to the array of chunks (output)
+ * @param ret_iov_count: pointer to the number of chunks (output)
+ * @return 0 on success, negative errno value in case of error
+ */
+SDP_API int sdp_description_write_iov(const struct sdp_session *session,
+				      struct iovec **ret_iov,
+				      size_t *ret_iov_count);
+
+#endif /* !_WIN32 */
+
+
 SDP_API const char *sdp_media_type_str(enum sdp_media_type val);
 
 
@@ -331,9 +1156,15 @@ SDP_API const char *
 sdp_rtcp_xr_rtt_report_mode_str(enum sdp_rtcp_xr_rtt_report_mode val);
 
 
+SDP_API const char *sdp_rtcp_xr_report_str(enum sdp_rtcp_xr_report val);
+
+
 SDP_API const char *sdp_time_format_str(enum sdp_time_format val);
 
 
+SDP_API const char *sdp_error_reason_str(enum sdp_error_reason val);
+
+
 static inline int sdp_time_us_to_npt(uint64_t time_us,
 				     struct sdp_time_npt *time_npt)
 {
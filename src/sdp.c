@@ -50,21 +50,22 @@ const char *sdp_media_type_str(enum sdp_media_type val)
 }
 
 
-static int sdp_media_type_from_str(const char *str, enum sdp_media_type *type)
+static int sdp_media_type_from_str(struct sdp_span str,
+				   enum sdp_media_type *type)
 {
-	if (strcmp(str, "audio") == 0) {
+	if (sdp_span_eq(str, "audio")) {
 		*type = SDP_MEDIA_TYPE_AUDIO;
 		return 0;
-	} else if (strcmp(str, "video") == 0) {
+	} else if (sdp_span_eq(str, "video")) {
 		*type = SDP_MEDIA_TYPE_VIDEO;
 		return 0;
-	} else if (strcmp(str, "text") == 0) {
+	} else if (sdp_span_eq(str, "text")) {
 		*type = SDP_MEDIA_TYPE_TEXT;
 		return 0;
-	} else if (strcmp(str, "application") == 0) {
+	} else if (sdp_span_eq(str, "application")) {
 		*type = SDP_MEDIA_TYPE_APPLICATION;
 		return 0;
-	} else if (strcmp(str, "message") == 0) {
+	} else if (sdp_span_eq(str, "message")) {
 		*type = SDP_MEDIA_TYPE_MESSAGE;
 		return 0;
 	}
@@ -106,6 +107,68 @@ sdp_rtcp_xr_rtt_report_mode_str(enum sdp_rtcp_xr_rtt_report_mode val)
 }
 
 
+/* The report has a maximum size */
+#define SDP_RTCP_XR_FORMAT_SIZE (1 << 0)
+/* Receiver reference time report, with a mode */
+#define SDP_RTCP_XR_FORMAT_RTT (1 << 1)
+/* Flag of the stat-summary format */
+#define SDP_RTCP_XR_FORMAT_STAT (1 << 2)
+
+
+/* rtcp-xr formats by report (RFC 3611 ch. 5.1), used by both the reader
+ * and the writer */
+static const struct sdp_rtcp_xr_format {
+	const char *str;
+	size_t len;
+	uint32_t flags;
+} sdp_rtcp_xr_formats[SDP_RTCP_XR_REPORT_MAX] = {
+#define SDP_RTCP_XR_FORMAT(_report, _str, _flags)                              \
+	[_report] = {_str, sizeof(_str) - 1, _flags}
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_LOSS_RLE,
+			   SDP_ATTR_RTCP_XR_LOSS_RLE,
+			   SDP_RTCP_XR_FORMAT_SIZE),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_DUP_RLE,
+			   SDP_ATTR_RTCP_XR_DUP_RLE,
+			   SDP_RTCP_XR_FORMAT_SIZE),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_PKT_RECEIPT_TIMES,
+			   SDP_ATTR_RTCP_XR_RCPT_TIMES,
+			   SDP_RTCP_XR_FORMAT_SIZE),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_RTT,
+			   SDP_ATTR_RTCP_XR_RCVR_RTT,
+			   SDP_RTCP_XR_FORMAT_SIZE | SDP_RTCP_XR_FORMAT_RTT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_STATS_LOSS,
+			   SDP_ATTR_RTCP_XR_STAT_LOSS,
+			   SDP_RTCP_XR_FORMAT_STAT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_STATS_DUP,
+			   SDP_ATTR_RTCP_XR_STAT_DUP,
+			   SDP_RTCP_XR_FORMAT_STAT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_STATS_JITTER,
+			   SDP_ATTR_RTCP_XR_STAT_JITT,
+			   SDP_RTCP_XR_FORMAT_STAT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_STATS_TTL,
+			   SDP_ATTR_RTCP_XR_STAT_TTL,
+			   SDP_RTCP_XR_FORMAT_STAT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_STATS_HL,
+			   SDP_ATTR_RTCP_XR_STAT_HL,
+			   SDP_RTCP_XR_FORMAT_STAT),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_VOIP_METRICS,
+			   SDP_ATTR_RTCP_XR_VOIP_METRICS,
+			   0),
+	SDP_RTCP_XR_FORMAT(SDP_RTCP_XR_REPORT_DJB_METRICS,
+			   SDP_ATTR_RTCP_XR_DJB_METRICS,
+			   0),
+#undef SDP_RTCP_XR_FORMAT
+};
+
+
+const char *sdp_rtcp_xr_report_str(enum sdp_rtcp_xr_report val)
+{
+	if ((unsigned int)val >= SDP_RTCP_XR_REPORT_MAX)
+		return "unknown";
+	return sdp_rtcp_xr_formats[val].str;
+}
+
+
 const char *sdp_time_format_str(enum sdp_time_format val)
 {
 	switch (val) {
@@ -122,17 +185,153 @@ const char *sdp_time_format_str(enum sdp_time_format val)
 }
 
 
+const char *sdp_error_reason_str(enum sdp_error_reason val)
+{
+	switch (val) {
+	case SDP_ERROR_REASON_NONE:
+		return "none";
+	case SDP_ERROR_REASON_INVALID_VALUE:
+		return "invalid value";
+	case SDP_ERROR_REASON_MISSING_VALUE:
+		return "missing value";
+	case SDP_ERROR_REASON_UNSUPPORTED:
+		return "unsupported";
+	case SDP_ERROR_REASON_PAYLOAD_TYPE_MISMATCH:
+		return "payload type mismatch";
+	case SDP_ERROR_REASON_NOT_MEDIA_LEVEL:
+		return "not on media level";
+	case SDP_ERROR_REASON_MISSING_FIELD:
+		return "missing mandatory field";
+	case SDP_ERROR_REASON_NO_MEMORY:
+		return "no memory";
+	case SDP_ERROR_REASON_LIMIT:
+		return "limit exceeded";
+	default:
+		return "unknown";
+	}
+}
+
+
+/* Append a copy of a line to a list of raw lines */
+static int sdp_raw_line_add(struct list_node *raw_lines,
+			    unsigned int *count,
+			    char type,
+			    struct sdp_span value)
+{
+	struct sdp_raw_line *line = calloc(1, sizeof(*line));
+	ULOG_ERRNO_RETURN_ERR_IF(line == NULL, ENOMEM);
+
+	line->type = type;
+	line->value = malloc(value.len + 1);
+	if (line->value == NULL) {
+		free(line);
+		return -ENOMEM;
+	}
+	memcpy(line->value, value.ptr, value.len);
+	line->value[value.len] = '\0';
+
+	/* Add to the list */
+	list_add_after(list_last(raw_lines), &line->node);
+	(*count)++;
+
+	return 0;
+}
+
+
+static int sdp_raw_line_remove(struct list_node *raw_lines,
+			       unsigned int *count,
+			       struct sdp_raw_line *line)
+{
+	int found = 0;
+	struct sdp_raw_line *_line = NULL;
+
+	list_walk_entry_forward(raw_lines, _line, node)
+	{
+		if (_line == line) {
+			found = 1;
+			break;
+		}
+	}
+
+	if (!found) {
+		ULOGE("%s: failed to find the raw line in the list", __func__);
+		return -ENOENT;
+	}
+
+	/* Remove from the list */
+	list_del(&line->node);
+	(*count)--;
+
+	free(line->value);
+	free(line);
+
+	return 0;
+}
+
+
+static void sdp_raw_lines_clear(struct list_node *raw_lines,
+				unsigned int *count)
+{
+	struct sdp_raw_line *line = NULL, *tmp_line = NULL;
+
+	list_walk_entry_forward_safe(raw_lines, line, tmp_line, node)
+	{
+		list_del(&line->node);
+		free(line->value);
+		free(line);
+	}
+	*count = 0;
+}
+
+
+/* Copy the raw lines of a list at the end of another one */
+static int sdp_raw_lines_copy(const struct list_node *src,
+			      struct list_node *dst,
+			      unsigned int *count)
+{
+	int err;
+	struct sdp_raw_line *line = NULL;
+
+	list_walk_entry_forward(src, line, node)
+	{
+		err = sdp_raw_line_add(dst,
+				       count,
+				       line->type,
+				       sdp_span_make(line->value,
+						     strlen(line->value)));
+		if (err < 0)
+			return err;
+	}
+
+	return 0;
+}
+
+
 struct sdp_session *sdp_session_new(void)
 {
 	struct sdp_session *session = calloc(1, sizeof(*session));
 	ULOG_ERRNO_RETURN_VAL_IF(session == NULL, ENOMEM, NULL);
 	list_init(&session->attrs);
 	list_init(&session->medias);
+	list_init(&session->raw_lines);
 
 	return session;
 }
 
 
+/* Remove a media known to be in the medias list of the session, without
+ * building the media not built yet of a lazy session */
+static int sdp_session_media_unlink(struct sdp_session *session,
+				    struct sdp_media *media)
+{
+	/* Remove from the list */
+	list_del(&media->node);
+	session->media_count--;
+
+	return sdp_media_destroy(media);
+}
+
+
 int sdp_session_destroy(struct sdp_session *session)
 {
 	struct sdp_attr *attr = NULL, *tmp_attr = NULL;
@@ -150,9 +349,11 @@ int sdp_session_destroy(struct sdp_session *session)
 	/* Remove all media */
 	list_walk_entry_forward_safe(&session->medias, media, tmp_media, node)
 	{
-		sdp_session_media_remove(session, media);
+		sdp_session_media_unlink(session, media);
 	}
 
+	sdp_raw_lines_clear(&session->raw_lines, &session->raw_line_count);
+
 	free(session->server_addr);
 	free(session->session_name);
 	free(session->session_info);
@@ -164,16 +365,58 @@ int sdp_session_destroy(struct sdp_session *session)
 	free(session->charset);
 	free(session->connection_addr);
 	free(session->control_url);
+	sdp_lazy_media_destroy(session->lazy_media);
+	free(session->text);
+	free(session->lines);
 	free(session);
 
 	return 0;
 }
 
 
+static int sdp_session_media_copy(const struct sdp_media *src,
+				  struct sdp_session *dst_session)
+{
+	struct sdp_media *media;
+	int err;
+
+	err = sdp_session_media_add(dst_session, &media);
+	if (err < 0)
+		return err;
+	return sdp_media_copy(src, media);
+}
+
+
+/* Build in the copy the media from 'start' to 'end' (excluded) not built yet
+ * in a session read with SDP_READ_FLAG_LAZY_MEDIA */
+static int sdp_session_lazy_media_copy(const struct sdp_session *src,
+				       struct sdp_session *dst,
+				       unsigned int start,
+				       unsigned int end)
+{
+	struct sdp_media *media;
+	unsigned int i;
+	int err;
+
+	for (i = start; i < end; i++) {
+		if (src->lazy_media->medias[i] != NULL)
+			continue;
+		err = sdp_lazy_media_read(
+			src->lazy_media, src->text, i, dst, &media);
+		if (err < 0)
+			return err;
+	}
+
+	return 0;
+}
+
+
 int sdp_session_copy(const struct sdp_session *src, struct sdp_session *dst)
 {
 	struct sdp_attr *attr, *_attr = NULL;
-	struct sdp_media *media, *_media = NULL;
+	struct sdp_media *_media = NULL;
+	const struct sdp_lazy_media *lazy;
+	unsigned int i, next = 0;
 	int err;
 
 	ULOG_ERRNO_RETURN_ERR_IF(src == NULL, EINVAL);
@@ -208,18 +451,33 @@ int sdp_session_copy(const struct sdp_session *src, struct sdp_session *dst)
 	}
 	dst->attr_count = src->attr_count;
 
+	/* The media not built yet in a lazy session are built in the copy,
+	 * in the description order */
+	lazy = src->lazy_media;
 	list_walk_entry_forward(&src->medias, _media, node)
 	{
-		err = sdp_session_media_add(dst, &media);
+		for (i = next; (lazy != NULL) && (i < lazy->count); i++) {
+			if (lazy->medias[i] == _media)
+				break;
+		}
+		if ((lazy != NULL) && (i < lazy->count)) {
+			err = sdp_session_lazy_media_copy(src, dst, next, i);
+			if (err < 0)
+				return err;
+			next = i + 1;
+		}
+		err = sdp_session_media_copy(_media, dst);
 		if (err < 0)
 			return err;
-		err = sdp_media_copy(_media, media);
+	}
+	if (lazy != NULL) {
+		err = sdp_session_lazy_media_copy(src, dst, next, lazy->count);
 		if (err < 0)
 			return err;
 	}
-	dst->media_count = src->media_count;
 
-	return 0;
+	return sdp_raw_lines_copy(
+		&src->raw_lines, &dst->raw_lines, &dst->raw_line_count);
 }
 
 
@@ -301,6 +559,7 @@ struct sdp_media *sdp_media_new(void)
 	ULOG_ERRNO_RETURN_VAL_IF(media == NULL, ENOMEM, NULL);
 	list_node_unref(&media->node);
 	list_init(&media->attrs);
+	list_init(&media->raw_lines);
 
 	return media;
 }
@@ -321,8 +580,11 @@ int sdp_media_destroy(struct sdp_media *media)
 		sdp_media_attr_remove(media, attr);
 	}
 
+	sdp_raw_lines_clear(&media->raw_lines, &media->raw_line_count);
+
 	free(media->media_title);
 	free(media->connection_addr);
+	free(media->fmts);
 	free(media->control_url);
 	free(media->encoding_name);
 	free(media->encoding_params);
@@ -349,6 +611,7 @@ int sdp_media_copy(const struct sdp_media *src, struct sdp_media *dst)
 	dst->dst_stream_port = src->dst_stream_port;
 	dst->dst_control_port = src->dst_control_port;
 	dst->payload_type = src->payload_type;
+	dst->fmts = xstrdup(src->fmts);
 	dst->control_url = xstrdup(src->control_url);
 	dst->start_mode = src->start_mode;
 	dst->range = src->range;
@@ -377,7 +640,7 @@ int sdp_media_copy(const struct sdp_media *src, struct sdp_media *dst)
 		dst->h264_fmtp.pps_size = src->h264_fmtp.pps_size;
 	}
 	dst->rtcp_xr = src->rtcp_xr;
-
+	dst->inherited = src->inherited;
 
 	list_walk_entry_forward(&src->attrs, _attr, node)
 	{
@@ -390,10 +653,43 @@ int sdp_media_copy(const struct sdp_media *src, struct sdp_media *dst)
 	}
 	dst->attr_count = src->attr_count;
 
+	return sdp_raw_lines_copy(
+		&src->raw_lines, &dst->raw_lines, &dst->raw_line_count);
+}
+
+
+/* Decode the value of a typed attribute */
+static int sdp_attr_data_parse(struct sdp_attr *attr,
+			       const struct sdp_attr_type *type,
+			       struct sdp_span value)
+{
+	int ret;
+	void *data = NULL;
+
+	ret = type->parse(type, value, &data);
+	if (ret < 0) {
+		ULOGE("invalid '%s' attribute value '%.*s'",
+		      type->key,
+		      (int)value.len,
+		      value.ptr);
+		return ret;
+	}
+	attr->type = type;
+	attr->data = data;
+
 	return 0;
 }
 
 
+static void sdp_attr_data_free(struct sdp_attr *attr)
+{
+	if ((attr->type != NULL) && (attr->data != NULL))
+		attr->type->free(attr->type, attr->data);
+	attr->type = NULL;
+	attr->data = NULL;
+}
+
+
 struct sdp_attr *sdp_attr_new(void)
 {
 	struct sdp_attr *attr = calloc(1, sizeof(*attr));
@@ -411,6 +707,7 @@ int sdp_attr_destroy(struct sdp_attr *attr)
 
 	ULOG_ERRNO_RETURN_ERR_IF(list_node_is_ref(&attr->node), EBUSY);
 
+	sdp_attr_data_free(attr);
 	free(attr->key);
 	free(attr->value);
 	free(attr);
@@ -421,11 +718,91 @@ int sdp_attr_destroy(struct sdp_attr *attr)
 
 int sdp_attr_copy(const struct sdp_attr *src, struct sdp_attr *dst)
 {
+	int ret;
+
 	ULOG_ERRNO_RETURN_ERR_IF(src == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(dst == NULL, EINVAL);
 
-	dst->key = xstrdup(src->key);
-	dst->value = xstrdup(src->value);
+	if (src->text != NULL) {
+		dst->key = sdp_span_strdup(sdp_attr_key_span(src));
+		dst->value = sdp_span_strdup(sdp_attr_value_span(src));
+	} else {
+		dst->key = xstrdup(src->key);
+		dst->value = xstrdup(src->value);
+	}
+
+	/* Typed attribute: copy the object, or decode the value again */
+	if (src->type == NULL)
+		return 0;
+	if (src->type->copy == NULL) {
+		return sdp_attr_data_parse(
+			dst, src->type, sdp_attr_value_span(src));
+	}
+	ret = src->type->copy(src->type, src->data, &dst->data);
+	if (ret < 0)
+		return ret;
+	dst->type = src->type;
+
+	return 0;
+}
+
+
+int sdp_attr_materialize(struct sdp_attr *attr)
+{
+	char *key, *value;
+
+	ULOG_ERRNO_RETURN_ERR_IF(attr == NULL, EINVAL);
+
+	if (attr->text == NULL)
+		return 0;
+
+	key = sdp_span_strdup(sdp_attr_key_span(attr));
+	value = sdp_span_strdup(sdp_attr_value_span(attr));
+	if (((key == NULL) && (attr->key_view.len > 0)) ||
+	    ((value == NULL) && (attr->value_view.len > 0))) {
+		free(key);
+		free(value);
+		ULOG_ERRNO("sdp_span_strdup", ENOMEM);
+		return -ENOMEM;
+	}
+
+	attr->key = key;
+	attr->value = value;
+	attr->text = NULL;
+	memset(&attr->key_view, 0, sizeof(attr->key_view));
+	memset(&attr->value_view, 0, sizeof(attr->value_view));
+
+	return 0;
+}
+
+
+int sdp_session_materialize(struct sdp_session *session)
+{
+	int ret;
+	struct sdp_attr *attr = NULL;
+	struct sdp_media *media = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+
+	ret = sdp_lazy_media_finish(session);
+	if (ret < 0)
+		return ret;
+
+	list_walk_entry_forward(&session->attrs, attr, node)
+	{
+		ret = sdp_attr_materialize(attr);
+		if (ret < 0)
+			return ret;
+	}
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		list_walk_entry_forward(&media->attrs, attr, node)
+		{
+			ret = sdp_attr_materialize(attr);
+			if (ret < 0)
+				return ret;
+		}
+	}
 
 	return 0;
 }
@@ -498,20 +875,49 @@ int sdp_session_attr_remove(struct sdp_session *session, struct sdp_attr *attr)
 }
 
 
+int sdp_session_raw_line_add(struct sdp_session *session,
+			     char type,
+			     const char *value)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(value == NULL, EINVAL);
+
+	return sdp_raw_line_add(&session->raw_lines,
+				&session->raw_line_count,
+				type,
+				sdp_span_make(value, strlen(value)));
+}
+
+
+int sdp_session_raw_line_remove(struct sdp_session *session,
+				struct sdp_raw_line *line)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(line == NULL, EINVAL);
+
+	return sdp_raw_line_remove(
+		&session->raw_lines, &session->raw_line_count, line);
+}
+
+
 int sdp_session_media_add(struct sdp_session *session,
 			  struct sdp_media **ret_obj)
 {
+	int err;
 	struct sdp_media *media = NULL;
 
 	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
 
+	/* The media indexes of a lazy session must not change */
+	err = sdp_lazy_media_finish(session);
+	if (err < 0)
+		return err;
+
 	media = sdp_media_new();
 	ULOG_ERRNO_RETURN_ERR_IF(media == NULL, ENOMEM);
 
-	/* Add to the list */
-	list_add_after(list_last(&session->medias), &media->node);
-	session->media_count++;
+	sdp_session_media_append(session, media);
 
 	*ret_obj = media;
 	return 0;
@@ -521,15 +927,29 @@ int sdp_session_media_add(struct sdp_session *session,
 int sdp_session_media_add_existing(struct sdp_session *session,
 				   struct sdp_media *media)
 {
+	int err;
+
 	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(media == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(list_node_is_ref(&media->node), EBUSY);
 
+	/* The media indexes of a lazy session must not change */
+	err = sdp_lazy_media_finish(session);
+	if (err < 0)
+		return err;
+
+	sdp_session_media_append(session, media);
+
+	return 0;
+}
+
+
+void sdp_session_media_append(struct sdp_session *session,
+			      struct sdp_media *media)
+{
 	/* Add to the list */
 	list_add_after(list_last(&session->medias), &media->node);
 	session->media_count++;
-
-	return 0;
 }
 
 
@@ -555,11 +975,12 @@ int sdp_session_media_remove(struct sdp_session *session,
 		return -ENOENT;
 	}
 
-	/* Remove from the list */
-	list_del(&media->node);
-	session->media_count--;
+	/* The media indexes of a lazy session must not change */
+	err = sdp_lazy_media_finish(session);
+	if (err < 0)
+		return err;
 
-	err = sdp_media_destroy(media);
+	err = sdp_session_media_unlink(session, media);
 	if (err < 0)
 		return err;
 
@@ -567,6 +988,53 @@ int sdp_session_media_remove(struct sdp_session *session,
 }
 
 
+const char *sdp_media_get_connection_addr(const struct sdp_media *media,
+					  const struct sdp_session *session,
+					  int *multicast)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(media == NULL, EINVAL, NULL);
+	ULOG_ERRNO_RETURN_VAL_IF(session == NULL, EINVAL, NULL);
+
+	if (media->connection_addr != NULL) {
+		if (multicast != NULL)
+			*multicast = media->multicast;
+		return media->connection_addr;
+	}
+	if (multicast != NULL)
+		*multicast = session->multicast;
+	return session->connection_addr;
+}
+
+
+enum sdp_start_mode sdp_media_get_start_mode(const struct sdp_media *media,
+					     const struct sdp_session *session)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(
+		media == NULL, EINVAL, SDP_START_MODE_UNSPECIFIED);
+	ULOG_ERRNO_RETURN_VAL_IF(
+		session == NULL, EINVAL, SDP_START_MODE_UNSPECIFIED);
+
+	if (media->start_mode != SDP_START_MODE_UNSPECIFIED)
+		return media->start_mode;
+	return session->start_mode;
+}
+
+
+const struct sdp_rtcp_xr *
+sdp_media_get_rtcp_xr(const struct sdp_media *media,
+		      const struct sdp_session *session)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(media == NULL, EINVAL, NULL);
+	ULOG_ERRNO_RETURN_VAL_IF(session == NULL, EINVAL, NULL);
+
+	if (media->rtcp_xr.valid)
+		return &media->rtcp_xr;
+	if (session->rtcp_xr.valid)
+		return &session->rtcp_xr;
+	return NULL;
+}
+
+
 int sdp_media_attr_add(struct sdp_media *media, struct sdp_attr **ret_obj)
 {
 	struct sdp_attr *attr = NULL;
@@ -633,107 +1101,460 @@ int sdp_media_attr_remove(struct sdp_media *media, struct sdp_attr *attr)
 }
 
 
-static int sdp_time_write(const struct sdp_time *time, struct sdp_string *sdp)
+int sdp_media_raw_line_add(struct sdp_media *media,
+			   char type,
+			   const char *value)
 {
-	int ret;
+	ULOG_ERRNO_RETURN_ERR_IF(media == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(value == NULL, EINVAL);
 
-	switch (time->format) {
-	case SDP_TIME_FORMAT_NPT:
-		if (time->npt.now) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   SDP_TIME_NPT_NOW);
-		} else {
-			ULOG_ERRNO_RETURN_ERR_IF(time->npt.infinity, EINVAL);
-			uint64_t hrs, min;
-			uint64_t sec = time->npt.sec + time->npt.usec / 1000000;
-			hrs = sec / (60 * 60);
-			min = sec / 60 - hrs * 60;
-			sec = sec - min * 60 - hrs * 60 * 60;
-			float usec = (float)time->npt.usec / 1000000. -
-				     (time->npt.usec / 1000000);
-			char fraction[6];
-			snprintf(fraction, sizeof(fraction), "%.3f", usec);
-			if ((min > 0) || (hrs > 0)) {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   return ret,
-					   sdp,
-					   "%" PRIu64 ":%02" PRIu64
-					   ":%02" PRIu64 "%s",
-					   hrs,
-					   min,
-					   sec,
-					   (usec != 0.) ? fraction + 1 : "");
-			} else {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   return ret,
-					   sdp,
-					   "%" PRIu64 "%s",
-					   sec,
-					   (usec != 0.) ? fraction + 1 : "");
+	return sdp_raw_line_add(&media->raw_lines,
+				&media->raw_line_count,
+				type,
+				sdp_span_make(value, strlen(value)));
+}
+
+
+int sdp_media_raw_line_remove(struct sdp_media *media,
+			      struct sdp_raw_line *line)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(media == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(line == NULL, EINVAL);
+
+	return sdp_raw_line_remove(
+		&media->raw_lines, &media->raw_line_count, line);
+}
+
+
+/* Decimal fraction of a second: '.' and up to 6 digits, null-terminated */
+#define SDP_USEC_FRACTION_MAX_LEN 8
+
+
+/* Formats the microseconds as the shortest decimal fraction of a second of
+ * at least 'min_len' digits that reads back to the same value (e.g. 500000
+ * -> ".5", or ".500" with 3 digits at least), empty if 0 */
+static void sdp_usec_fraction(uint32_t usec, int min_len, char *str)
+{
+	int i, len = 6;
+
+	if (usec == 0) {
+		str[0] = '\0';
+		return;
+	}
+	while ((len > min_len) && ((usec % 10) == 0)) {
+		usec /= 10;
+		len--;
+	}
+	str[0] = '.';
+	for (i = len; i > 0; i--) {
+		str[i] = '0' + usec % 10;
+		usec /= 10;
+	}
+	str[len + 1] = '\0';
+}
+
+
+/* Parses "<seconds>[.<fraction>]"; fraction digits past the microsecond
+ * are ignored */
+static int sdp_span_to_sec_usec(struct sdp_span span,
+				uint64_t max_sec,
+				uint64_t *sec,
+				uint32_t *usec)
+{
+	int ret;
+	size_t i;
+	uint32_t frac = 0, scale = 1000000;
+
+	ret = sdp_span_parse_u64(span, max_sec, sec);
+	if (ret < 0)
+		return ret;
+	i = ret;
+	if ((i < span.len) && (span.ptr[i] == '.')) {
+		for (i++; i < span.len; i++) {
+			unsigned int d = (unsigned char)span.ptr[i] - '0';
+			if (d > 9)
+				return -EINVAL;
+			if (scale > 1) {
+				scale /= 10;
+				frac += d * scale;
 			}
 		}
-		break;
-	case SDP_TIME_FORMAT_SMPTE:
-	case SDP_TIME_FORMAT_ABSOLUTE:
-		/* TODO */
-		ULOGE("unsupported time format: %d", time->format);
-		return -ENOSYS;
-	default:
-		ULOGE("unknown time format: %d", time->format);
-		return -EINVAL;
 	}
-
+	if (i != span.len)
+		return -EINVAL;
+	*usec = frac;
 	return 0;
 }
 
 
-static int sdp_time_read(struct sdp_time *time, char *value)
+static const char *sdp_time_smpte_type_str(enum sdp_time_smpte_type type)
 {
-	char *s;
+	switch (type) {
+	case SDP_TIME_SMPTE_TYPE_30:
+		return SDP_TIME_SMPTE;
+	case SDP_TIME_SMPTE_TYPE_30_DROP:
+		return SDP_TIME_SMPTE_30_DROP;
+	case SDP_TIME_SMPTE_TYPE_25:
+		return SDP_TIME_SMPTE_25;
+	default:
+		return NULL;
+	}
+}
 
-	switch (time->format) {
-	case SDP_TIME_FORMAT_NPT:
-		s = strchr(value, ':');
-		if (s != NULL) {
+
+static unsigned int sdp_time_smpte_fps(enum sdp_time_smpte_type type)
+{
+	return (type == SDP_TIME_SMPTE_TYPE_25) ? 25 : 30;
+}
+
+
+static int sdp_time_is_infinity(const struct sdp_time *time)
+{
+	switch (time->format) {
+	case SDP_TIME_FORMAT_NPT:
+		return time->npt.infinity;
+	case SDP_TIME_FORMAT_SMPTE:
+		return time->smpte.infinity;
+	case SDP_TIME_FORMAT_ABSOLUTE:
+		return time->absolute.infinity;
+	default:
+		return 0;
+	}
+}
+
+
+static void sdp_time_set_infinity(struct sdp_time *time)
+{
+	switch (time->format) {
+	case SDP_TIME_FORMAT_NPT:
+		time->npt.infinity = 1;
+		break;
+	case SDP_TIME_FORMAT_SMPTE:
+		time->smpte.infinity = 1;
+		break;
+	case SDP_TIME_FORMAT_ABSOLUTE:
+		time->absolute.infinity = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+
+/* Days between 1970-01-01 and the given date of the proleptic Gregorian
+ * calendar (year >= 1970) and the reverse conversion, see
+ * http://howardhinnant.github.io/date_algorithms.html */
+static uint64_t sdp_days_from_civil(unsigned int y,
+				    unsigned int m,
+				    unsigned int d)
+{
+	uint64_t era, yoe, doy, doe;
+
+	y -= (m <= 2);
+	era = y / 400;
+	yoe = y - era * 400;
+	doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+
+static void sdp_civil_from_days(uint64_t days,
+				uint64_t *y,
+				unsigned int *m,
+				unsigned int *d)
+{
+	uint64_t z = days + 719468;
+	uint64_t era = z / 146097;
+	uint64_t doe = z - era * 146097;
+	uint64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint64_t mp = (5 * doy + 2) / 153;
+
+	*d = (unsigned int)(doy - (153 * mp + 2) / 5 + 1);
+	*m = (unsigned int)(mp < 10 ? mp + 3 : mp - 9);
+	*y = yoe + era * 400 + (*m <= 2);
+}
+
+
+static unsigned int sdp_days_in_month(unsigned int y, unsigned int m)
+{
+	static const uint8_t days[12] = {
+		31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	int leap = ((y % 4) == 0) && (((y % 100) != 0) || ((y % 400) == 0));
+
+	return days[m - 1] + ((m == 2) && leap);
+}
+
+
+/* Parses exactly 'n' decimal digits, returns -1 on a non-digit character */
+static int sdp_digits_read(const char *ptr, unsigned int n)
+{
+	int val = 0;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		unsigned int d = (unsigned char)ptr[i] - '0';
+		if (d > 9)
+			return -1;
+		val = val * 10 + d;
+	}
+	return val;
+}
+
+
+/* Absolute time: YYYYMMDDTHHMMSS[.fraction]Z (RFC 2326 chapter 3.7) */
+static int sdp_time_absolute_read(struct sdp_time_absolute *time,
+				  struct sdp_span value)
+{
+	int year, month, day, hrs, min;
+	uint64_t sec;
+	uint32_t usec;
+	const char *p = value.ptr;
+
+	if ((value.len < 16) || (p[8] != 'T') || (p[value.len - 1] != 'Z'))
+		return -EINVAL;
+	year = sdp_digits_read(p, 4);
+	month = sdp_digits_read(p + 4, 2);
+	day = sdp_digits_read(p + 6, 2);
+	hrs = sdp_digits_read(p + 9, 2);
+	min = sdp_digits_read(p + 11, 2);
+	if ((year < 1970) || (month < 1) || (month > 12) || (day < 1) ||
+	    (day > (int)sdp_days_in_month(year, month)) || (hrs < 0) ||
+	    (hrs > 23) || (min < 0) || (min > 59) ||
+	    (sdp_digits_read(p + 13, 2) < 0))
+		return -EINVAL;
+	if (sdp_span_to_sec_usec(sdp_span_make(p + 13, value.len - 14),
+				 59,
+				 &sec,
+				 &usec) < 0)
+		return -EINVAL;
+
+	time->sec = sdp_days_from_civil(year, month, day) * 24 * 60 * 60 +
+		    hrs * 60 * 60 + min * 60 + sec;
+	time->usec = usec;
+	return 0;
+}
+
+
+static int sdp_time_absolute_write(const struct sdp_time_absolute *time,
+				   struct sdp_string *sdp)
+{
+	uint64_t sec = time->sec + time->usec / 1000000;
+	uint64_t days = sec / (24 * 60 * 60);
+	unsigned int secs = (unsigned int)(sec % (24 * 60 * 60));
+	uint64_t year;
+	unsigned int month, day;
+	char fraction[SDP_USEC_FRACTION_MAX_LEN];
+
+	sdp_civil_from_days(days, &year, &month, &day);
+	ULOG_ERRNO_RETURN_ERR_IF(year > 9999, EINVAL);
+	sdp_usec_fraction(time->usec % 1000000, 0, fraction);
+
+	/* YYYYMMDDThhmmss[.fraction]Z */
+	sdp_emit_uint(sdp, year, 4);
+	sdp_emit_uint(sdp, month, 2);
+	sdp_emit_uint(sdp, day, 2);
+	sdp_emit_char(sdp, 'T');
+	sdp_emit_uint(sdp, secs / (60 * 60), 2);
+	sdp_emit_uint(sdp, (secs / 60) % 60, 2);
+	sdp_emit_uint(sdp, secs % 60, 2);
+	sdp_emit_str(sdp, fraction);
+	return sdp_emit_char(sdp, 'Z');
+}
+
+
+/* SMPTE time: hh:mm:ss[:frames[.subframes]], all fields being 1 or 2 digits
+ * (RFC 2326 chapter 3.5) */
+static int sdp_smpte_field_read(struct sdp_span field,
+				uint32_t max,
+				uint32_t *val)
+{
+	if ((field.len == 0) || (field.len > 2))
+		return -EINVAL;
+	return sdp_span_to_u32(field, max, val);
+}
+
+
+static int sdp_time_smpte_read(struct sdp_time_smpte *time,
+			       struct sdp_span value)
+{
+	struct sdp_span hh = value, mm, ss, ff = {0}, sf = {0};
+	uint32_t hrs, min, sec, frames = 0, subframes = 0;
+	unsigned int fps = sdp_time_smpte_fps(time->type);
+
+	mm = sdp_span_split(&hh, ':');
+	ss = sdp_span_split(&mm, ':');
+	if (sdp_span_has(ss, ':')) {
+		ff = sdp_span_split(&ss, ':');
+		if (sdp_span_has(ff, '.')) {
+			sf = sdp_span_split(&ff, '.');
+			if (sdp_smpte_field_read(sf, 99, &subframes) < 0)
+				return -EINVAL;
+		}
+		if (sdp_smpte_field_read(ff, fps - 1, &frames) < 0)
+			return -EINVAL;
+	}
+	if ((sdp_smpte_field_read(hh, 99, &hrs) < 0) ||
+	    (sdp_smpte_field_read(mm, 59, &min) < 0) ||
+	    (sdp_smpte_field_read(ss, 59, &sec) < 0))
+		return -EINVAL;
+
+	/* Drop frame: frames 0 and 1 are skipped at the start of each minute
+	 * except every tenth minute */
+	if ((time->type == SDP_TIME_SMPTE_TYPE_30_DROP) && (sec == 0) &&
+	    ((min % 10) != 0) && (frames < 2))
+		return -EINVAL;
+
+	time->sec = (uint64_t)hrs * 60 * 60 + min * 60 + sec;
+	time->frames = frames;
+	time->subframes = subframes;
+	return 0;
+}
+
+
+static int sdp_time_smpte_write(const struct sdp_time_smpte *time,
+				struct sdp_string *sdp)
+{
+	uint64_t hrs = time->sec / (60 * 60);
+	unsigned int min = (unsigned int)((time->sec / 60) % 60);
+	unsigned int sec = (unsigned int)(time->sec % 60);
+
+	ULOG_ERRNO_RETURN_ERR_IF(hrs > 99, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(time->frames >= sdp_time_smpte_fps(time->type),
+				 EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(time->subframes > 99, EINVAL);
+
+	sdp_emit_uint(sdp, hrs, 2);
+	sdp_emit_char(sdp, ':');
+	sdp_emit_uint(sdp, min, 2);
+	sdp_emit_char(sdp, ':');
+	sdp_emit_uint(sdp, sec, 2);
+	if ((time->frames > 0) || (time->subframes > 0)) {
+		sdp_emit_char(sdp, ':');
+		sdp_emit_uint(sdp, time->frames, 2);
+	}
+	if (time->subframes > 0) {
+		sdp_emit_char(sdp, '.');
+		sdp_emit_uint(sdp, time->subframes, 2);
+	}
+	return sdp->err;
+}
+
+
+static int sdp_time_write(const struct sdp_time *time, struct sdp_string *sdp)
+{
+	int ret;
+
+	switch (time->format) {
+	case SDP_TIME_FORMAT_NPT:
+		if (time->npt.now) {
+			ret = sdp_emit_lit(sdp, SDP_TIME_NPT_NOW);
+			if (ret < 0)
+				return ret;
+		} else {
+			ULOG_ERRNO_RETURN_ERR_IF(time->npt.infinity, EINVAL);
+			uint64_t hrs, min;
+			uint64_t sec = time->npt.sec + time->npt.usec / 1000000;
+			char fraction[SDP_USEC_FRACTION_MAX_LEN];
+			hrs = sec / (60 * 60);
+			min = sec / 60 - hrs * 60;
+			sec = sec - min * 60 - hrs * 60 * 60;
+			/* Milliseconds at least, as always written */
+			sdp_usec_fraction(
+				time->npt.usec % 1000000, 3, fraction);
+			if ((min > 0) || (hrs > 0)) {
+				sdp_emit_uint(sdp, hrs, 0);
+				sdp_emit_char(sdp, ':');
+				sdp_emit_uint(sdp, min, 2);
+				sdp_emit_char(sdp, ':');
+				sdp_emit_uint(sdp, sec, 2);
+			} else {
+				sdp_emit_uint(sdp, sec, 0);
+			}
+			ret = sdp_emit_str(sdp, fraction);
+			if (ret < 0)
+				return ret;
+		}
+		break;
+	case SDP_TIME_FORMAT_SMPTE:
+		ret = sdp_time_smpte_write(&time->smpte, sdp);
+		if (ret < 0)
+			return ret;
+		break;
+	case SDP_TIME_FORMAT_ABSOLUTE:
+		ret = sdp_time_absolute_write(&time->absolute, sdp);
+		if (ret < 0)
+			return ret;
+		break;
+	default:
+		ULOGE("unknown time format: %d", time->format);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+static int sdp_time_read(struct sdp_time *time, struct sdp_span value)
+{
+	switch (time->format) {
+	case SDP_TIME_FORMAT_NPT:
+		if (sdp_span_has(value, ':')) {
 			/* Hours, minutes, seconds */
-			char *hrs_str = value;
-			*s = '\0';
-			char *min_str = s + 1;
-			s = strchr(min_str, ':');
-			ULOG_ERRNO_RETURN_ERR_IF(s == NULL, EINVAL);
-			*s = '\0';
-			char *sec_str = s + 1;
-			unsigned int hrs = atoi(hrs_str);
-			unsigned int min = atoi(min_str);
-			float sec_f = atof(sec_str);
-			time->npt.sec = (uint64_t)sec_f;
-			time->npt.sec += min * 60 + hrs * 60 * 60;
-			time->npt.usec = (uint32_t)(
-				(sec_f - (float)((unsigned int)sec_f)) *
-				1000000);
+			struct sdp_span hrs_str = value;
+			struct sdp_span min_str = sdp_span_split(&hrs_str, ':');
+			ULOG_ERRNO_RETURN_ERR_IF(!sdp_span_has(min_str, ':'),
+						 EINVAL);
+			struct sdp_span sec_str = sdp_span_split(&min_str, ':');
+			uint32_t min;
+			uint64_t hrs, sec;
+			if ((sdp_span_to_u64(hrs_str,
+					     UINT64_MAX / (60 * 60) - 1,
+					     &hrs) < 0) ||
+			    (sdp_span_to_u32(min_str, 59, &min) < 0) ||
+			    (sdp_span_to_sec_usec(
+				     sec_str, 59, &sec, &time->npt.usec) < 0)) {
+				ULOGE("invalid NPT time '%.*s'",
+				      (int)value.len,
+				      value.ptr);
+				return -EINVAL;
+			}
+			time->npt.sec = sec + min * 60 + hrs * 60 * 60;
 		} else {
-			if (strcmp(value, SDP_TIME_NPT_NOW) == 0) {
+			if (sdp_span_eq(value, SDP_TIME_NPT_NOW)) {
 				/* now */
 				time->npt.now = 1;
 			} else {
 				/* seconds only */
-				float sec = atof(value);
-				time->npt.sec = (uint64_t)sec;
-				time->npt.usec = (uint32_t)(
-					(sec - (float)time->npt.sec) * 1000000);
+				if (sdp_span_to_sec_usec(value,
+							 UINT64_MAX,
+							 &time->npt.sec,
+							 &time->npt.usec) < 0) {
+					ULOGE("invalid NPT time '%.*s'",
+					      (int)value.len,
+					      value.ptr);
+					return -EINVAL;
+				}
 			}
 		}
 		break;
 	case SDP_TIME_FORMAT_SMPTE:
+		if (sdp_time_smpte_read(&time->smpte, value) < 0) {
+			ULOGE("invalid SMPTE time '%.*s'",
+			      (int)value.len,
+			      value.ptr);
+			return -EINVAL;
+		}
+		break;
 	case SDP_TIME_FORMAT_ABSOLUTE:
-		/* TODO */
-		ULOGE("unsupported time format: %d", time->format);
-		return -ENOSYS;
+		if (sdp_time_absolute_read(&time->absolute, value) < 0) {
+			ULOGE("invalid absolute time '%.*s'",
+			      (int)value.len,
+			      value.ptr);
+			return -EINVAL;
+		}
+		break;
 	default:
 		ULOGE("unknown time format: %d", time->format);
 		return -EINVAL;
@@ -747,121 +1568,134 @@ static int sdp_range_attr_write(const struct sdp_range *range,
 				struct sdp_string *sdp)
 {
 	int ret;
+	const char *format;
 
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%c=%s:",
-		   SDP_TYPE_ATTRIBUTE,
-		   SDP_ATTR_RANGE);
+	ULOG_ERRNO_RETURN_ERR_IF(range->start.format != range->stop.format,
+				 EINVAL);
 
 	switch (range->start.format) {
 	case SDP_TIME_FORMAT_NPT:
-		/* Start and stop cannot be both infinity */
-		ULOG_ERRNO_RETURN_ERR_IF(range->start.npt.infinity &&
-						 range->stop.npt.infinity,
-					 EINVAL);
 		/* 'now' makes no sense in SDP */
 		ULOG_ERRNO_RETURN_ERR_IF(range->start.npt.now, EINVAL);
 		ULOG_ERRNO_RETURN_ERR_IF(range->stop.npt.now, EINVAL);
-		CHECK_FUNC(sdp_sprintf, ret, return ret, sdp, SDP_TIME_NPT "=");
-		if (!range->start.npt.infinity) {
-			ret = sdp_time_write(&range->start, sdp);
-			if (ret < 0)
-				return ret;
-		}
-		CHECK_FUNC(sdp_sprintf, ret, return ret, sdp, "-");
-		if (!range->stop.npt.infinity) {
-			ret = sdp_time_write(&range->stop, sdp);
-			if (ret < 0)
-				return ret;
-		}
+		format = SDP_TIME_NPT;
 		break;
 	case SDP_TIME_FORMAT_SMPTE:
+		/* The start time is mandatory */
+		ULOG_ERRNO_RETURN_ERR_IF(range->start.smpte.infinity, EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(range->start.smpte.type !=
+						 range->stop.smpte.type,
+					 EINVAL);
+		format = sdp_time_smpte_type_str(range->start.smpte.type);
+		ULOG_ERRNO_RETURN_ERR_IF(format == NULL, EINVAL);
+		break;
 	case SDP_TIME_FORMAT_ABSOLUTE:
-		/* TODO */
-		ULOGE("unsupported time format: %d", range->start.format);
-		return -ENOSYS;
+		/* The start time is mandatory */
+		ULOG_ERRNO_RETURN_ERR_IF(range->start.absolute.infinity,
+					 EINVAL);
+		format = SDP_TIME_ABSOLUTE;
+		break;
 	default:
 		ULOGE("unknown time format: %d", range->start.format);
 		return -EINVAL;
 	}
 
-	CHECK_FUNC(sdp_sprintf, ret, return ret, sdp, SDP_CRLF);
+	/* Start and stop cannot be both infinity */
+	ULOG_ERRNO_RETURN_ERR_IF(sdp_time_is_infinity(&range->start) &&
+					 sdp_time_is_infinity(&range->stop),
+				 EINVAL);
+
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_lit(sdp, SDP_ATTR_RANGE ":");
+	sdp_emit_str(sdp, format);
+	sdp_emit_char(sdp, '=');
+	if (!sdp_time_is_infinity(&range->start)) {
+		ret = sdp_time_write(&range->start, sdp);
+		if (ret < 0)
+			return ret;
+	}
+	sdp_emit_char(sdp, '-');
+	if (!sdp_time_is_infinity(&range->stop)) {
+		ret = sdp_time_write(&range->stop, sdp);
+		if (ret < 0)
+			return ret;
+	}
+
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
 	return 0;
 }
 
 
-static int sdp_range_attr_read(struct sdp_range *range, char *value)
+static int sdp_range_attr_read(struct sdp_range *range, struct sdp_span value)
 {
 	int err;
-	char *s;
-	char *start_str = NULL, *stop_str = NULL;
+	struct sdp_span start_str, stop_str;
+	enum sdp_time_format format;
+	enum sdp_time_smpte_type smpte_type = SDP_TIME_SMPTE_TYPE_30;
 
 	memset(range, 0, sizeof(*range));
 
-	s = strchr(value, '=');
-	ULOG_ERRNO_RETURN_ERR_IF(s == NULL, EINVAL);
-
-	*s = '\0';
-	start_str = s + 1;
+	ULOG_ERRNO_RETURN_ERR_IF(!sdp_span_has(value, '='), EINVAL);
+	start_str = sdp_span_split(&value, '=');
 
-	s = strchr(start_str, '-');
-	ULOG_ERRNO_RETURN_ERR_IF(s == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(!sdp_span_has(start_str, '-'), EINVAL);
+	stop_str = sdp_span_split(&start_str, '-');
 
-	*s = '\0';
-	stop_str = s + 1;
-
-	if (strcmp(value, SDP_TIME_NPT) == 0) {
+	if (sdp_span_eq(value, SDP_TIME_NPT)) {
 		/* Normal Play Time (NPT) */
-		range->start.format = SDP_TIME_FORMAT_NPT;
-		range->stop.format = SDP_TIME_FORMAT_NPT;
-		if (strlen(start_str)) {
-			err = sdp_time_read(&range->start, start_str);
-			if (err < 0)
-				return -err;
-		} else {
-			range->start.npt.infinity = 1;
-		}
-		if (strlen(stop_str)) {
-			err = sdp_time_read(&range->stop, stop_str);
-			if (err < 0)
-				return -err;
-		} else {
-			range->stop.npt.infinity = 1;
-		}
-
-	} else if (strcmp(value, SDP_TIME_SMPTE) == 0) {
+		format = SDP_TIME_FORMAT_NPT;
+	} else if (sdp_span_eq(value, SDP_TIME_SMPTE)) {
 		/* SMPTE Relative Timestamps */
-		range->start.format = SDP_TIME_FORMAT_SMPTE;
-		range->stop.format = SDP_TIME_FORMAT_SMPTE;
-		/* TODO*/
-		ULOGE("unsupported time format: %s", value);
-		return -ENOSYS;
-
-	} else if (strcmp(value, SDP_TIME_ABSOLUTE) == 0) {
+		format = SDP_TIME_FORMAT_SMPTE;
+	} else if (sdp_span_eq(value, SDP_TIME_SMPTE_30_DROP)) {
+		format = SDP_TIME_FORMAT_SMPTE;
+		smpte_type = SDP_TIME_SMPTE_TYPE_30_DROP;
+	} else if (sdp_span_eq(value, SDP_TIME_SMPTE_25)) {
+		format = SDP_TIME_FORMAT_SMPTE;
+		smpte_type = SDP_TIME_SMPTE_TYPE_25;
+	} else if (sdp_span_eq(value, SDP_TIME_ABSOLUTE)) {
 		/* Absolute Time (UTC, ISO 8601) */
-		range->start.format = SDP_TIME_FORMAT_ABSOLUTE;
-		range->stop.format = SDP_TIME_FORMAT_ABSOLUTE;
-		/* TODO*/
-		ULOGE("unsupported time format: %s", value);
-		return -ENOSYS;
-
+		format = SDP_TIME_FORMAT_ABSOLUTE;
 	} else {
-		ULOGE("unknown time format: %s", value);
+		ULOGE("unknown time format: %.*s", (int)value.len, value.ptr);
 		return -EINVAL;
 	}
 
-	ULOG_ERRNO_RETURN_ERR_IF(range->start.format != range->stop.format,
-				 EINVAL);
+	range->start.format = format;
+	range->stop.format = format;
+	if (format == SDP_TIME_FORMAT_SMPTE) {
+		range->start.smpte.type = smpte_type;
+		range->stop.smpte.type = smpte_type;
+	} else if ((format != SDP_TIME_FORMAT_NPT) && (start_str.len == 0)) {
+		/* Only NPT ranges can have an open start */
+		ULOGE("missing range start time");
+		return -EINVAL;
+	}
+	if (start_str.len) {
+		err = sdp_time_read(&range->start, start_str);
+		if (err < 0)
+			return err;
+	} else {
+		sdp_time_set_infinity(&range->start);
+	}
+	if (stop_str.len) {
+		err = sdp_time_read(&range->stop, stop_str);
+		if (err < 0)
+			return err;
+	} else {
+		sdp_time_set_infinity(&range->stop);
+	}
+
 	/* Start and stop cannot be both infinity */
-	ULOG_ERRNO_RETURN_ERR_IF(
-		range->start.npt.infinity && range->stop.npt.infinity, EINVAL);
-	/* 'now' makes no sense in SDP */
-	ULOG_ERRNO_RETURN_ERR_IF(range->start.npt.now, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(range->stop.npt.now, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(sdp_time_is_infinity(&range->start) &&
+					 sdp_time_is_infinity(&range->stop),
+				 EINVAL);
+	if (format == SDP_TIME_FORMAT_NPT) {
+		/* 'now' makes no sense in SDP */
+		ULOG_ERRNO_RETURN_ERR_IF(range->start.npt.now, EINVAL);
+		ULOG_ERRNO_RETURN_ERR_IF(range->stop.npt.now, EINVAL);
+	}
 
 	return 0;
 }
@@ -875,34 +1709,22 @@ static int sdp_h264_fmtp_write(const struct sdp_h264_fmtp *fmtp,
 	char *sps_b64 = NULL;
 	char *pps_b64 = NULL;
 
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%c=%s:%d ",
-		   SDP_TYPE_ATTRIBUTE,
-		   SDP_ATTR_FMTP,
-		   payload_type);
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_lit(sdp, SDP_ATTR_FMTP ":");
+	sdp_emit_uint(sdp, payload_type, 0);
+	sdp_emit_char(sdp, ' ');
 
 	/* packetization-mode */
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%s=%d;",
-		   SDP_FMTP_H264_PACKETIZATION,
-		   fmtp->packetization_mode);
+	sdp_emit_lit(sdp, SDP_FMTP_H264_PACKETIZATION "=");
+	sdp_emit_uint(sdp, fmtp->packetization_mode, 0);
+	sdp_emit_char(sdp, ';');
 
 	/* profile-level-id */
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%s=%02X%02X%02X;",
-		   SDP_FMTP_H264_PROFILE_LEVEL,
-		   fmtp->profile_idc,
-		   fmtp->profile_iop,
-		   fmtp->level_idc);
+	sdp_emit_lit(sdp, SDP_FMTP_H264_PROFILE_LEVEL "=");
+	sdp_emit_hex8(sdp, fmtp->profile_idc);
+	sdp_emit_hex8(sdp, fmtp->profile_iop);
+	sdp_emit_hex8(sdp, fmtp->level_idc);
+	sdp_emit_char(sdp, ';');
 
 	/* sprop-parameter-sets */
 	if ((fmtp->sps) && (fmtp->sps_size) && (fmtp->pps) &&
@@ -915,17 +1737,14 @@ static int sdp_h264_fmtp_write(const struct sdp_h264_fmtp *fmtp,
 			(void *)fmtp->pps, (size_t)fmtp->pps_size, &pps_b64);
 		if (ret < 0)
 			goto out;
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto out,
-			   sdp,
-			   "%s=%s,%s;",
-			   SDP_FMTP_H264_PARAM_SETS,
-			   sps_b64,
-			   pps_b64);
+		sdp_emit_lit(sdp, SDP_FMTP_H264_PARAM_SETS "=");
+		sdp_emit_str(sdp, sps_b64);
+		sdp_emit_char(sdp, ',');
+		sdp_emit_str(sdp, pps_b64);
+		sdp_emit_char(sdp, ';');
 	}
 
-	CHECK_FUNC(sdp_sprintf, ret, goto out, sdp, SDP_CRLF);
+	CHECK_FUNC(sdp_emit_crlf, ret, goto out, sdp);
 
 out:
 	free(sps_b64);
@@ -934,72 +1753,56 @@ out:
 }
 
 
-/* NB: the data pointed by 'value' will be modified */
-static int sdp_h264_fmtp_read(struct sdp_h264_fmtp *fmtp, char *value)
+static int sdp_h264_fmtp_read(struct sdp_h264_fmtp *fmtp,
+			      struct sdp_span value,
+			      struct sdp_span *sps_b64,
+			      struct sdp_span *pps_b64)
 {
-	int ret;
-	char *temp1 = NULL;
-	char *param = NULL;
-	char *val = NULL;
+	struct sdp_span param, val;
+	uint64_t profile_level_id;
+	uint32_t packetization_mode;
 
 	fmtp->valid = 0;
-	param = strtok_r(value, ";", &temp1);
-	while (param) {
-		val = strchr(param, '=');
-		if (val != NULL) {
-			*val = '\0';
-			val++;
-		}
-		if ((strcmp(param, SDP_FMTP_H264_PROFILE_LEVEL) == 0) &&
-		    (val)) {
-			/* profile-level-id */
-			uint32_t profile_level_id = 0;
-			sscanf(val, "%6X", &profile_level_id);
+	for (param = sdp_span_tok(&value, ';'); param.len;
+	     param = sdp_span_tok(&value, ';')) {
+		int has_val = sdp_span_has(param, '=');
+		val = sdp_span_split(&param, '=');
+		if (sdp_span_eq(param, SDP_FMTP_H264_PROFILE_LEVEL) &&
+		    (has_val)) {
+			/* profile-level-id (3 bytes in hexadecimal) */
+			if ((sdp_span_parse_hex(
+				     val, 0xFFFFFF, &profile_level_id) != 6) ||
+			    (val.len != 6)) {
+				ULOGE("invalid profile-level-id '%.*s'",
+				      (int)val.len,
+				      val.ptr);
+				return -EPROTO;
+			}
 			fmtp->profile_idc = (profile_level_id >> 16) & 0xFF;
 			fmtp->profile_iop = (profile_level_id >> 8) & 0xFF;
 			fmtp->level_idc = profile_level_id & 0xFF;
 
-		} else if ((strcmp(param, SDP_FMTP_H264_PACKETIZATION) == 0) &&
-			   (val)) {
+		} else if (sdp_span_eq(param, SDP_FMTP_H264_PACKETIZATION) &&
+			   (has_val)) {
 			/* packetization-mode */
-			fmtp->packetization_mode = atoi(val);
-
-		} else if ((strcmp(param, SDP_FMTP_H264_PARAM_SETS) == 0) &&
-			   (val)) {
-			/* sprop-parameter-sets */
-			char *p3 = NULL;
-			p3 = strchr(val, ',');
-			if (p3 != NULL) {
-				*p3 = '\0';
-				char *sps_b64 = val;
-				char *pps_b64 = p3 + 1;
-				void *sps = NULL;
-				size_t sps_size = 0;
-				void *pps = NULL;
-				size_t pps_size = 0;
-				ret = sdp_base64_decode(
-					sps_b64, &sps, &sps_size);
-				if (ret < 0) {
-					free(sps);
-					free(pps);
-					return ret;
-				}
-				ret = sdp_base64_decode(
-					pps_b64, &pps, &pps_size);
-				if (ret < 0) {
-					free(sps);
-					free(pps);
-					return ret;
-				}
-				fmtp->sps = (uint8_t *)sps;
-				fmtp->sps_size = (unsigned int)sps_size;
-				fmtp->pps = (uint8_t *)pps;
-				fmtp->pps_size = (unsigned int)pps_size;
+			if (sdp_span_to_u32(
+				    val, UINT32_MAX, &packetization_mode) < 0) {
+				ULOGE("invalid packetization-mode '%.*s'",
+				      (int)val.len,
+				      val.ptr);
+				return -EPROTO;
+			}
+			fmtp->packetization_mode = packetization_mode;
+
+		} else if (sdp_span_eq(param, SDP_FMTP_H264_PARAM_SETS) &&
+			   (has_val)) {
+			/* sprop-parameter-sets, decoded by the caller */
+			if (sdp_span_has(val, ',')) {
+				*sps_b64 = val;
+				*pps_b64 = sdp_span_split(sps_b64, ',');
 			}
 		}
-
-		param = strtok_r(NULL, ";", &temp1);
-	};
+	}
 
 	fmtp->valid = 1;
 	return 0;
@@ -1009,511 +1812,294 @@ static int sdp_h264_fmtp_read(struct sdp_h264_fmtp *fmtp, char *value)
 static int sdp_rtcp_xr_attr_write(const struct sdp_rtcp_xr *xr,
 				  struct sdp_string *sdp)
 {
-	int ret, is_first = 1;
-
-	if ((!xr->loss_rle_report) && (!xr->dup_rle_report) &&
-	    (!xr->pkt_receipt_times_report) &&
-	    ((xr->rtt_report <= SDP_RTCP_XR_RTT_REPORT_NONE) ||
-	     (xr->rtt_report >= SDP_RTCP_XR_RTT_REPORT_MAX)) &&
-	    (!xr->stats_summary_report_loss) &&
-	    (!xr->stats_summary_report_dup) &&
-	    (!xr->stats_summary_report_jitter) &&
-	    (!xr->stats_summary_report_ttl) && (!xr->stats_summary_report_hl) &&
-	    (!xr->voip_metrics_report) && (!xr->djb_metrics_report)) {
+	int ret;
+	unsigned int i;
+	uint32_t reports = xr->reports;
+	const struct sdp_rtcp_xr_format *format;
+	const char *sep = "", *stat_sep = NULL;
+
+	if ((xr->rtt_report <= SDP_RTCP_XR_RTT_REPORT_NONE) ||
+	    (xr->rtt_report >= SDP_RTCP_XR_RTT_REPORT_MAX))
+		reports &= ~SDP_RTCP_XR_REPORT_BIT(SDP_RTCP_XR_REPORT_RTT);
+	if (reports == 0)
 		return 0;
+
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_lit(sdp, SDP_ATTR_RTCP_XR ":");
+
+	for (i = 0; i < SDP_RTCP_XR_REPORT_MAX; i++) {
+		if (!(reports & SDP_RTCP_XR_REPORT_BIT(i)))
+			continue;
+		format = &sdp_rtcp_xr_formats[i];
+
+		if (format->flags & SDP_RTCP_XR_FORMAT_STAT) {
+			/* stat-summary=<flag>[,<flag>...], the statistics
+			 * summary flags are contiguous */
+			if (stat_sep == NULL) {
+				sdp_emit_str(sdp, sep);
+				sdp_emit_lit(sdp,
+					     SDP_ATTR_RTCP_XR_STAT_SUMMARY "=");
+				stat_sep = "";
+			}
+			sdp_emit_str(sdp, stat_sep);
+			sdp_emit_str(sdp, format->str);
+			stat_sep = ",";
+			sep = " ";
+			continue;
+		}
+
+		/* <format>[=<mode>][=|:<max-size>] */
+		sdp_emit_str(sdp, sep);
+		sdp_emit_str(sdp, format->str);
+		if (format->flags & SDP_RTCP_XR_FORMAT_RTT) {
+			sdp_emit_char(sdp, '=');
+			sdp_emit_str(sdp,
+				     sdp_rtcp_xr_rtt_report_mode_str(
+					     xr->rtt_report));
+		}
+		if ((format->flags & SDP_RTCP_XR_FORMAT_SIZE) &&
+		    (xr->max_size[i] > 0)) {
+			sdp_emit_char(sdp,
+				      (format->flags & SDP_RTCP_XR_FORMAT_RTT)
+					      ? ':'
+					      : '=');
+			sdp_emit_uint(sdp, xr->max_size[i], 0);
+		}
+		sep = " ";
 	}
 
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%c=%s:",
-		   SDP_TYPE_ATTRIBUTE,
-		   SDP_ATTR_RTCP_XR);
-
-	/* pkt-loss-rle */
-	if (xr->loss_rle_report) {
-		/* No need to test is_first here since it has its init value */
-		if (xr->loss_rle_report_max_size > 0) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s=%d",
-				   SDP_ATTR_RTCP_XR_LOSS_RLE,
-				   xr->loss_rle_report_max_size);
-		} else {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s",
-				   SDP_ATTR_RTCP_XR_LOSS_RLE);
-		}
-		is_first = 0;
-	}
-
-	/* pkt-dup-rle */
-	if (xr->dup_rle_report) {
-		if (xr->dup_rle_report_max_size > 0) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s=%d",
-				   (is_first) ? "" : " ",
-				   SDP_ATTR_RTCP_XR_DUP_RLE,
-				   xr->dup_rle_report_max_size);
-		} else {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first) ? "" : " ",
-				   SDP_ATTR_RTCP_XR_DUP_RLE);
-		}
-		is_first = 0;
-	}
-
-	/* pkt-rcpt-times */
-	if (xr->pkt_receipt_times_report) {
-		if (xr->pkt_receipt_times_report_max_size > 0) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s=%d",
-				   (is_first) ? "" : " ",
-				   SDP_ATTR_RTCP_XR_RCPT_TIMES,
-				   xr->pkt_receipt_times_report_max_size);
-		} else {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first) ? "" : " ",
-				   SDP_ATTR_RTCP_XR_RCPT_TIMES);
-		}
-		is_first = 0;
-	}
-
-	/* rcvr-rtt */
-	if ((xr->rtt_report > SDP_RTCP_XR_RTT_REPORT_NONE) &&
-	    (xr->rtt_report < SDP_RTCP_XR_RTT_REPORT_MAX)) {
-		if (xr->loss_rle_report_max_size > 0) {
-			CHECK_FUNC(
-				sdp_sprintf,
-				ret,
-				return ret,
-				sdp,
-				"%s%s=%s:%d",
-				(is_first) ? "" : " ",
-				SDP_ATTR_RTCP_XR_RCVR_RTT,
-				sdp_rtcp_xr_rtt_report_mode_str(xr->rtt_report),
-				xr->loss_rle_report_max_size);
-		} else {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s=%s",
-				   (is_first) ? "" : " ",
-				   SDP_ATTR_RTCP_XR_RCVR_RTT,
-				   sdp_rtcp_xr_rtt_report_mode_str(
-					   xr->rtt_report));
-		}
-		is_first = 0;
-	}
-
-	/* stat-summary */
-	if ((xr->stats_summary_report_loss) || (xr->stats_summary_report_dup) ||
-	    (xr->stats_summary_report_jitter) ||
-	    (xr->stats_summary_report_ttl) || (xr->stats_summary_report_hl)) {
-		int is_first2 = 1;
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%s%s=",
-			   (is_first) ? "" : " ",
-			   SDP_ATTR_RTCP_XR_STAT_SUMMARY);
-		is_first = 0;
-		if (xr->stats_summary_report_loss) {
-			/* No need to test is_first2 here since it has its init
-			 * value */
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s",
-				   SDP_ATTR_RTCP_XR_STAT_LOSS);
-			is_first2 = 0;
-		}
-		if (xr->stats_summary_report_dup) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first2) ? "" : ",",
-				   SDP_ATTR_RTCP_XR_STAT_DUP);
-			is_first2 = 0;
-		}
-		if (xr->stats_summary_report_jitter) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first2) ? "" : ",",
-				   SDP_ATTR_RTCP_XR_STAT_JITT);
-			is_first2 = 0;
-		}
-		if (xr->stats_summary_report_ttl) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first2) ? "" : ",",
-				   SDP_ATTR_RTCP_XR_STAT_TTL);
-			is_first2 = 0;
-		}
-		if (xr->stats_summary_report_hl) {
-			CHECK_FUNC(sdp_sprintf,
-				   ret,
-				   return ret,
-				   sdp,
-				   "%s%s",
-				   (is_first2) ? "" : ",",
-				   SDP_ATTR_RTCP_XR_STAT_HL);
-			is_first2 = 0;
-		}
-	}
-
-	/* voip-metrics */
-	if (xr->voip_metrics_report) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%s%s",
-			   (is_first) ? "" : " ",
-			   SDP_ATTR_RTCP_XR_VOIP_METRICS);
-		is_first = 0;
-	}
-
-	/* de-jitter-buffer */
-	if (xr->djb_metrics_report) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%s%s",
-			   (is_first) ? "" : " ",
-			   SDP_ATTR_RTCP_XR_DJB_METRICS);
-		is_first = 0;
-	}
-
-	CHECK_FUNC(sdp_sprintf, ret, return ret, sdp, SDP_CRLF);
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
+
+	return 0;
+}
+
 
+static int sdp_rtcp_xr_size_read(struct sdp_span val, uint32_t *size)
+{
+	uint32_t v;
+
+	if (val.len == 0)
+		return 0;
+	if (sdp_span_to_u32(val, UINT32_MAX, &v) < 0) {
+		ULOGE("invalid rtcp-xr size '%.*s'", (int)val.len, val.ptr);
+		return -EPROTO;
+	}
+	*size = v;
 	return 0;
 }
 
 
-/* NB: the data pointed by 'value' will be modified */
-static int sdp_rtcp_xr_attr_read(struct sdp_rtcp_xr *xr, char *value)
+/* Report of a format or of a statistics summary flag ('stat' set), or
+ * SDP_RTCP_XR_REPORT_MAX if unknown */
+static unsigned int sdp_rtcp_xr_format_find(struct sdp_span str, int stat)
+{
+	unsigned int i;
+	const struct sdp_rtcp_xr_format *format;
+
+	for (i = 0; i < SDP_RTCP_XR_REPORT_MAX; i++) {
+		format = &sdp_rtcp_xr_formats[i];
+		if ((format->len == str.len) &&
+		    (((format->flags & SDP_RTCP_XR_FORMAT_STAT) != 0) ==
+		     (stat != 0)) &&
+		    (memcmp(format->str, str.ptr, str.len) == 0))
+			return i;
+	}
+	return SDP_RTCP_XR_REPORT_MAX;
+}
+
+
+static int sdp_rtcp_xr_attr_read(struct sdp_rtcp_xr *xr, struct sdp_span value)
 {
-	char *temp1 = NULL;
-	char *xr_format = NULL;
-	char *val = NULL;
+	int ret;
+	unsigned int report;
+	struct sdp_span xr_format, val, stat_flag, size;
 
 	xr->valid = 0;
-	for (xr_format = strtok_r(value, " ", &temp1); xr_format;
-	     xr_format = strtok_r(NULL, " ", &temp1)) {
-		val = strchr(xr_format, '=');
-		if (val != NULL) {
-			*val = '\0';
-			val++;
-		}
-		if (strcmp(xr_format, SDP_ATTR_RTCP_XR_LOSS_RLE) == 0) {
-			/* pkt-loss-rle */
-			xr->loss_rle_report = 1;
-			if (val != NULL)
-				xr->loss_rle_report_max_size = atoi(val);
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_DUP_RLE) == 0) {
-			/* pkt-dup-rle */
-			xr->dup_rle_report = 1;
-			if (val != NULL)
-				xr->dup_rle_report_max_size = atoi(val);
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_RCPT_TIMES) ==
-			   0) {
-			/* pkt-rcpt-times */
-			xr->pkt_receipt_times_report = 1;
-			if (val != NULL)
-				xr->pkt_receipt_times_report_max_size =
-					atoi(val);
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_RCVR_RTT) == 0) {
-			/* rcvr-rtt */
-			char *sz =
-				(val != NULL) ? strchr(xr_format, ':') : NULL;
-			if (sz != NULL) {
-				*sz = '\0';
-				sz++;
-				xr->rtt_report_max_size = atoi(sz);
+	for (xr_format = sdp_span_tok(&value, ' '); xr_format.len;
+	     xr_format = sdp_span_tok(&value, ' ')) {
+		val = sdp_span_split(&xr_format, '=');
+
+		if (sdp_span_eq(xr_format, SDP_ATTR_RTCP_XR_STAT_SUMMARY)) {
+			/* stat-summary=<flag>[,<flag>...] */
+			for (stat_flag = sdp_span_tok(&val, ','); stat_flag.len;
+			     stat_flag = sdp_span_tok(&val, ',')) {
+				report = sdp_rtcp_xr_format_find(stat_flag, 1);
+				if (report < SDP_RTCP_XR_REPORT_MAX)
+					xr->reports |=
+						SDP_RTCP_XR_REPORT_BIT(report);
 			}
-			if ((val != NULL) &&
-			    (strcmp(val, SDP_RTCP_XR_RTT_REPORT_ALL_STR) == 0))
+			continue;
+		}
+
+		report = sdp_rtcp_xr_format_find(xr_format, 0);
+		if (report >= SDP_RTCP_XR_REPORT_MAX)
+			continue;
+		if (sdp_rtcp_xr_formats[report].flags &
+		    SDP_RTCP_XR_FORMAT_RTT) {
+			/* rcvr-rtt=<mode>[:<max-size>] */
+			size = sdp_span_split(&val, ':');
+			if (sdp_span_eq(val, SDP_RTCP_XR_RTT_REPORT_ALL_STR))
 				xr->rtt_report = SDP_RTCP_XR_RTT_REPORT_ALL;
-			else if ((val != NULL) &&
-				 (strcmp(val,
-					 SDP_RTCP_XR_RTT_REPORT_SENDER_STR) ==
-				  0))
+			else if (sdp_span_eq(val,
+					     SDP_RTCP_XR_RTT_REPORT_SENDER_STR))
 				xr->rtt_report = SDP_RTCP_XR_RTT_REPORT_SENDER;
 			else
 				xr->rtt_report = SDP_RTCP_XR_RTT_REPORT_NONE;
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_STAT_SUMMARY) ==
-			   0) {
-			/* stat-summary */
-			if (val == NULL)
-				continue;
-			char *temp2 = NULL;
-			char *stat_flag = NULL;
-			stat_flag = strtok_r(val, ",", &temp2);
-			while (stat_flag) {
-				if (strcmp(stat_flag,
-					   SDP_ATTR_RTCP_XR_STAT_LOSS) == 0)
-					xr->stats_summary_report_loss = 1;
-				else if (strcmp(stat_flag,
-						SDP_ATTR_RTCP_XR_STAT_DUP) == 0)
-					xr->stats_summary_report_dup = 1;
-				else if (strcmp(stat_flag,
-						SDP_ATTR_RTCP_XR_STAT_JITT) ==
-					 0)
-					xr->stats_summary_report_jitter = 1;
-				else if (strcmp(stat_flag,
-						SDP_ATTR_RTCP_XR_STAT_TTL) == 0)
-					xr->stats_summary_report_ttl = 1;
-				else if (strcmp(stat_flag,
-						SDP_ATTR_RTCP_XR_STAT_HL) == 0)
-					xr->stats_summary_report_hl = 1;
-				stat_flag = strtok_r(NULL, ",", &temp2);
-			}
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_VOIP_METRICS) ==
-			   0) {
-			/* voip-metrics */
-			xr->voip_metrics_report = 1;
-
-		} else if (strcmp(xr_format, SDP_ATTR_RTCP_XR_DJB_METRICS) ==
-			   0) {
-			/* de-jitter-buffer */
-			xr->djb_metrics_report = 1;
+		} else {
+			/* <format>[=<max-size>] */
+			size = val;
 		}
-	};
+		if (sdp_rtcp_xr_formats[report].flags &
+		    SDP_RTCP_XR_FORMAT_SIZE) {
+			ret = sdp_rtcp_xr_size_read(size,
+						    &xr->max_size[report]);
+			if (ret < 0)
+				return ret;
+		}
+		xr->reports |= SDP_RTCP_XR_REPORT_BIT(report);
+	}
 
 	xr->valid = 1;
 	return 0;
 }
 
 
-/* NB: the data pointed by 'value' will be modified */
-static int sdp_attr_read(struct sdp_session *session,
-			 struct sdp_media *media,
-			 char *value,
-			 struct sdp_attr **out_attr)
+/* Multicast addresses are 224.0.0.0 to 239.255.255.255 */
+static int sdp_addr_is_multicast(struct sdp_span addr)
 {
-	int err;
-	char *temp2 = NULL;
-	struct sdp_attr *attr;
-	char *attr_key = strtok_r(value, ":", &temp2);
-	char *attr_value = strtok_r(NULL, "", &temp2);
-	*out_attr = NULL;
+	uint32_t addr_first = 0;
 
-	if (attr_key == NULL) {
-		ULOGE("no attribute key");
-		return -EPROTO;
-	}
+	if (sdp_span_parse_u32(addr, 255, &addr_first) < 0)
+		return 0;
+	return (addr_first >= SDP_MULTICAST_ADDR_MIN) &&
+	       (addr_first <= SDP_MULTICAST_ADDR_MAX);
+}
 
-	if ((strcmp(attr_key, SDP_ATTR_RTPAVP_RTPMAP) == 0) && (attr_value)) {
-		/* a=rtpmap */
-		if (media == NULL) {
-			ULOGE("attribute 'rtpmap' not on media level");
-			return -EPROTO;
-		}
-		char *temp3 = NULL;
-		char *payload_type = NULL;
-		char *encoding_name = NULL;
-		char *clock_rate = NULL;
-		char *encoding_params = NULL;
-		payload_type = strtok_r(attr_value, " ", &temp3);
-		unsigned int payload_type_int =
-			(payload_type) ? atoi(payload_type) : 0;
-		encoding_name = strtok_r(NULL, "/", &temp3);
-		clock_rate = strtok_r(NULL, "/", &temp3);
-		unsigned int i_clock_rate = (clock_rate) ? atoi(clock_rate) : 0;
-		encoding_params = strtok_r(NULL, "/", &temp3);
-		if (payload_type_int != media->payload_type) {
-			ULOGE("invalid payload type (%d vs. %d)",
-			      payload_type_int,
-			      media->payload_type);
-			return -EPROTO;
-		}
-		if (encoding_name == NULL) {
-			ULOGE("encoding name is missing");
-			return -EPROTO;
-		}
-		/* Clock rate must be 90000 for H.264
-		 * (RFC6184 ch. 8.2.1) */
-		if ((strcmp(encoding_name, SDP_ENCODING_H264) == 0) &&
-		    (i_clock_rate != SDP_H264_CLOCKRATE)) {
-			ULOGE("unsupported clock rate %d", i_clock_rate);
-			return -EPROTO;
-		}
-		media->encoding_name = strdup(encoding_name);
-		media->encoding_params = xstrdup(encoding_params);
-		media->clock_rate = i_clock_rate;
-		ULOGD("SDP: payload_type=%d"
-		      " encoding_name=%s clock_rate=%d"
-		      " encoding_params=%s",
-		      payload_type_int,
-		      encoding_name,
-		      i_clock_rate,
-		      encoding_params);
 
-	} else if ((strcmp(attr_key, SDP_ATTR_FMTP) == 0) && (attr_value)) {
-		/* a=fmtp */
-		if (media == NULL) {
-			ULOGE("attribute 'fmtp' not on media level");
-			return -EPROTO;
-		}
-		char *temp3 = NULL;
-		char *payload_type = NULL;
-		char *fmtp = NULL;
-		payload_type = strtok_r(attr_value, " ", &temp3);
-		unsigned int payload_type_int =
-			(payload_type) ? atoi(payload_type) : 0;
+/* Line with a string value, <type>=<value> */
+static int sdp_line_write(char type, const char *value, struct sdp_string *sdp)
+{
+	int ret;
 
-		if (payload_type_int != media->payload_type) {
-			ULOGE("invalid payload type (%d vs. %d)",
-			      payload_type_int,
-			      media->payload_type);
-			return -EPROTO;
-		}
+	sdp_emit_type(sdp, type);
+	sdp_emit_ref_str(sdp, value);
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
-		if ((media->encoding_name) &&
-		    (strcmp(media->encoding_name, SDP_ENCODING_H264) == 0)) {
-			fmtp = strtok_r(NULL, "", &temp3);
-			if (fmtp == NULL) {
-				ULOGE("missing H264 format");
-				return -EPROTO;
-			}
-			err = sdp_h264_fmtp_read(&media->h264_fmtp, fmtp);
-			if (err < 0)
-				return err;
-		}
+	return 0;
+}
 
-	} else if (strcmp(attr_key, SDP_ATTR_TOOL) == 0) {
-		/* a=tool */
-		if (media)
-			ULOGW("attribute 'tool' not on session level");
-		else
-			session->tool = xstrdup(attr_value);
-	} else if (strcmp(attr_key, SDP_ATTR_TYPE) == 0) {
-		/* a=type */
-		if (media)
-			ULOGW("attribute 'type' not on session level");
-		else
-			session->type = xstrdup(attr_value);
-	} else if (strcmp(attr_key, SDP_ATTR_CHARSET) == 0) {
-		/* a=charset */
-		if (media)
-			ULOGW("attribute 'charset' not on session level");
-		else
-			session->charset = xstrdup(attr_value);
-	} else if (strcmp(attr_key, SDP_ATTR_CONTROL_URL) == 0) {
-		/* a=control */
-		if (media)
-			media->control_url = xstrdup(attr_value);
-		else
-			session->control_url = xstrdup(attr_value);
-	} else if ((strcmp(attr_key, SDP_ATTR_RANGE) == 0) && (attr_value)) {
-		/* a=range */
-		if (media)
-			err = sdp_range_attr_read(&media->range, attr_value);
-		else
-			err = sdp_range_attr_read(&session->range, attr_value);
-		if (err < 0)
-			return err;
 
-	} else if (strcmp(attr_key, SDP_ATTR_RECVONLY) == 0) {
-		/* a=recvonly */
-		if (media)
-			media->start_mode = SDP_START_MODE_RECVONLY;
-		else
-			session->start_mode = SDP_START_MODE_RECVONLY;
+/* Attribute with a string value, a=<attribute>:<value> */
+static int sdp_attr_line_write(const char *key,
+			       const char *value,
+			       struct sdp_string *sdp)
+{
+	int ret;
 
-	} else if (strcmp(attr_key, SDP_ATTR_SENDRECV) == 0) {
-		/* a=sendrecv */
-		if (media)
-			media->start_mode = SDP_START_MODE_SENDRECV;
-		else
-			session->start_mode = SDP_START_MODE_SENDRECV;
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_str(sdp, key);
+	sdp_emit_char(sdp, ':');
+	sdp_emit_ref_str(sdp, value);
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
-	} else if (strcmp(attr_key, SDP_ATTR_SENDONLY) == 0) {
-		/* a=sendonly */
-		if (media)
-			media->start_mode = SDP_START_MODE_SENDONLY;
-		else
-			session->start_mode = SDP_START_MODE_SENDONLY;
+	return 0;
+}
 
-	} else if (strcmp(attr_key, SDP_ATTR_INACTIVE) == 0) {
-		/* a=inactive */
-		if (media)
-			media->start_mode = SDP_START_MODE_INACTIVE;
-		else
-			session->start_mode = SDP_START_MODE_INACTIVE;
 
-	} else if ((strcmp(attr_key, SDP_ATTR_RTCP_XR) == 0) && (attr_value)) {
-		/* a=rtcp-xr */
-		if (media) {
-			err = sdp_rtcp_xr_attr_read(&media->rtcp_xr,
-						    attr_value);
-		} else {
-			err = sdp_rtcp_xr_attr_read(&session->rtcp_xr,
-						    attr_value);
-		}
+/* Value of a typed attribute written by its type after
+ * a=<attribute>: */
+static int sdp_attr_data_write(const struct sdp_attr *attr,
+			       struct sdp_span key,
+			       struct sdp_string *sdp)
+{
+	int ret, err;
+	size_t available = 0;
+	char *buf = NULL;
+
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	ret = sdp_emit_span(sdp, key);
+	if (ret < 0)
+		return ret;
+
+	/* The value is written after room for the ':' separator, which is
+	 * only added for a non-empty value */
+	if (sdp->str != NULL) {
+		available = sdp->max_len - sdp->len - 1;
+		buf = (available > 0) ? sdp->str + sdp->len + 1 : NULL;
+	}
+	ret = attr->type->write(attr->type, attr->data, buf, available);
+	if (ret < 0)
+		return ret;
+	if ((sdp->str != NULL) && ((size_t)ret >= available)) {
+		err = sdp_string_reserve(sdp, (size_t)ret + 1);
 		if (err < 0)
 			return err;
-
-	} else if ((strcmp(attr_key, SDP_ATTR_RTCP_PORT) == 0) &&
-		   (attr_value)) {
-		/* a=rtcp */
-		if (media == NULL) {
-			ULOGE("attribute 'rtcp' not on media level");
-			return -EPROTO;
-		}
-		int port = atoi(attr_value);
-		if (port > 0) {
-			media->dst_control_port = port;
-			ULOGD("SDP: rtcp_dst_port=%d", port);
-		}
-	} else {
-		/* No special case, create an sdp_attr for the key/value pair */
-		attr = sdp_attr_new();
-		if (attr == NULL) {
-			ULOGE("new SDP attribute creation failed");
-			return -ENOMEM;
+		available = sdp->max_len - sdp->len - 1;
+		ret = attr->type->write(attr->type,
+					attr->data,
+					sdp->str + sdp->len + 1,
+					available);
+		if (ret < 0)
+			return ret;
+		if ((size_t)ret >= available) {
+			sdp->err = -ENOBUFS;
+			return sdp->err;
 		}
-		attr->key = xstrdup(attr_key);
-		attr->value = xstrdup(attr_value);
-		*out_attr = attr;
+	}
+	if (ret > 0) {
+		if (sdp->str != NULL)
+			sdp->str[sdp->len] = ':';
+		sdp_string_commit(sdp, (size_t)ret + 1);
+	}
+
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
+
+	return 0;
+}
+
+
+/* Generic attribute, a=<attribute>:<value> or a=<attribute> */
+static int sdp_attr_write(const struct sdp_attr *attr, struct sdp_string *sdp)
+{
+	int ret;
+	struct sdp_span key = sdp_attr_key_span(attr);
+	struct sdp_span value = sdp_attr_value_span(attr);
+
+	if (key.len == 0)
+		return 0;
+
+	if ((attr->type != NULL) && (attr->type->write != NULL))
+		return sdp_attr_data_write(attr, key, sdp);
+
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_span(sdp, key);
+	if (value.len > 0) {
+		sdp_emit_char(sdp, ':');
+		sdp_emit_ref_span(sdp, value);
+	}
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
+
+	return 0;
+}
+
+
+/* Raw lines of a list written as is (<type>=<value>), only the ones of
+ * the given type, or all the other ones if 'others' is set */
+static int sdp_raw_lines_write(const struct list_node *raw_lines,
+			       char type,
+			       int others,
+			       struct sdp_string *sdp)
+{
+	int ret;
+	struct sdp_raw_line *line = NULL;
+
+	list_walk_entry_forward(raw_lines, line, node)
+	{
+		if ((line->type == type) == (others != 0))
+			continue;
+		ret = sdp_line_write(line->type, line->value, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	return 0;
@@ -1545,66 +2131,61 @@ static int sdp_media_write(const struct sdp_media *media,
 	}
 
 	/* Media description (m=<media> <port> <proto> <fmt> ...) */
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   return ret,
-		   sdp,
-		   "%c=%s %d " SDP_PROTO_RTPAVP " %d" SDP_CRLF,
-		   SDP_TYPE_MEDIA,
-		   sdp_media_type_str(media->type),
-		   media->dst_stream_port,
-		   media->payload_type);
+	sdp_emit_type(sdp, SDP_TYPE_MEDIA);
+	sdp_emit_str(sdp, sdp_media_type_str(media->type));
+	sdp_emit_char(sdp, ' ');
+	sdp_emit_uint(sdp, media->dst_stream_port, 0);
+	sdp_emit_lit(sdp, " " SDP_PROTO_RTPAVP " ");
+	sdp_emit_uint(sdp, media->payload_type, 0);
+	if (media->fmts != NULL) {
+		sdp_emit_char(sdp, ' ');
+		sdp_emit_ref_str(sdp, media->fmts);
+	}
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
 	/* Media title (i=<media title>) */
 	if ((media->media_title) && (*media->media_title != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_INFORMATION,
-			   media->media_title);
+		ret = sdp_line_write(
+			SDP_TYPE_INFORMATION, media->media_title, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Connection data (c=<nettype> <addrtype> <connection-address>) */
 	if ((media->connection_addr) && (*media->connection_addr != '\0')) {
-		int multicast = 0;
-		int addr_first = atoi(media->connection_addr);
-		if ((addr_first >= SDP_MULTICAST_ADDR_MIN) &&
-		    (addr_first <= SDP_MULTICAST_ADDR_MAX))
-			multicast = 1;
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%c=IN IP4 %s%s" SDP_CRLF,
-			   SDP_TYPE_CONNECTION,
-			   media->connection_addr,
-			   (multicast) ? "/127" : "");
+		int multicast = sdp_addr_is_multicast(
+			sdp_span_make(media->connection_addr,
+				      strlen(media->connection_addr)));
+		sdp_emit_type(sdp, SDP_TYPE_CONNECTION);
+		sdp_emit_lit(sdp, "IN IP4 ");
+		sdp_emit_ref_str(sdp, media->connection_addr);
+		if (multicast)
+			sdp_emit_lit(sdp, "/127");
+		CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 	}
 
+	/* Unmodeled lines (b=, k=, ...), the attributes excepted */
+	ret = sdp_raw_lines_write(
+		&media->raw_lines, SDP_TYPE_ATTRIBUTE, 1, sdp);
+	if (ret < 0)
+		return ret;
+
 	/* Start mode (a=<start_mode>) */
 	if ((media->start_mode > SDP_START_MODE_UNSPECIFIED) &&
 	    (media->start_mode < SDP_START_MODE_MAX)) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   sdp_start_mode_str(media->start_mode));
+		ret = sdp_line_write(SDP_TYPE_ATTRIBUTE,
+				     sdp_start_mode_str(media->start_mode),
+				     sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Control URL for use with RTSP (a=control) */
 	if ((media->control_url) && (*media->control_url != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%c=%s:%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_CONTROL_URL,
-			   media->control_url);
+		ret = sdp_attr_line_write(
+			SDP_ATTR_CONTROL_URL, media->control_url, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Range (a=range) */
@@ -1615,23 +2196,18 @@ static int sdp_media_write(const struct sdp_media *media,
 	}
 
 	/* RTP/AVP rtpmap attribute (a=rtpmap) */
-	CHECK_FUNC(
-		sdp_sprintf,
-		ret,
-		return ret,
-		sdp,
-		"%c=%s:%d %s/%d%s%s" SDP_CRLF,
-		SDP_TYPE_ATTRIBUTE,
-		SDP_ATTR_RTPAVP_RTPMAP,
-		media->payload_type,
-		media->encoding_name,
-		media->clock_rate,
-		((media->encoding_params) && (*media->encoding_params != '\0'))
-			? "/"
-			: "",
-		((media->encoding_params) && (*media->encoding_params != '\0'))
-			? media->encoding_params
-			: "");
+	sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+	sdp_emit_lit(sdp, SDP_ATTR_RTPAVP_RTPMAP ":");
+	sdp_emit_uint(sdp, media->payload_type, 0);
+	sdp_emit_char(sdp, ' ');
+	sdp_emit_ref_str(sdp, media->encoding_name);
+	sdp_emit_char(sdp, '/');
+	sdp_emit_uint(sdp, media->clock_rate, 0);
+	if ((media->encoding_params) && (*media->encoding_params != '\0')) {
+		sdp_emit_char(sdp, '/');
+		sdp_emit_ref_str(sdp, media->encoding_params);
+	}
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
 	/* H.264 payload format parameters (a=fmtp) */
 	if ((strcmp(media->encoding_name, SDP_ENCODING_H264) == 0) &&
@@ -1645,14 +2221,10 @@ static int sdp_media_write(const struct sdp_media *media,
 	/* RTCP destination port (if not RTP port + 1) (a=rtcp) */
 	if ((media->dst_stream_port != 0) &&
 	    (media->dst_control_port != media->dst_stream_port + 1)) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   return ret,
-			   sdp,
-			   "%c=%s:%d" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_RTCP_PORT,
-			   media->dst_control_port);
+		sdp_emit_type(sdp, SDP_TYPE_ATTRIBUTE);
+		sdp_emit_lit(sdp, SDP_ATTR_RTCP_PORT ":");
+		sdp_emit_uint(sdp, media->dst_control_port, 0);
+		CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 	}
 
 	/* RTCP extended reports attribute (a=rtcp-xr) */
@@ -1662,103 +2234,234 @@ static int sdp_media_write(const struct sdp_media *media,
 			return ret;
 	}
 
+	/* Unmodeled attributes (rtpmap and fmtp of the other formats), after
+	 * the modeled ones of the first format */
+	ret = sdp_raw_lines_write(
+		&media->raw_lines, SDP_TYPE_ATTRIBUTE, 0, sdp);
+	if (ret < 0)
+		return ret;
+
 	/* Other attributes (a=<attribute>:<value> or a=<attribute>) */
 	struct sdp_attr *attr = NULL;
 	list_walk_entry_forward(&media->attrs, attr, node)
 	{
-		if ((attr->key) && (*attr->key != '\0')) {
-			if ((attr->value) && (*attr->value != '\0')) {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   return ret,
-					   sdp,
-					   "%c=%s:%s" SDP_CRLF,
-					   SDP_TYPE_ATTRIBUTE,
-					   attr->key,
-					   attr->value);
-			} else {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   return ret,
-					   sdp,
-					   "%c=%s" SDP_CRLF,
-					   SDP_TYPE_ATTRIBUTE,
-					   attr->key);
-			}
-		}
+		ret = sdp_attr_write(attr, sdp);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+
+/* Record the first error of the reader at a position of the current
+ * line; the line itself is recorded by sdp_reader_line_error() */
+static int sdp_reader_error(struct sdp_reader *reader,
+			    enum sdp_error_reason reason,
+			    const char *pos)
+{
+	if (reader->err.reason == SDP_ERROR_REASON_NONE) {
+		reader->err.reason = reason;
+		reader->err.pos = pos;
+	}
+	return -EPROTO;
+}
+
+
+static int sdp_reader_limit(struct sdp_reader *reader, const char *pos)
+{
+	sdp_reader_error(reader, SDP_ERROR_REASON_LIMIT, pos);
+	return -E2BIG;
+}
+
+
+int sdp_reader_alloc(struct sdp_reader *reader, size_t size, const char *pos)
+{
+	size_t max = reader->opts.limits.max_heap_size;
+
+	reader->heap_size += size;
+	if ((max != 0) && (reader->heap_size > max)) {
+		ULOGE("session object memory limit exceeded (%zu bytes)", max);
+		return sdp_reader_limit(reader, pos);
 	}
+	return 0;
+}
+
 
+int sdp_reader_media_count(struct sdp_reader *reader, struct sdp_span line)
+{
+	unsigned int max = reader->opts.limits.max_media;
+
+	/* The attributes are counted per level */
+	reader->media_count++;
+	reader->attr_count = 0;
+	if ((max != 0) && (reader->media_count > max)) {
+		ULOGE("too many media (max %u)", max);
+		return sdp_reader_limit(reader, line.ptr);
+	}
 	return 0;
 }
 
 
-/* NB: the data pointed by 'value' will be modified */
-static int sdp_media_read(struct sdp_media *media, char *value)
+int sdp_reader_line_error(struct sdp_reader *reader,
+			  struct sdp_span line,
+			  int ret)
+{
+	if (reader->err.line != NULL)
+		return ret;
+
+	if (reader->err.reason == SDP_ERROR_REASON_NONE) {
+		reader->err.reason = (ret == -ENOMEM)
+					     ? SDP_ERROR_REASON_NO_MEMORY
+					     : SDP_ERROR_REASON_INVALID_VALUE;
+		reader->err.pos = line.ptr + 2;
+	}
+	reader->err.type = line.ptr[0];
+	reader->err.line = line.ptr;
+	return ret;
+}
+
+
+static void sdp_reader_error_locate(const struct sdp_reader_error *err,
+				    const char *buf,
+				    int status,
+				    struct sdp_error *error)
+{
+	const char *p;
+
+	memset(error, 0, sizeof(*error));
+	error->type = err->type;
+	error->reason = err->reason;
+	if (error->reason == SDP_ERROR_REASON_NONE) {
+		/* Error outside of the reader */
+		error->reason = (status == -ENOMEM)
+					? SDP_ERROR_REASON_NO_MEMORY
+					: SDP_ERROR_REASON_INVALID_VALUE;
+	}
+	if (err->line == NULL)
+		return;
+
+	/* Lines end with CRLF, LF or CR (see sdp_scanner_next_line()) */
+	error->line = 1;
+	for (p = buf; p < err->line; p++) {
+		if ((*p == '\n') || ((*p == '\r') && (p[1] != '\n')))
+			error->line++;
+	}
+	if (err->pos != NULL)
+		error->column = err->pos - err->line + 1;
+}
+
+
+static int sdp_media_read(struct sdp_reader *reader,
+			  struct sdp_span value,
+			  enum sdp_media_type *type,
+			  unsigned int *port,
+			  unsigned int *payload_type,
+			  struct sdp_span *fmts)
 {
-	char *temp2 = NULL;
-	char *smedia = strtok_r(value, " ", &temp2);
-	char *port = strtok_r(NULL, " ", &temp2);
-	char *proto = strtok_r(NULL, " ", &temp2);
-	char *fmt = strtok_r(NULL, " ", &temp2);
-	if (smedia) {
-		int res = sdp_media_type_from_str(smedia, &media->type);
+	struct sdp_span smedia = sdp_span_tok(&value, ' ');
+	struct sdp_span sport = sdp_span_tok(&value, ' ');
+	struct sdp_span proto = sdp_span_tok(&value, ' ');
+	struct sdp_span fmt = sdp_span_tok(&value, ' ');
+	if (smedia.len) {
+		int res = sdp_media_type_from_str(smedia, type);
 		if (res < 0) {
-			ULOGE("unsupported media type '%s'", smedia);
-			return -EPROTO;
+			ULOGE("unsupported media type '%.*s'",
+			      (int)smedia.len,
+			      smedia.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						smedia.ptr);
 		}
 	} else {
 		ULOGE("null media type");
-		return -EPROTO;
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_MISSING_VALUE, smedia.ptr);
 	}
-	int port_int = (port) ? atoi(port) : 0;
-	if (port_int) {
-		media->dst_stream_port = port_int;
-		media->dst_control_port = port_int + 1;
-	} else {
-		media->dst_control_port = 0;
+	/* <port>[/<number of ports>] */
+	if (sdp_span_parse_u32(sport, UINT16_MAX, port) < 0) {
+		ULOGE("invalid port '%.*s'", (int)sport.len, sport.ptr);
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_INVALID_VALUE, sport.ptr);
 	}
-	if ((proto == NULL) || (strcmp(proto, SDP_PROTO_RTPAVP) != 0)) {
-		ULOGE("unsupported protocol '%s'", (proto) ? proto : "");
-		return -EPROTO;
+	if (!sdp_span_eq(proto, SDP_PROTO_RTPAVP)) {
+		ULOGE("unsupported protocol '%.*s'", (int)proto.len, proto.ptr);
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_UNSUPPORTED, proto.ptr);
+	}
+	if (sdp_span_to_u32(fmt, UINT32_MAX, payload_type) < 0) {
+		ULOGE("invalid payload type '%.*s'", (int)fmt.len, fmt.ptr);
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_INVALID_VALUE, fmt.ptr);
 	}
-	media->payload_type = (fmt) ? atoi(fmt) : 0;
 	/* Payload type must be dynamic
 	 * (RFC3551 ch. 6) */
-	if ((media->payload_type < SDP_DYNAMIC_PAYLOAD_TYPE_MIN) ||
-	    (media->payload_type > SDP_DYNAMIC_PAYLOAD_TYPE_MAX)) {
-		ULOGE("unsupported payload type (%d)", media->payload_type);
-		return -EPROTO;
+	if ((*payload_type < SDP_DYNAMIC_PAYLOAD_TYPE_MIN) ||
+	    (*payload_type > SDP_DYNAMIC_PAYLOAD_TYPE_MAX)) {
+		ULOGE("unsupported payload type (%d)", *payload_type);
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_UNSUPPORTED, fmt.ptr);
 	}
+	if (fmts != NULL)
+		*fmts = value;
 
-	ULOGD("SDP: media=%s port=%d proto=%s payload_type=%d",
-	      smedia,
-	      port_int,
-	      proto,
-	      media->payload_type);
+	ULOGD("SDP: media=%.*s port=%d proto=%.*s payload_type=%d",
+	      (int)smedia.len,
+	      smedia.ptr,
+	      *port,
+	      (int)proto.len,
+	      proto.ptr,
+	      *payload_type);
 
 	return 0;
 }
 
 
-int sdp_description_write(const struct sdp_session *session, char **ret_str)
+/* Origin (o=<username> <sess-id> <sess-version>
+ * <nettype> <addrtype> <unicast-address>) */
+static int sdp_origin_write(const struct sdp_session *session,
+			    struct sdp_string *sdp)
+{
+	int ret;
+
+	sdp_emit_type(sdp, SDP_TYPE_ORIGIN);
+	sdp_emit_lit(sdp, "- ");
+	sdp_emit_uint(sdp, session->session_id, 0);
+	sdp_emit_char(sdp, ' ');
+	sdp_emit_uint(sdp, session->session_version, 0);
+	sdp_emit_lit(sdp, " IN IP4 ");
+	sdp_emit_ref_str(sdp, session->server_addr);
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
+
+	return 0;
+}
+
+
+static int sdp_session_write(const struct sdp_session *session,
+			     struct sdp_string *sdp)
 {
 	int ret;
 	int session_level_connection_addr = 0;
-	struct sdp_string sdp;
+	int timing;
+	unsigned int i;
 	struct sdp_attr *attr = NULL;
 	struct sdp_media *media = NULL;
-
-	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	struct sdp_raw_line *raw_line = NULL;
 
 	if ((!session->server_addr) || (*session->server_addr == '\0')) {
 		ULOGE("invalid server address");
 		return -EINVAL;
 	}
 
-	sdp.str = malloc(SDP_DEFAULT_LEN);
-	ULOG_ERRNO_RETURN_ERR_IF(sdp.str == NULL, ENOMEM);
-	sdp.len = 0;
-	sdp.max_len = SDP_DEFAULT_LEN;
+	if (session->lazy_media != NULL) {
+		for (i = 0; i < session->lazy_media->count; i++) {
+			if (session->lazy_media->medias[i] != NULL)
+				continue;
+			ULOGE("not all media are built, "
+			      "see sdp_session_materialize()");
+			return -EBUSY;
+		}
+	}
 
 	/**
 	 * SDP deletion is a custom and non standard way to signal a session
@@ -1769,552 +2472,2303 @@ int sdp_description_write(const struct sdp_session *session, char **ret_str)
 	if (session->deletion) {
 		/* Origin (o=<username> <sess-id> <sess-version>
 		 * <nettype> <addrtype> <unicast-address>) */
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=- %" PRIu64 " %" PRIu64 " IN IP4 %s" SDP_CRLF,
-			   SDP_TYPE_ORIGIN,
-			   session->session_id,
-			   session->session_version,
-			   session->server_addr);
-
-		*ret_str = sdp.str;
-		return 0;
+		return sdp_origin_write(session, sdp);
 	}
 
 	/* Protocol version (v=0) */
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   goto error,
-		   &sdp,
-		   "%c=%d" SDP_CRLF,
-		   SDP_TYPE_VERSION,
-		   SDP_VERSION);
+	sdp_emit_type(sdp, SDP_TYPE_VERSION);
+	sdp_emit_uint(sdp, SDP_VERSION, 0);
+	CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
 
 	/* Origin (o=<username> <sess-id> <sess-version>
 	 * <nettype> <addrtype> <unicast-address>) */
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   goto error,
-		   &sdp,
-		   "%c=- %" PRIu64 " %" PRIu64 " IN IP4 %s" SDP_CRLF,
-		   SDP_TYPE_ORIGIN,
-		   session->session_id,
-		   session->session_version,
-		   session->server_addr);
+	ret = sdp_origin_write(session, sdp);
+	if (ret < 0)
+		return ret;
 
 	/* Session name (s=<session name>) */
 	if ((session->session_name) && (*session->session_name != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_SESSION_NAME,
-			   session->session_name);
+		ret = sdp_line_write(
+			SDP_TYPE_SESSION_NAME, session->session_name, sdp);
 	} else {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c= " SDP_CRLF,
-			   SDP_TYPE_SESSION_NAME);
+		ret = sdp_line_write(SDP_TYPE_SESSION_NAME, " ", sdp);
 	}
+	if (ret < 0)
+		return ret;
 
 	/* Session information (i=<session description>) */
 	if ((session->session_info) && (*session->session_info != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_INFORMATION,
-			   session->session_info);
+		ret = sdp_line_write(
+			SDP_TYPE_INFORMATION, session->session_info, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* URI (u=<uri>) */
 	if ((session->uri) && (*session->uri != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_URI,
-			   session->uri);
+		ret = sdp_line_write(SDP_TYPE_URI, session->uri, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Email address (e=<email-address>) */
 	if ((session->email) && (*session->email != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_EMAIL,
-			   session->email);
+		ret = sdp_line_write(SDP_TYPE_EMAIL, session->email, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Phone number (p=<phone-number>) */
 	if ((session->phone) && (*session->phone != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_PHONE,
-			   session->phone);
+		ret = sdp_line_write(SDP_TYPE_PHONE, session->phone, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Connection data (c=<nettype> <addrtype> <connection-address>) */
 	if ((session->connection_addr) && (*session->connection_addr != '\0')) {
 		session_level_connection_addr = 1;
-		int multicast = 0;
-		int addr_first = atoi(session->connection_addr);
-		if ((addr_first >= SDP_MULTICAST_ADDR_MIN) &&
-		    (addr_first <= SDP_MULTICAST_ADDR_MAX))
-			multicast = 1;
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=IN IP4 %s%s" SDP_CRLF,
-			   SDP_TYPE_CONNECTION,
-			   session->connection_addr,
-			   (multicast) ? "/127" : "");
+		int multicast = sdp_addr_is_multicast(
+			sdp_span_make(session->connection_addr,
+				      strlen(session->connection_addr)));
+		sdp_emit_type(sdp, SDP_TYPE_CONNECTION);
+		sdp_emit_lit(sdp, "IN IP4 ");
+		sdp_emit_ref_str(sdp, session->connection_addr);
+		if (multicast)
+			sdp_emit_lit(sdp, "/127");
+		CHECK_FUNC(sdp_emit_crlf, ret, return ret, sdp);
+	}
+
+	/* Unmodeled lines: bandwidth (b=) first, then timing (t=) and the
+	 * other ones in their order */
+	ret = sdp_raw_lines_write(
+		&session->raw_lines, SDP_TYPE_BANDWIDTH, 0, sdp);
+	if (ret < 0)
+		return ret;
+	timing = 0;
+	list_walk_entry_forward(&session->raw_lines, raw_line, node)
+	{
+		if (raw_line->type == SDP_TYPE_TIME) {
+			timing = 1;
+			break;
+		}
 	}
 
 	/* Timing (t=<start-time> <stop-time>) */
-	/*TODO*/
-	CHECK_FUNC(sdp_sprintf,
-		   ret,
-		   goto error,
-		   &sdp,
-		   "%c=0 0" SDP_CRLF,
-		   SDP_TYPE_TIME);
+	if (!timing) {
+		ret = sdp_line_write(SDP_TYPE_TIME, "0 0", sdp);
+		if (ret < 0)
+			return ret;
+	}
+	ret = sdp_raw_lines_write(
+		&session->raw_lines, SDP_TYPE_BANDWIDTH, 1, sdp);
+	if (ret < 0)
+		return ret;
 
 	/* Tool (a=tool) */
 	if ((session->tool) && (*session->tool != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s:%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_TOOL,
-			   session->tool);
+		ret = sdp_attr_line_write(SDP_ATTR_TOOL, session->tool, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Start mode (a=<start_mode>) */
 	if ((session->start_mode > SDP_START_MODE_UNSPECIFIED) &&
 	    (session->start_mode <= SDP_START_MODE_INACTIVE)) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   sdp_start_mode_str(session->start_mode));
+		ret = sdp_line_write(SDP_TYPE_ATTRIBUTE,
+				     sdp_start_mode_str(session->start_mode),
+				     sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Session type (a=type) */
 	if ((session->type) && (*session->type != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s:%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_TYPE,
-			   session->type);
+		ret = sdp_attr_line_write(SDP_ATTR_TYPE, session->type, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Charset (a=charset) */
 	if ((session->charset) && (*session->charset != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s:%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_CHARSET,
-			   session->charset);
+		ret = sdp_attr_line_write(
+			SDP_ATTR_CHARSET, session->charset, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Control URL for use with RTSP (a=control) */
 	if ((session->control_url) && (*session->control_url != '\0')) {
-		CHECK_FUNC(sdp_sprintf,
-			   ret,
-			   goto error,
-			   &sdp,
-			   "%c=%s:%s" SDP_CRLF,
-			   SDP_TYPE_ATTRIBUTE,
-			   SDP_ATTR_CONTROL_URL,
-			   session->control_url);
+		ret = sdp_attr_line_write(
+			SDP_ATTR_CONTROL_URL, session->control_url, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Range (a=range) */
 	if (session->range.start.format != SDP_TIME_FORMAT_UNKNOWN) {
-		ret = sdp_range_attr_write(&session->range, &sdp);
+		ret = sdp_range_attr_write(&session->range, sdp);
 		if (ret < 0)
-			goto error;
+			return ret;
 	}
 
 	/* RTCP extended reports attribute (a=rtcp-xr) */
 	if (session->rtcp_xr.valid) {
-		ret = sdp_rtcp_xr_attr_write(&session->rtcp_xr, &sdp);
+		ret = sdp_rtcp_xr_attr_write(&session->rtcp_xr, sdp);
 		if (ret < 0)
-			goto error;
+			return ret;
 	}
 
 	/* Other attributes (a=<attribute>:<value> or a=<attribute>) */
 	list_walk_entry_forward(&session->attrs, attr, node)
 	{
-		if ((attr->key) && (*attr->key != '\0')) {
-			if ((attr->value) && (*attr->value != '\0')) {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   goto error,
-					   &sdp,
-					   "%c=%s:%s" SDP_CRLF,
-					   SDP_TYPE_ATTRIBUTE,
-					   attr->key,
-					   attr->value);
-			} else {
-				CHECK_FUNC(sdp_sprintf,
-					   ret,
-					   goto error,
-					   &sdp,
-					   "%c=%s" SDP_CRLF,
-					   SDP_TYPE_ATTRIBUTE,
-					   attr->key);
-			}
-		}
+		ret = sdp_attr_write(attr, sdp);
+		if (ret < 0)
+			return ret;
 	}
 
 	/* Media (m=...) */
 	list_walk_entry_forward(&session->medias, media, node)
 	{
 		ret = sdp_media_write(
-			media, &sdp, session_level_connection_addr);
+			media, sdp, session_level_connection_addr);
 		if (ret < 0)
-			goto error;
+			return ret;
 	}
 
-	*ret_str = sdp.str;
 	return 0;
-
-error:
-	free(sdp.str);
-	return ret;
 }
 
 
-int sdp_description_read(const char *session_desc, struct sdp_session **ret_obj)
+int sdp_description_write(const struct sdp_session *session, char **ret_str)
 {
 	int ret;
-	char *sdp;
-	struct sdp_media *media = NULL;
-	char *p, type, *value, *temp;
-	uint32_t mandatory_fields = 0;
-	struct sdp_session *session = NULL;
+	struct sdp_string sdp;
 
-	ULOG_ERRNO_RETURN_ERR_IF(session_desc == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_str == NULL, EINVAL);
 
-	session = sdp_session_new();
-	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, ENOMEM);
+	memset(&sdp, 0, sizeof(sdp));
+	sdp.str = malloc(SDP_DEFAULT_LEN);
+	ULOG_ERRNO_RETURN_ERR_IF(sdp.str == NULL, ENOMEM);
+	sdp.max_len = SDP_DEFAULT_LEN;
+	sdp.str[0] = '\0';
 
-	sdp = strdup(session_desc);
-	if (sdp == NULL) {
-		ret = -ENOMEM;
-		ULOG_ERRNO("strdup", -ret);
-		goto error;
+	ret = sdp_session_write(session, &sdp);
+	if (ret < 0) {
+		free(sdp.str);
+		return ret;
 	}
 
-	p = strtok_r(sdp, SDP_CRLF, &temp);
-	while (p) {
-		/* Each line should be more than 2 chars long and in the form
-		 * "<type>=<value>" with <type> being a single char */
-		if ((strlen(p) <= 2) || (p[1] != '=')) {
-			p = strtok_r(NULL, SDP_CRLF, &temp);
-			continue;
-		}
+	*ret_str = sdp.str;
+	return 0;
+}
 
-		/* <type>=<value>, value is always at offset 2 */
-		type = *p;
-		value = p + 2;
-
-		switch (type) {
-		case SDP_TYPE_VERSION: {
-			mandatory_fields |= SDP_MANDATORY_TYPE_MASK_VERSION;
-			/* Protocol version (v=0) */
-			int version = -1;
-			if (sscanf(value, "%d", &version) == SDP_VERSION)
-				ULOGD("SDP: version=%d", version);
-			if (version != 0) {
-				/* SDP version must be 0 (RFC4566) */
-				ULOGE("unsupported SDP version (%d)", version);
-				ret = -EPROTO;
-				goto error;
-			}
-			break;
-		}
 
-		case SDP_TYPE_ORIGIN: {
-			mandatory_fields |= SDP_MANDATORY_TYPE_MASK_ORIGIN;
-			/* Origin (o=<username> <sess-id> <sess-version>
-			 * <nettype> <addrtype> <unicast-address>) */
-			char *temp2 = NULL;
-			char *username = strtok_r(value, " ", &temp2);
-			char *sess_id = strtok_r(NULL, " ", &temp2);
-			char *sess_version = strtok_r(NULL, " ", &temp2);
-			char *nettype = strtok_r(NULL, " ", &temp2);
-			if ((!nettype) || (strcmp(nettype, "IN") != 0)) {
-				/* Network type must be 'IN'
-				 * (RFC4566 ch. 5.2) */
-				ULOGE("unsupported network type '%s'",
-				      (nettype) ? nettype : "");
-				ret = -EPROTO;
-				goto error;
-			}
-			char *addrtype = strtok_r(NULL, " ", &temp2);
-			if ((!addrtype) || (strcmp(addrtype, "IP4") != 0)) {
-				/* Only IPv4 is supported */
-				ULOGE("unsupported address type '%s'",
-				      (addrtype) ? addrtype : "");
-				ret = -EPROTO;
-				goto error;
-			}
-			char *unicast_address = strtok_r(NULL, " ", &temp2);
-			session->server_addr = xstrdup(unicast_address);
-			session->session_id = (sess_id) ? atoll(sess_id) : 0;
-			session->session_version =
-				(sess_version) ? atoll(sess_version) : 0;
-			ULOGD("SDP: username=%s sess_id=%" PRIu64
-			      " sess_version=%" PRIu64
-			      " nettype=%s"
-			      " addrtype=%s unicast_address=%s",
-			      username,
-			      session->session_id,
-			      session->session_version,
-			      nettype,
-			      addrtype,
-			      unicast_address);
-			break;
-		}
+int sdp_description_write_size(const struct sdp_session *session,
+			       size_t *ret_len)
+{
+	int ret;
+	struct sdp_string sdp;
 
-		case SDP_TYPE_SESSION_NAME: {
-			mandatory_fields |=
-				SDP_MANDATORY_TYPE_MASK_SESSION_NAME;
-			/* Session name (s=<session name>) */
-			session->session_name = strdup(value);
-			ULOGD("SDP: session name=%s", session->session_name);
-			break;
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_len == NULL, EINVAL);
+
+	/* Length only, nothing is stored */
+	memset(&sdp, 0, sizeof(sdp));
+	ret = sdp_session_write(session, &sdp);
+	if (ret < 0)
+		return ret;
+
+	*ret_len = sdp.len;
+	return 0;
+}
+
+
+int sdp_description_write_buf(const struct sdp_session *session,
+			      char *buf,
+			      size_t size,
+			      size_t *ret_len)
+{
+	int ret;
+	struct sdp_string sdp;
+
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(size == 0, EINVAL);
+
+	memset(&sdp, 0, sizeof(sdp));
+	sdp.str = buf;
+	sdp.max_len = size;
+	sdp.fixed = 1;
+	buf[0] = '\0';
+
+	ret = sdp_session_write(session, &sdp);
+	if (ret < 0)
+		return ret;
+
+	if (ret_len != NULL)
+		*ret_len = sdp.len;
+	return 0;
+}
+
+
+#ifndef _WIN32
+
+int sdp_description_write_iov(const struct sdp_session *session,
+			      struct iovec **ret_iov,
+			      size_t *ret_iov_count)
+{
+	int ret;
+	size_t i, offset = 0;
+	struct sdp_string sdp;
+	struct iovec *iov;
+	char *scratch;
+
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_iov == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_iov_count == NULL, EINVAL);
+
+	memset(&sdp, 0, sizeof(sdp));
+	sdp.str = malloc(SDP_DEFAULT_LEN);
+	if (sdp.str == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	sdp.max_len = SDP_DEFAULT_LEN;
+	sdp.str[0] = '\0';
+	sdp.chunks = malloc(SDP_DEFAULT_CHUNK_COUNT * sizeof(*sdp.chunks));
+	if (sdp.chunks == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	sdp.chunk_max = SDP_DEFAULT_CHUNK_COUNT;
+
+	ret = sdp_session_write(session, &sdp);
+	if (ret < 0)
+		goto out;
+
+	/* The chunks and the scratch area in a single allocation; the
+	 * scratch chunks get their address now that it cannot move */
+	iov = malloc(sdp.chunk_count * sizeof(*iov) + sdp.len + 1);
+	if (iov == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	scratch = (char *)(iov + sdp.chunk_count);
+	memcpy(scratch, sdp.str, sdp.len + 1);
+	for (i = 0; i < sdp.chunk_count; i++) {
+		if (sdp.chunks[i].base != NULL) {
+			iov[i].iov_base = (void *)sdp.chunks[i].base;
+		} else {
+			iov[i].iov_base = scratch + offset;
+			offset += sdp.chunks[i].len;
 		}
+		iov[i].iov_len = sdp.chunks[i].len;
+	}
 
-		case SDP_TYPE_INFORMATION: {
-			/* Session information (i=<session description>)
-			 * or media title (i=<media title>) */
-			if (media) {
-				media->media_title = strdup(value);
-				ULOGD("SDP: media title=%s",
-				      media->media_title);
-			} else {
-				session->session_info = strdup(value);
-				ULOGD("SDP: session info=%s",
-				      session->session_info);
-			}
-			break;
+	*ret_iov = iov;
+	*ret_iov_count = sdp.chunk_count;
+
+out:
+	free(sdp.chunks);
+	free(sdp.str);
+	return ret;
+}
+
+#endif /* !_WIN32 */
+
+
+#define SDP_READER_CALL(_reader, _cb, ...)                                     \
+	(((_reader)->cbs->_cb != NULL)                                         \
+		 ? (_reader)->cbs->_cb(__VA_ARGS__, (_reader)->userdata)       \
+		 : 0)
+
+
+/* Decoded H.264 parameter sets up to this size do not need an allocation */
+#define SDP_READER_PARAM_SETS_STACK_SIZE 256
+
+
+void sdp_reader_init(struct sdp_reader *reader,
+		     const struct sdp_read_cbs *cbs,
+		     void *userdata,
+		     const struct sdp_read_opts *opts)
+{
+	static const struct sdp_read_cbs no_cbs;
+
+	memset(reader, 0, sizeof(*reader));
+	reader->cbs = (cbs != NULL) ? cbs : &no_cbs;
+	reader->userdata = userdata;
+	if (opts != NULL)
+		reader->opts = *opts;
+}
+
+
+static int sdp_reader_fmtp_h264(struct sdp_reader *reader,
+				struct sdp_span value)
+{
+	int ret;
+	struct sdp_h264_fmtp fmtp;
+	struct sdp_span sps_b64 = {0}, pps_b64 = {0};
+	uint8_t stack_buf[SDP_READER_PARAM_SETS_STACK_SIZE];
+	uint8_t *buf = stack_buf;
+	size_t size, sps_size, pps_size, max;
+
+	memset(&fmtp, 0, sizeof(fmtp));
+	ret = sdp_h264_fmtp_read(&fmtp, value, &sps_b64, &pps_b64);
+	if (ret < 0)
+		return ret;
+
+	if (((sps_b64.ptr != NULL) || (pps_b64.ptr != NULL)) &&
+	    (!(reader->opts.skip & SDP_READ_SKIP_PARAM_SETS))) {
+		/* sprop-parameter-sets */
+		size = SDP_BASE64_DECODED_SIZE(sps_b64.len) +
+		       SDP_BASE64_DECODED_SIZE(pps_b64.len);
+		max = reader->opts.limits.max_param_sets_size;
+		if ((max != 0) && (size > max)) {
+			ULOGE("parameter sets too large (%zu bytes, max %zu)",
+			      size,
+			      max);
+			return sdp_reader_limit(reader, value.ptr);
+		}
+		ret = sdp_reader_alloc(reader, size, value.ptr);
+		if (ret < 0)
+			return ret;
+		if (size > sizeof(stack_buf)) {
+			buf = malloc(size);
+			if (buf == NULL)
+				return -ENOMEM;
 		}
+		ret = sdp_base64_decode_buf(
+			sps_b64.ptr, sps_b64.len, buf, size, &sps_size);
+		if (ret < 0)
+			goto out;
+		ret = sdp_base64_decode_buf(pps_b64.ptr,
+					    pps_b64.len,
+					    buf + sps_size,
+					    size - sps_size,
+					    &pps_size);
+		if (ret < 0)
+			goto out;
+		fmtp.sps = buf;
+		fmtp.sps_size = (unsigned int)sps_size;
+		fmtp.pps = buf + sps_size;
+		fmtp.pps_size = (unsigned int)pps_size;
+	}
 
-		case SDP_TYPE_URI: {
-			/* URI (u=<uri>) */
-			session->uri = strdup(value);
-			ULOGD("SDP: uri=%s", session->uri);
-			break;
+	ret = SDP_READER_CALL(reader, on_fmtp_h264, &fmtp);
+
+out:
+	if (buf != stack_buf)
+		free(buf);
+	return ret;
+}
+
+
+static int sdp_reader_attr(struct sdp_reader *reader, struct sdp_span value)
+{
+	int ret;
+	struct sdp_span line = value;
+	struct sdp_span attr_key = sdp_span_tok(&value, ':');
+	struct sdp_span attr_value = value;
+
+	if (attr_key.len == 0) {
+		ULOGE("no attribute key");
+		return sdp_reader_error(
+			reader, SDP_ERROR_REASON_MISSING_VALUE, attr_key.ptr);
+	}
+
+	switch (sdp_attr_key_lookup(attr_key, attr_value.len != 0)) {
+	case SDP_ATTR_KEY_RTPAVP_RTPMAP: {
+		/* a=rtpmap */
+		if (!reader->in_media) {
+			ULOGE("attribute 'rtpmap' not on media level");
+			return sdp_reader_error(
+				reader,
+				SDP_ERROR_REASON_NOT_MEDIA_LEVEL,
+				attr_key.ptr);
+		}
+		struct sdp_span rtpmap = attr_value;
+		struct sdp_span payload_type = sdp_span_tok(&rtpmap, ' ');
+		uint32_t payload_type_int = 0;
+		struct sdp_span encoding_name = sdp_span_tok(&rtpmap, '/');
+		struct sdp_span clock_rate = sdp_span_tok(&rtpmap, '/');
+		uint32_t i_clock_rate = 0;
+		struct sdp_span encoding_params = sdp_span_tok(&rtpmap, '/');
+		const char *invalid = NULL;
+		if (sdp_span_to_u32(payload_type,
+				    UINT32_MAX,
+				    &payload_type_int) < 0) {
+			invalid = payload_type.ptr;
+		} else if ((clock_rate.len) &&
+			   (sdp_span_to_u32(clock_rate,
+					    UINT32_MAX,
+					    &i_clock_rate) < 0)) {
+			invalid = clock_rate.ptr;
+		}
+		if (invalid != NULL) {
+			ULOGE("invalid rtpmap '%.*s'",
+			      (int)attr_value.len,
+			      attr_value.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_INVALID_VALUE,
+						invalid);
+		}
+		if ((payload_type_int != reader->payload_type) &&
+		    (reader->opts.flags & SDP_READ_FLAG_RAW_LINES)) {
+			/* Other format of the media line */
+			return SDP_READER_CALL(
+				reader, on_raw_line, SDP_TYPE_ATTRIBUTE, line);
+		}
+		if (payload_type_int != reader->payload_type) {
+			ULOGE("invalid payload type (%d vs. %d)",
+			      payload_type_int,
+			      reader->payload_type);
+			return sdp_reader_error(
+				reader,
+				SDP_ERROR_REASON_PAYLOAD_TYPE_MISMATCH,
+				payload_type.ptr);
 		}
+		if (encoding_name.len == 0) {
+			ULOGE("encoding name is missing");
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_MISSING_VALUE,
+						encoding_name.ptr);
+		}
+		reader->h264 = sdp_span_eq(encoding_name, SDP_ENCODING_H264);
+		/* Clock rate must be 90000 for H.264
+		 * (RFC6184 ch. 8.2.1) */
+		if ((reader->h264) && (i_clock_rate != SDP_H264_CLOCKRATE)) {
+			ULOGE("unsupported clock rate %d", i_clock_rate);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						clock_rate.ptr);
+		}
+		ULOGD("SDP: payload_type=%d"
+		      " encoding_name=%.*s clock_rate=%d"
+		      " encoding_params=%.*s",
+		      payload_type_int,
+		      (int)encoding_name.len,
+		      encoding_name.ptr,
+		      i_clock_rate,
+		      (int)encoding_params.len,
+		      encoding_params.ptr);
+		break;
+	}
 
-		case SDP_TYPE_EMAIL: {
-			/* Email address (e=<email-address>) */
-			session->email = strdup(value);
-			ULOGD("SDP: email=%s", session->email);
-			break;
+	case SDP_ATTR_KEY_FMTP: {
+		/* a=fmtp */
+		if (!reader->in_media) {
+			ULOGE("attribute 'fmtp' not on media level");
+			return sdp_reader_error(
+				reader,
+				SDP_ERROR_REASON_NOT_MEDIA_LEVEL,
+				attr_key.ptr);
+		}
+		struct sdp_span fmtp = attr_value;
+		struct sdp_span payload_type = sdp_span_tok(&fmtp, ' ');
+		uint32_t payload_type_int = 0;
+		ret = sdp_span_to_u32(
+			payload_type, UINT32_MAX, &payload_type_int);
+		if (ret < 0) {
+			ULOGE("invalid fmtp payload type '%.*s'",
+			      (int)payload_type.len,
+			      payload_type.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_INVALID_VALUE,
+						payload_type.ptr);
 		}
 
-		case SDP_TYPE_PHONE: {
-			/* Phone number (p=<phone-number>) */
-			session->phone = strdup(value);
-			ULOGD("SDP: phone=%s", session->phone);
-			break;
+		if (((payload_type_int != reader->payload_type) ||
+		     (!reader->h264)) &&
+		    (reader->opts.flags & SDP_READ_FLAG_RAW_LINES)) {
+			/* Other format of the media line, or format
+			 * parameters not modeled */
+			return SDP_READER_CALL(
+				reader, on_raw_line, SDP_TYPE_ATTRIBUTE, line);
+		}
+		if (payload_type_int != reader->payload_type) {
+			ULOGE("invalid payload type (%d vs. %d)",
+			      payload_type_int,
+			      reader->payload_type);
+			return sdp_reader_error(
+				reader,
+				SDP_ERROR_REASON_PAYLOAD_TYPE_MISMATCH,
+				payload_type.ptr);
 		}
 
-		case SDP_TYPE_CONNECTION: {
-			mandatory_fields |= SDP_MANDATORY_TYPE_MASK_CONNECTION;
-			/* Connection data (c=<nettype> <addrtype>
-			 * <connection-address>) */
-			char *temp2 = NULL;
-			char *nettype = strtok_r(value, " ", &temp2);
-			if ((!nettype) || (strcmp(nettype, "IN") != 0)) {
-				/* Network type must be 'IN'
-				 * (RFC4566 ch. 5.7) */
-				ULOGE("unsupported network type '%s'",
-				      (nettype) ? nettype : "");
-				ret = -EPROTO;
-				goto error;
-			}
-			char *addrtype = strtok_r(NULL, " ", &temp2);
-			if ((!addrtype) || (strcmp(addrtype, "IP4") != 0)) {
-				/* Only IPv4 is supported */
-				ULOGE("unsupported address type '%s'",
-				      (addrtype) ? addrtype : "");
-				ret = -EPROTO;
-				goto error;
-			}
-			char *connection_address = strtok_r(NULL, " ", &temp2);
-			if (!connection_address) {
-				ULOGE("missing connection address");
-				ret = -EPROTO;
-				goto error;
-			}
-			int addr_first = atoi(connection_address);
-			int multicast =
-				((addr_first >= SDP_MULTICAST_ADDR_MIN) &&
-				 (addr_first <= SDP_MULTICAST_ADDR_MAX))
-					? 1
-					: 0;
-			if (multicast) {
-				char *p2 = strchr(connection_address, '/');
-				if (p2 != NULL)
-					*p2 = '\0';
-			}
-			if (media) {
-				media->connection_addr =
-					strdup(connection_address);
-				media->multicast = multicast;
-				ULOGD("SDP: media nettype=%s addrtype=%s"
-				      " connection_address=%s",
-				      nettype,
-				      addrtype,
-				      connection_address);
-			} else {
-				session->connection_addr =
-					strdup(connection_address);
-				session->multicast = multicast;
-				ULOGD("SDP: nettype=%s addrtype=%s"
-				      " connection_address=%s",
-				      nettype,
-				      addrtype,
-				      connection_address);
+		if (reader->h264) {
+			if (fmtp.len == 0) {
+				ULOGE("missing H264 format");
+				return sdp_reader_error(
+					reader,
+					SDP_ERROR_REASON_MISSING_VALUE,
+					fmtp.ptr);
 			}
-			break;
+			ret = sdp_reader_fmtp_h264(reader, fmtp);
+			if (ret < 0)
+				return ret;
 		}
+		break;
+	}
 
-		case SDP_TYPE_TIME: {
-			mandatory_fields |= SDP_MANDATORY_TYPE_MASK_TIME;
-			/* Time (t=<start-time> <stop-time>) */
-			char *temp2 = NULL;
-			char *start_time = NULL;
-			start_time = strtok_r(value, " ", &temp2);
-			uint64_t start_time_int =
-				(start_time) ? atoll(start_time) : 0;
-			char *stop_time = NULL;
-			stop_time = strtok_r(NULL, " ", &temp2);
-			uint64_t stop_time_int =
-				(stop_time) ? atoll(stop_time) : 0;
-			ULOGD("SDP: start_time=%" PRIu64 "stop_time=%" PRIu64,
-			      start_time_int,
-			      stop_time_int);
-			/* TODO */
-			break;
+	case SDP_ATTR_KEY_RTCP_PORT: {
+		/* a=rtcp:<port>[ <nettype> <addrtype> <connection-address>] */
+		uint32_t port;
+		if (!reader->in_media) {
+			ULOGE("attribute 'rtcp' not on media level");
+			return sdp_reader_error(
+				reader,
+				SDP_ERROR_REASON_NOT_MEDIA_LEVEL,
+				attr_key.ptr);
 		}
+		if (sdp_span_parse_u32(attr_value, UINT16_MAX, &port) < 0) {
+			ULOGE("invalid rtcp port '%.*s'",
+			      (int)attr_value.len,
+			      attr_value.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_INVALID_VALUE,
+						attr_value.ptr);
+		}
+		break;
+	}
 
-		case SDP_TYPE_MEDIA: {
-			/* Media (m=...) */
-			ret = sdp_session_media_add(session, &media);
-			if (ret < 0)
-				goto error;
-			ret = sdp_media_read(media, value);
-			if (ret < 0)
-				goto error;
-			break;
+	default:
+		break;
+	}
+
+	return SDP_READER_CALL(reader, on_attr, attr_key, attr_value);
+}
+
+
+static int sdp_reader_field(struct sdp_reader *reader,
+			    const struct sdp_field *field,
+			    int media_level)
+{
+	if (media_level)
+		return SDP_READER_CALL(reader, on_media_field, field);
+	else
+		return SDP_READER_CALL(reader, on_session_field, field);
+}
+
+
+static int sdp_reader_line_internal(struct sdp_reader *reader,
+				    struct sdp_span line)
+{
+	int ret;
+	char type;
+	struct sdp_span value;
+	struct sdp_field field;
+
+	/* Each line should be more than 2 chars long and in the form
+	 * "<type>=<value>" with <type> being a single char */
+	if ((line.len <= 2) || (line.ptr[1] != '='))
+		return 0;
+
+	/* <type>=<value>, value is always at offset 2 */
+	type = line.ptr[0];
+	value = sdp_span_make(line.ptr + 2, line.len - 2);
+
+	/* Lines of a skipped media section are ignored up to the next
+	 * media; connection data still counts as present */
+	if ((reader->skip_media) && (type != SDP_TYPE_MEDIA)) {
+		if (type == SDP_TYPE_CONNECTION) {
+			reader->mandatory_fields |=
+				SDP_MANDATORY_TYPE_MASK_CONNECTION;
 		}
+		return 0;
+	}
 
-		case SDP_TYPE_ATTRIBUTE: {
-			/* Attributes (a=...) */
-			struct sdp_attr *attr = NULL;
-			ret = sdp_attr_read(session, media, value, &attr);
-			if (ret < 0)
-				goto error;
+	/* Estimated memory of the value in the session object */
+	ret = sdp_reader_alloc(reader, value.len + 1, line.ptr);
+	if (ret < 0)
+		return ret;
+
+	memset(&field, 0, sizeof(field));
+	field.type = type;
+	field.value = value;
+
+	switch (type) {
+	case SDP_TYPE_VERSION: {
+		reader->mandatory_fields |= SDP_MANDATORY_TYPE_MASK_VERSION;
+		/* Protocol version (v=0) */
+		int version = -1;
+		uint32_t v;
+		if (sdp_span_to_u32(value, INT32_MAX, &v) == 0)
+			version = (int)v;
+		ULOGD("SDP: version=%d", version);
+		if (version != SDP_VERSION) {
+			/* SDP version must be 0 (RFC4566) */
+			ULOGE("unsupported SDP version (%d)", version);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						value.ptr);
+		}
+		break;
+	}
 
-			if (!attr)
-				break;
+	case SDP_TYPE_ORIGIN: {
+		reader->mandatory_fields |= SDP_MANDATORY_TYPE_MASK_ORIGIN;
+		/* Origin (o=<username> <sess-id> <sess-version>
+		 * <nettype> <addrtype> <unicast-address>) */
+		struct sdp_span username = sdp_span_tok(&value, ' ');
+		struct sdp_span sess_id = sdp_span_tok(&value, ' ');
+		struct sdp_span sess_version = sdp_span_tok(&value, ' ');
+		struct sdp_span nettype = sdp_span_tok(&value, ' ');
+		if (!sdp_span_eq(nettype, "IN")) {
+			/* Network type must be 'IN'
+			 * (RFC4566 ch. 5.2) */
+			ULOGE("unsupported network type '%.*s'",
+			      (int)nettype.len,
+			      nettype.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						nettype.ptr);
+		}
+		struct sdp_span addrtype = sdp_span_tok(&value, ' ');
+		if (!sdp_span_eq(addrtype, "IP4")) {
+			/* Only IPv4 is supported */
+			ULOGE("unsupported address type '%.*s'",
+			      (int)addrtype.len,
+			      addrtype.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						addrtype.ptr);
+		}
+		field.value = sdp_span_tok(&value, ' ');
+		const char *invalid = NULL;
+		if (sdp_span_to_u64(sess_id, UINT64_MAX, &field.session_id) <
+		    0) {
+			invalid = sess_id.ptr;
+		} else if (sdp_span_to_u64(sess_version,
+					   UINT64_MAX,
+					   &field.session_version) < 0) {
+			invalid = sess_version.ptr;
+		}
+		if (invalid != NULL) {
+			ULOGE("invalid session id or version '%.*s %.*s'",
+			      (int)sess_id.len,
+			      sess_id.ptr,
+			      (int)sess_version.len,
+			      sess_version.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_INVALID_VALUE,
+						invalid);
+		}
+		ULOGD("SDP: username=%.*s sess_id=%" PRIu64
+		      " sess_version=%" PRIu64
+		      " nettype=%.*s"
+		      " addrtype=%.*s unicast_address=%.*s",
+		      (int)username.len,
+		      username.ptr,
+		      field.session_id,
+		      field.session_version,
+		      (int)nettype.len,
+		      nettype.ptr,
+		      (int)addrtype.len,
+		      addrtype.ptr,
+		      (int)field.value.len,
+		      field.value.ptr);
+		return sdp_reader_field(reader, &field, 0);
+	}
 
-			if (media) {
-				ret = sdp_media_attr_add_existing(media, attr);
-				if (ret < 0)
-					goto error;
-			} else {
-				ret = sdp_session_attr_add_existing(session,
-								    attr);
-				if (ret < 0)
-					goto error;
-			}
-			break;
+	case SDP_TYPE_SESSION_NAME: {
+		reader->mandatory_fields |=
+			SDP_MANDATORY_TYPE_MASK_SESSION_NAME;
+		/* Session name (s=<session name>) */
+		ULOGD("SDP: session name=%.*s", (int)value.len, value.ptr);
+		return sdp_reader_field(reader, &field, 0);
+	}
+
+	case SDP_TYPE_INFORMATION: {
+		/* Session information (i=<session description>)
+		 * or media title (i=<media title>) */
+		ULOGD("SDP: %s=%.*s",
+		      reader->in_media ? "media title" : "session info",
+		      (int)value.len,
+		      value.ptr);
+		return sdp_reader_field(reader, &field, reader->in_media);
+	}
+
+	case SDP_TYPE_URI: {
+		/* URI (u=<uri>) */
+		ULOGD("SDP: uri=%.*s", (int)value.len, value.ptr);
+		return sdp_reader_field(reader, &field, 0);
+	}
+
+	case SDP_TYPE_EMAIL: {
+		/* Email address (e=<email-address>) */
+		ULOGD("SDP: email=%.*s", (int)value.len, value.ptr);
+		return sdp_reader_field(reader, &field, 0);
+	}
+
+	case SDP_TYPE_PHONE: {
+		/* Phone number (p=<phone-number>) */
+		ULOGD("SDP: phone=%.*s", (int)value.len, value.ptr);
+		return sdp_reader_field(reader, &field, 0);
+	}
+
+	case SDP_TYPE_CONNECTION: {
+		reader->mandatory_fields |= SDP_MANDATORY_TYPE_MASK_CONNECTION;
+		/* Connection data (c=<nettype> <addrtype>
+		 * <connection-address>) */
+		struct sdp_span nettype = sdp_span_tok(&value, ' ');
+		if (!sdp_span_eq(nettype, "IN")) {
+			/* Network type must be 'IN'
+			 * (RFC4566 ch. 5.7) */
+			ULOGE("unsupported network type '%.*s'",
+			      (int)nettype.len,
+			      nettype.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						nettype.ptr);
+		}
+		struct sdp_span addrtype = sdp_span_tok(&value, ' ');
+		if (!sdp_span_eq(addrtype, "IP4")) {
+			/* Only IPv4 is supported */
+			ULOGE("unsupported address type '%.*s'",
+			      (int)addrtype.len,
+			      addrtype.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_UNSUPPORTED,
+						addrtype.ptr);
+		}
+		struct sdp_span connection_address = sdp_span_tok(&value, ' ');
+		if (connection_address.len == 0) {
+			ULOGE("missing connection address");
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_MISSING_VALUE,
+						connection_address.ptr);
 		}
+		int multicast = sdp_addr_is_multicast(connection_address);
+		if (multicast)
+			sdp_span_split(&connection_address, '/');
+		field.value = connection_address;
+		field.multicast = multicast;
+		ULOGD("SDP: %snettype=%.*s addrtype=%.*s"
+		      " connection_address=%.*s",
+		      reader->in_media ? "media " : "",
+		      (int)nettype.len,
+		      nettype.ptr,
+		      (int)addrtype.len,
+		      addrtype.ptr,
+		      (int)connection_address.len,
+		      connection_address.ptr);
+		return sdp_reader_field(reader, &field, reader->in_media);
+	}
 
-		default:
-			break;
+	case SDP_TYPE_TIME: {
+		reader->mandatory_fields |= SDP_MANDATORY_TYPE_MASK_TIME;
+		/* Time (t=<start-time> <stop-time>) */
+		struct sdp_span start_time = sdp_span_tok(&value, ' ');
+		struct sdp_span stop_time = sdp_span_tok(&value, ' ');
+		uint64_t start_time_int, stop_time_int;
+		const char *invalid = NULL;
+		if (sdp_span_to_u64(start_time, UINT64_MAX, &start_time_int) <
+		    0) {
+			invalid = start_time.ptr;
+		} else if (sdp_span_to_u64(stop_time,
+					   UINT64_MAX,
+					   &stop_time_int) < 0) {
+			invalid = stop_time.ptr;
+		}
+		if (invalid != NULL) {
+			ULOGE("invalid time '%.*s %.*s'",
+			      (int)start_time.len,
+			      start_time.ptr,
+			      (int)stop_time.len,
+			      stop_time.ptr);
+			return sdp_reader_error(reader,
+						SDP_ERROR_REASON_INVALID_VALUE,
+						invalid);
 		}
-		p = strtok_r(NULL, SDP_CRLF, &temp);
+		ULOGD("SDP: start_time=%" PRIu64 "stop_time=%" PRIu64,
+		      start_time_int,
+		      stop_time_int);
+		if (reader->opts.flags & SDP_READ_FLAG_RAW_LINES) {
+			return SDP_READER_CALL(
+				reader, on_raw_line, type, field.value);
+		}
+		break;
 	}
 
-	/* Copy session-level parameters to media-level if undefined */
-	list_walk_entry_forward(&session->medias, media, node)
-	{
-		if ((!media->connection_addr) && (session->connection_addr)) {
-			media->connection_addr =
-				strdup(session->connection_addr);
-			media->multicast = session->multicast;
+	case SDP_TYPE_MEDIA: {
+		/* Media (m=...) */
+		enum sdp_media_type media_type;
+		unsigned int port = 0, payload_type = 0;
+		struct sdp_span fmts;
+		ret = sdp_reader_media_count(reader, line);
+		if (ret < 0)
+			return ret;
+		ret = sdp_media_read(reader,
+				     value,
+				     &media_type,
+				     &port,
+				     &payload_type,
+				     &fmts);
+		if (ret < 0)
+			return ret;
+		reader->in_media = 1;
+		reader->payload_type = payload_type;
+		reader->h264 = 0;
+		reader->skip_media = (reader->opts.skip_media_types &
+				      SDP_MEDIA_TYPE_BIT(media_type)) != 0;
+		if (reader->skip_media)
+			return 0;
+		ret = sdp_reader_alloc(
+			reader, sizeof(struct sdp_media), line.ptr);
+		if (ret < 0)
+			return ret;
+		ret = SDP_READER_CALL(
+			reader, on_media_begin, media_type, port, payload_type);
+		if ((ret < 0) || (fmts.len == 0) ||
+		    (!(reader->opts.flags & SDP_READ_FLAG_RAW_LINES)))
+			return ret;
+		return SDP_READER_CALL(reader, on_raw_line, type, fmts);
+	}
+
+	case SDP_TYPE_ATTRIBUTE: {
+		/* Attributes (a=...) */
+		reader->attr_count++;
+		if ((reader->opts.limits.max_attrs != 0) &&
+		    (reader->attr_count > reader->opts.limits.max_attrs)) {
+			ULOGE("too many attributes (max %u)",
+			      reader->opts.limits.max_attrs);
+			return sdp_reader_limit(reader, line.ptr);
+		}
+		ret = sdp_reader_alloc(
+			reader, sizeof(struct sdp_attr), line.ptr);
+		if (ret < 0)
+			return ret;
+		return sdp_reader_attr(reader, value);
+	}
+
+	default:
+		/* Bandwidth, repeat times, time zones, encryption key and
+		 * unknown types */
+		if (reader->opts.flags & SDP_READ_FLAG_RAW_LINES) {
+			return SDP_READER_CALL(
+				reader, on_raw_line, type, value);
 		}
-		if (media->start_mode == SDP_START_MODE_UNSPECIFIED)
-			media->start_mode = session->start_mode;
-		if ((!media->rtcp_xr.valid) && (session->rtcp_xr.valid))
-			media->rtcp_xr = session->rtcp_xr;
+		break;
 	}
 
+	return 0;
+}
+
+
+int sdp_reader_line(struct sdp_reader *reader, struct sdp_span line)
+{
+	int ret = sdp_reader_line_internal(reader, line);
+	if (ret < 0)
+		return sdp_reader_line_error(reader, line, ret);
+	return 0;
+}
+
+
+/* Record the first missing mandatory field as the reader error */
+static void sdp_reader_missing_field(struct sdp_reader *reader, char type)
+{
+	if (reader->err.reason != SDP_ERROR_REASON_NONE)
+		return;
+
+	reader->err.reason = SDP_ERROR_REASON_MISSING_FIELD;
+	reader->err.type = type;
+}
+
+
+int sdp_reader_finish(struct sdp_reader *reader)
+{
+	uint32_t mandatory_fields = reader->mandatory_fields;
+	int deletion = 0;
+
 	if (mandatory_fields == SDP_MANDATORY_TYPE_MASK_ORIGIN) {
 		/* If only origin is present, this is a deletion SDP */
 		ULOGD("SDP is of type deletion");
-		session->deletion = 1;
+		deletion = 1;
 	} else if ((SDP_MANDATORY_TYPE_MASK_ALL & mandatory_fields) !=
 		   SDP_MANDATORY_TYPE_MASK_ALL) {
 		/* Check that mandatory fields are present */
 		if ((SDP_MANDATORY_TYPE_MASK_VERSION & mandatory_fields) !=
-		    SDP_MANDATORY_TYPE_MASK_VERSION)
+		    SDP_MANDATORY_TYPE_MASK_VERSION) {
 			ULOGE("missing mandatory field version (v=)");
+			sdp_reader_missing_field(reader, SDP_TYPE_VERSION);
+		}
 		if ((SDP_MANDATORY_TYPE_MASK_ORIGIN & mandatory_fields) !=
-		    SDP_MANDATORY_TYPE_MASK_ORIGIN)
+		    SDP_MANDATORY_TYPE_MASK_ORIGIN) {
 			ULOGE("missing mandatory field origin (o=)");
+			sdp_reader_missing_field(reader, SDP_TYPE_ORIGIN);
+		}
 		if ((SDP_MANDATORY_TYPE_MASK_SESSION_NAME & mandatory_fields) !=
-		    SDP_MANDATORY_TYPE_MASK_SESSION_NAME)
+		    SDP_MANDATORY_TYPE_MASK_SESSION_NAME) {
 			ULOGE("missing mandatory field session name (s=)");
+			sdp_reader_missing_field(reader,
+						 SDP_TYPE_SESSION_NAME);
+		}
 		if ((SDP_MANDATORY_TYPE_MASK_CONNECTION & mandatory_fields) !=
-		    SDP_MANDATORY_TYPE_MASK_CONNECTION)
+		    SDP_MANDATORY_TYPE_MASK_CONNECTION) {
 			ULOGE("missing mandatory field connection (c=)");
+			sdp_reader_missing_field(reader, SDP_TYPE_CONNECTION);
+		}
 		if ((SDP_MANDATORY_TYPE_MASK_TIME & mandatory_fields) !=
-		    SDP_MANDATORY_TYPE_MASK_TIME)
+		    SDP_MANDATORY_TYPE_MASK_TIME) {
 			ULOGE("missing mandatory field time (t=)");
-		ret = -EPROTO;
-		goto error;
+			sdp_reader_missing_field(reader, SDP_TYPE_TIME);
+		}
+		return -EPROTO;
 	}
 
-	free(sdp);
-	*ret_obj = session;
-	return 0;
+	return SDP_READER_CALL(reader, on_end, deletion);
+}
 
-error:
-	free(sdp);
-	sdp_session_destroy(session);
-	return ret;
+
+/* String fields of the session and media objects */
+static const size_t sdp_session_strings[] = {
+	offsetof(struct sdp_session, server_addr),
+	offsetof(struct sdp_session, session_name),
+	offsetof(struct sdp_session, session_info),
+	offsetof(struct sdp_session, uri),
+	offsetof(struct sdp_session, email),
+	offsetof(struct sdp_session, phone),
+	offsetof(struct sdp_session, tool),
+	offsetof(struct sdp_session, type),
+	offsetof(struct sdp_session, charset),
+	offsetof(struct sdp_session, connection_addr),
+	offsetof(struct sdp_session, control_url),
+};
+
+
+static const size_t sdp_media_strings[] = {
+	offsetof(struct sdp_media, media_title),
+	offsetof(struct sdp_media, connection_addr),
+	offsetof(struct sdp_media, fmts),
+	offsetof(struct sdp_media, control_url),
+	offsetof(struct sdp_media, encoding_name),
+	offsetof(struct sdp_media, encoding_params),
+};
+
+
+#define SDP_FIELD(_obj, _offset) ((char **)((char *)(_obj) + (_offset)))
+
+
+/* Move the strings of 'src' to 'dst', freeing the previous 'dst' ones */
+static void sdp_strings_move(void *dst,
+			     void *src,
+			     const size_t *offsets,
+			     size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		free(*SDP_FIELD(dst, offsets[i]));
+		*SDP_FIELD(dst, offsets[i]) = *SDP_FIELD(src, offsets[i]);
+		*SDP_FIELD(src, offsets[i]) = NULL;
+	}
+}
+
+
+static void sdp_strings_free(void *obj, const size_t *offsets, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		free(*SDP_FIELD(obj, offsets[i]));
+		*SDP_FIELD(obj, offsets[i]) = NULL;
+	}
+}
+
+
+/* Set the string pointed by 'dst' to a copy of the span; the previous
+ * string of the field ('spare', optional) or the current one is reused
+ * if it is large enough */
+static void sdp_builder_set(char **dst, char **spare, struct sdp_span value)
+{
+	if ((spare != NULL) && (*spare != NULL)) {
+		free(*dst);
+		*dst = *spare;
+		*spare = NULL;
+	}
+	if ((value.len > 0) && (*dst != NULL) && (strlen(*dst) >= value.len)) {
+		memcpy(*dst, value.ptr, value.len);
+		(*dst)[value.len] = '\0';
+		return;
+	}
+	sdp_span_set(dst, value);
+}
+
+
+#define SDP_BUILDER_SET(_builder, _obj, _field, _value)                        \
+	sdp_builder_set(&(_builder)->_obj->_field,                             \
+			((_builder)->spare != NULL)                            \
+				? &(_builder)->spare->_obj._field              \
+				: NULL,                                        \
+			(_value))
+
+
+void sdp_builder_spare_init(struct sdp_builder_spare *spare)
+{
+	memset(spare, 0, sizeof(*spare));
+	list_init(&spare->session.attrs);
+	list_init(&spare->session.medias);
+	list_init(&spare->media.attrs);
+}
+
+
+/* Move the attributes of a list to the spare ones */
+static void sdp_builder_spare_attrs(struct sdp_builder_spare *spare,
+				    struct list_node *attrs)
+{
+	struct sdp_attr *attr = NULL, *tmp_attr = NULL;
+
+	list_walk_entry_forward_safe(attrs, attr, tmp_attr, node)
+	{
+		list_del(&attr->node);
+		list_add_before(&spare->session.attrs, &attr->node);
+	}
+}
+
+
+void sdp_builder_reuse(struct sdp_builder *builder,
+		       struct sdp_session *session,
+		       struct sdp_builder_spare *spare)
+{
+	struct sdp_media *media = NULL, *tmp_media = NULL;
+
+	memset(builder, 0, sizeof(*builder));
+	builder->session = session;
+	builder->spare = spare;
+
+	sdp_strings_move(&spare->session,
+			 session,
+			 sdp_session_strings,
+			 SDP_ARRAY_SIZE(sdp_session_strings));
+	sdp_builder_spare_attrs(spare, &session->attrs);
+	list_walk_entry_forward_safe(&session->medias, media, tmp_media, node)
+	{
+		media->inherited = 0;
+		list_del(&media->node);
+		list_add_before(&spare->session.medias, &media->node);
+	}
+
+	/* Reset everything else; the source text of a lazy session and the
+	 * raw lines are not reused */
+	sdp_raw_lines_clear(&session->raw_lines, &session->raw_line_count);
+	sdp_lazy_media_destroy(session->lazy_media);
+	free(session->text);
+	free(session->lines);
+	memset(session, 0, sizeof(*session));
+	list_init(&session->attrs);
+	list_init(&session->medias);
+	list_init(&session->raw_lines);
+}
+
+
+/* Get a spare media if any, its strings become the spare ones */
+static struct sdp_media *sdp_builder_spare_media(struct sdp_builder *builder)
+{
+	struct sdp_builder_spare *spare = builder->spare;
+	struct sdp_media *media;
+
+	if ((spare == NULL) || (list_is_empty(&spare->session.medias)))
+		return sdp_media_new();
+
+	media = list_entry(list_first(&spare->session.medias),
+			   struct sdp_media,
+			   node);
+	list_del(&media->node);
+
+	sdp_strings_move(&spare->media,
+			 media,
+			 sdp_media_strings,
+			 SDP_ARRAY_SIZE(sdp_media_strings));
+	free(spare->media.h264_fmtp.sps);
+	free(spare->media.h264_fmtp.pps);
+	spare->media.h264_fmtp = media->h264_fmtp;
+	sdp_builder_spare_attrs(spare, &media->attrs);
+	sdp_raw_lines_clear(&media->raw_lines, &media->raw_line_count);
+
+	memset(media, 0, sizeof(*media));
+	list_node_unref(&media->node);
+	list_init(&media->attrs);
+	list_init(&media->raw_lines);
+
+	return media;
+}
+
+
+/* Get a spare attribute if any */
+static struct sdp_attr *sdp_builder_spare_attr(struct sdp_builder *builder)
+{
+	struct sdp_builder_spare *spare = builder->spare;
+	struct sdp_attr *attr;
+
+	if ((spare == NULL) || (list_is_empty(&spare->session.attrs)))
+		return sdp_attr_new();
+
+	attr = list_entry(
+		list_first(&spare->session.attrs), struct sdp_attr, node);
+	list_del(&attr->node);
+	attr->text = NULL;
+	memset(&attr->key_view, 0, sizeof(attr->key_view));
+	memset(&attr->value_view, 0, sizeof(attr->value_view));
+	sdp_attr_data_free(attr);
+
+	return attr;
+}
+
+
+/* End of the current media: free the spare strings it did not reuse */
+static void sdp_builder_media_end(struct sdp_builder *builder)
+{
+	struct sdp_builder_spare *spare = builder->spare;
+
+	if (spare == NULL)
+		return;
+
+	sdp_strings_free(&spare->media,
+			 sdp_media_strings,
+			 SDP_ARRAY_SIZE(sdp_media_strings));
+	free(spare->media.h264_fmtp.sps);
+	free(spare->media.h264_fmtp.pps);
+	memset(&spare->media.h264_fmtp, 0, sizeof(spare->media.h264_fmtp));
+}
+
+
+void sdp_builder_spare_flush(struct sdp_builder *builder)
+{
+	struct sdp_builder_spare *spare = builder->spare;
+	struct sdp_attr *attr = NULL, *tmp_attr = NULL;
+	struct sdp_media *media = NULL, *tmp_media = NULL;
+
+	if (spare == NULL)
+		return;
+
+	sdp_builder_media_end(builder);
+	builder->media = NULL;
+
+	sdp_strings_free(&spare->session,
+			 sdp_session_strings,
+			 SDP_ARRAY_SIZE(sdp_session_strings));
+	list_walk_entry_forward_safe(
+		&spare->session.attrs, attr, tmp_attr, node)
+	{
+		list_del(&attr->node);
+		sdp_attr_destroy(attr);
+	}
+	list_walk_entry_forward_safe(
+		&spare->session.medias, media, tmp_media, node)
+	{
+		list_del(&media->node);
+		sdp_media_destroy(media);
+	}
+}
+
+
+static int sdp_builder_session_field(const struct sdp_field *field,
+				     void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_session *session = builder->session;
+
+	switch (field->type) {
+	case SDP_TYPE_ORIGIN:
+		SDP_BUILDER_SET(builder, session, server_addr, field->value);
+		session->session_id = field->session_id;
+		session->session_version = field->session_version;
+		break;
+	case SDP_TYPE_SESSION_NAME:
+		SDP_BUILDER_SET(builder, session, session_name, field->value);
+		break;
+	case SDP_TYPE_INFORMATION:
+		SDP_BUILDER_SET(builder, session, session_info, field->value);
+		break;
+	case SDP_TYPE_URI:
+		SDP_BUILDER_SET(builder, session, uri, field->value);
+		break;
+	case SDP_TYPE_EMAIL:
+		SDP_BUILDER_SET(builder, session, email, field->value);
+		break;
+	case SDP_TYPE_PHONE:
+		SDP_BUILDER_SET(builder, session, phone, field->value);
+		break;
+	case SDP_TYPE_CONNECTION:
+		SDP_BUILDER_SET(
+			builder, session, connection_addr, field->value);
+		session->multicast = field->multicast;
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+
+static int sdp_builder_media_begin(enum sdp_media_type type,
+				   unsigned int port,
+				   unsigned int payload_type,
+				   void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_media *media;
+
+	sdp_builder_media_end(builder);
+	builder->media = NULL;
+
+	media = sdp_builder_spare_media(builder);
+	ULOG_ERRNO_RETURN_ERR_IF(media == NULL, ENOMEM);
+	sdp_session_media_append(builder->session, media);
+
+	builder->media = media;
+	media->type = type;
+	if (port) {
+		media->dst_stream_port = port;
+		media->dst_control_port = port + 1;
+	} else {
+		media->dst_control_port = 0;
+	}
+	media->payload_type = payload_type;
+
+	return 0;
+}
+
+
+static int sdp_builder_media_field(const struct sdp_field *field,
+				   void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_media *media = builder->media;
+
+	switch (field->type) {
+	case SDP_TYPE_INFORMATION:
+		SDP_BUILDER_SET(builder, media, media_title, field->value);
+		break;
+	case SDP_TYPE_CONNECTION:
+		SDP_BUILDER_SET(builder, media, connection_addr, field->value);
+		media->multicast = field->multicast;
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+
+static int sdp_builder_attr(struct sdp_span attr_key,
+			    struct sdp_span attr_value,
+			    void *userdata)
+{
+	int ret;
+	struct sdp_builder *builder = userdata;
+	struct sdp_session *session = builder->session;
+	struct sdp_media *media = builder->media;
+	struct sdp_attr *attr;
+	const struct sdp_attr_type *type;
+
+	switch (sdp_attr_key_lookup(attr_key, attr_value.len != 0)) {
+	case SDP_ATTR_KEY_RTPAVP_RTPMAP: {
+		/* a=rtpmap, validated by the reader */
+		if (media == NULL)
+			break;
+		sdp_span_tok(&attr_value, ' ');
+		struct sdp_span encoding_name = sdp_span_tok(&attr_value, '/');
+		struct sdp_span clock_rate = sdp_span_tok(&attr_value, '/');
+		struct sdp_span encoding_params =
+			sdp_span_tok(&attr_value, '/');
+		uint32_t clock_rate_int = 0;
+		sdp_span_parse_u32(clock_rate, UINT32_MAX, &clock_rate_int);
+		SDP_BUILDER_SET(builder, media, encoding_name, encoding_name);
+		SDP_BUILDER_SET(
+			builder, media, encoding_params, encoding_params);
+		media->clock_rate = clock_rate_int;
+		break;
+	}
+
+	case SDP_ATTR_KEY_FMTP: {
+		/* a=fmtp, see sdp_builder_fmtp_h264() */
+		break;
+	}
+
+	case SDP_ATTR_KEY_TOOL: {
+		/* a=tool */
+		if (media)
+			ULOGW("attribute 'tool' not on session level");
+		else
+			SDP_BUILDER_SET(builder, session, tool, attr_value);
+		break;
+	}
+
+	case SDP_ATTR_KEY_TYPE: {
+		/* a=type */
+		if (media)
+			ULOGW("attribute 'type' not on session level");
+		else
+			SDP_BUILDER_SET(builder, session, type, attr_value);
+		break;
+	}
+
+	case SDP_ATTR_KEY_CHARSET: {
+		/* a=charset */
+		if (media)
+			ULOGW("attribute 'charset' not on session level");
+		else
+			SDP_BUILDER_SET(builder, session, charset, attr_value);
+		break;
+	}
+
+	case SDP_ATTR_KEY_CONTROL_URL: {
+		/* a=control */
+		if (media)
+			SDP_BUILDER_SET(
+				builder, media, control_url, attr_value);
+		else
+			SDP_BUILDER_SET(
+				builder, session, control_url, attr_value);
+		break;
+	}
+
+	case SDP_ATTR_KEY_RANGE: {
+		/* a=range */
+		if (builder->skip & SDP_READ_SKIP_RANGE)
+			break;
+		if (media)
+			ret = sdp_range_attr_read(&media->range, attr_value);
+		else
+			ret = sdp_range_attr_read(&session->range, attr_value);
+		if (ret < 0)
+			return ret;
+		break;
+	}
+
+	case SDP_ATTR_KEY_RECVONLY: {
+		/* a=recvonly */
+		if (media)
+			media->start_mode = SDP_START_MODE_RECVONLY;
+		else
+			session->start_mode = SDP_START_MODE_RECVONLY;
+		break;
+	}
+
+	case SDP_ATTR_KEY_SENDRECV: {
+		/* a=sendrecv */
+		if (media)
+			media->start_mode = SDP_START_MODE_SENDRECV;
+		else
+			session->start_mode = SDP_START_MODE_SENDRECV;
+		break;
+	}
+
+	case SDP_ATTR_KEY_SENDONLY: {
+		/* a=sendonly */
+		if (media)
+			media->start_mode = SDP_START_MODE_SENDONLY;
+		else
+			session->start_mode = SDP_START_MODE_SENDONLY;
+		break;
+	}
+
+	case SDP_ATTR_KEY_INACTIVE: {
+		/* a=inactive */
+		if (media)
+			media->start_mode = SDP_START_MODE_INACTIVE;
+		else
+			session->start_mode = SDP_START_MODE_INACTIVE;
+		break;
+	}
+
+	case SDP_ATTR_KEY_RTCP_XR: {
+		/* a=rtcp-xr */
+		if (builder->skip & SDP_READ_SKIP_RTCP_XR)
+			break;
+		if (media) {
+			ret = sdp_rtcp_xr_attr_read(&media->rtcp_xr,
+						    attr_value);
+		} else {
+			ret = sdp_rtcp_xr_attr_read(&session->rtcp_xr,
+						    attr_value);
+		}
+		if (ret < 0)
+			return ret;
+		break;
+	}
+
+	case SDP_ATTR_KEY_RTCP_PORT: {
+		/* a=rtcp, level validated by the reader */
+		if (media == NULL)
+			break;
+		uint32_t port = 0;
+		sdp_span_parse_u32(attr_value, UINT16_MAX, &port);
+		if (port > 0) {
+			media->dst_control_port = port;
+			ULOGD("SDP: rtcp_dst_port=%d", port);
+		}
+		break;
+	}
+
+	default: {
+		/* No special case, create an sdp_attr for the key/value pair */
+		if (builder->skip & SDP_READ_SKIP_ATTRS)
+			break;
+		attr = sdp_builder_spare_attr(builder);
+		if (attr == NULL) {
+			ULOGE("new SDP attribute creation failed");
+			return -ENOMEM;
+		}
+		if (builder->text != NULL) {
+			/* Lazy attribute, view into the source text */
+			attr->text = builder->text;
+			attr->key_view.offset = attr_key.ptr - builder->text;
+			attr->key_view.len = attr_key.len;
+			attr->value_view.offset =
+				attr_value.ptr - builder->text;
+			attr->value_view.len = attr_value.len;
+		} else {
+			sdp_builder_set(&attr->key, NULL, attr_key);
+			sdp_builder_set(&attr->value, NULL, attr_value);
+		}
+		type = (builder->registry != NULL)
+			       ? sdp_attr_registry_lookup(builder->registry,
+							  attr_key)
+			       : NULL;
+		if (type != NULL) {
+			ret = sdp_attr_data_parse(attr, type, attr_value);
+			if (ret < 0) {
+				sdp_attr_destroy(attr);
+				return ret;
+			}
+		}
+		if (media)
+			ret = sdp_media_attr_add_existing(media, attr);
+		else
+			ret = sdp_session_attr_add_existing(session, attr);
+		if (ret < 0) {
+			sdp_attr_destroy(attr);
+			return ret;
+		}
+		break;
+	}
+	}
+
+	return 0;
+}
+
+
+static int sdp_builder_fmtp_h264(const struct sdp_h264_fmtp *fmtp,
+				 void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_h264_fmtp *dst = &builder->media->h264_fmtp;
+	struct sdp_h264_fmtp *spare = (builder->spare != NULL)
+					      ? &builder->spare->media.h264_fmtp
+					      : NULL;
+	uint8_t *sps = NULL, *pps = NULL;
+
+	if ((fmtp->sps != NULL) && (fmtp->pps != NULL)) {
+		/* Reuse the previous parameter sets buffers if large enough */
+		if ((spare != NULL) && (spare->sps != NULL) &&
+		    (spare->sps_size >= fmtp->sps_size)) {
+			sps = spare->sps;
+			spare->sps = NULL;
+		} else {
+			sps = malloc(fmtp->sps_size);
+		}
+		if ((spare != NULL) && (spare->pps != NULL) &&
+		    (spare->pps_size >= fmtp->pps_size)) {
+			pps = spare->pps;
+			spare->pps = NULL;
+		} else {
+			pps = malloc(fmtp->pps_size);
+		}
+		if ((sps == NULL) || (pps == NULL)) {
+			free(sps);
+			free(pps);
+			return -ENOMEM;
+		}
+		memcpy(sps, fmtp->sps, fmtp->sps_size);
+		memcpy(pps, fmtp->pps, fmtp->pps_size);
+	}
+
+	dst->valid = fmtp->valid;
+	dst->packetization_mode = fmtp->packetization_mode;
+	dst->profile_idc = fmtp->profile_idc;
+	dst->profile_iop = fmtp->profile_iop;
+	dst->level_idc = fmtp->level_idc;
+	if (sps != NULL) {
+		free(dst->sps);
+		free(dst->pps);
+		dst->sps = sps;
+		dst->sps_size = fmtp->sps_size;
+		dst->pps = pps;
+		dst->pps_size = fmtp->pps_size;
+	}
+
+	return 0;
+}
+
+
+/* Mark the session-level parameters undefined at media-level as inherited;
+ * they are not copied (see sdp_media_get_connection_addr(),
+ * sdp_media_get_start_mode() and sdp_media_get_rtcp_xr()) */
+static void sdp_media_inherit(struct sdp_session *session,
+			      struct sdp_media *media)
+{
+	if ((!media->connection_addr) && (session->connection_addr))
+		media->inherited |= SDP_MEDIA_INHERIT_CONNECTION_ADDR;
+	if ((media->start_mode == SDP_START_MODE_UNSPECIFIED) &&
+	    (session->start_mode != SDP_START_MODE_UNSPECIFIED))
+		media->inherited |= SDP_MEDIA_INHERIT_START_MODE;
+	if ((!media->rtcp_xr.valid) && (session->rtcp_xr.valid))
+		media->inherited |= SDP_MEDIA_INHERIT_RTCP_XR;
+}
+
+
+static int sdp_builder_raw_line(char type,
+				struct sdp_span value,
+				void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_session *session = builder->session;
+	struct sdp_media *media = builder->media;
+
+	if ((type == SDP_TYPE_MEDIA) && (media != NULL)) {
+		/* Other formats of the media line */
+		SDP_BUILDER_SET(builder, media, fmts, value);
+		return 0;
+	}
+
+	if (media) {
+		return sdp_raw_line_add(
+			&media->raw_lines, &media->raw_line_count, type, value);
+	} else {
+		return sdp_raw_line_add(&session->raw_lines,
+					&session->raw_line_count,
+					type,
+					value);
+	}
+}
+
+
+static int sdp_builder_end(int deletion, void *userdata)
+{
+	struct sdp_builder *builder = userdata;
+	struct sdp_session *session = builder->session;
+	struct sdp_media *media = NULL;
+
+	sdp_builder_spare_flush(builder);
+
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		sdp_media_inherit(session, media);
+	}
+
+	session->deletion = deletion;
+
+	return 0;
+}
+
+
+const struct sdp_read_cbs sdp_builder_cbs = {
+	.on_session_field = &sdp_builder_session_field,
+	.on_media_begin = &sdp_builder_media_begin,
+	.on_media_field = &sdp_builder_media_field,
+	.on_attr = &sdp_builder_attr,
+	.on_fmtp_h264 = &sdp_builder_fmtp_h264,
+	.on_raw_line = &sdp_builder_raw_line,
+	.on_end = &sdp_builder_end,
+};
+
+
+#define SDP_LAZY_MEDIA_MIN_SIZE 8
+
+
+void sdp_lazy_media_destroy(struct sdp_lazy_media *lazy)
+{
+	if (lazy == NULL)
+		return;
+
+	/* The built media belong to the medias list of the session */
+	free(lazy->blocks);
+	free(lazy->medias);
+	free(lazy);
+}
+
+
+static int sdp_lazy_media_add(struct sdp_lazy_media *lazy,
+			      unsigned int *size,
+			      const char *text,
+			      const char *ptr)
+{
+	struct sdp_view *blocks;
+
+	if (lazy->count == *size) {
+		*size = *size ? *size * 2 : SDP_LAZY_MEDIA_MIN_SIZE;
+		blocks = realloc(lazy->blocks, *size * sizeof(*blocks));
+		ULOG_ERRNO_RETURN_ERR_IF(blocks == NULL, ENOMEM);
+		lazy->blocks = blocks;
+	}
+	lazy->blocks[lazy->count].offset = ptr - text;
+	lazy->blocks[lazy->count].len = 0;
+	lazy->count++;
+
+	return 0;
+}
+
+
+/* Line of a media section while reading a lazy session: the session-level
+ * lines are still read in order and the connection lines count as present,
+ * as sdp_reader_line() does */
+static int sdp_lazy_media_line(struct sdp_reader *reader,
+			       struct sdp_span line,
+			       int skip_media)
+{
+	switch (line.ptr[0]) {
+	case SDP_TYPE_VERSION:
+	case SDP_TYPE_ORIGIN:
+	case SDP_TYPE_SESSION_NAME:
+	case SDP_TYPE_URI:
+	case SDP_TYPE_EMAIL:
+	case SDP_TYPE_PHONE:
+	case SDP_TYPE_TIME:
+		if (skip_media)
+			return 0;
+		return sdp_reader_line(reader, line);
+	case SDP_TYPE_CONNECTION:
+		reader->mandatory_fields |= SDP_MANDATORY_TYPE_MASK_CONNECTION;
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+
+/* Parse the session level and locate the media sections */
+static int sdp_description_parse_lazy_media(const char *text,
+					    size_t len,
+					    const struct sdp_read_opts *opts,
+					    struct sdp_builder *builder,
+					    struct sdp_reader_error *err)
+{
+	int ret;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+	struct sdp_lazy_media *lazy;
+	struct sdp_view *block = NULL;
+	enum sdp_media_type type;
+	unsigned int port, payload_type, size = 0;
+	int in_media = 0, skip_media = 0;
+
+	lazy = calloc(1, sizeof(*lazy));
+	ULOG_ERRNO_RETURN_ERR_IF(lazy == NULL, ENOMEM);
+	builder->session->lazy_media = lazy;
+	lazy->opts = *opts;
+	lazy->opts.threads = 0;
+
+	sdp_reader_init(&reader, &sdp_builder_cbs, builder, opts);
+
+	sdp_scanner_init(&scanner, text, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		/* Same line format check as sdp_reader_line() */
+		if ((line.len <= 2) || (line.ptr[1] != '='))
+			continue;
+		if (line.ptr[0] != SDP_TYPE_MEDIA) {
+			if (in_media)
+				ret = sdp_lazy_media_line(
+					&reader, line, skip_media);
+			else
+				ret = sdp_reader_line(&reader, line);
+			if (ret < 0)
+				goto out;
+			continue;
+		}
+
+		/* Media line: end the previous media section, check the media
+		 * line now and start a new section */
+		if (block != NULL)
+			block->len = line.ptr - (text + block->offset);
+		block = NULL;
+		ret = sdp_reader_media_count(&reader, line);
+		if (ret == 0) {
+			ret = sdp_media_read(&reader,
+					     sdp_span_make(line.ptr + 2,
+							   line.len - 2),
+					     &type,
+					     &port,
+					     &payload_type,
+					     NULL);
+		}
+		if (ret < 0) {
+			ret = sdp_reader_line_error(&reader, line, ret);
+			goto out;
+		}
+		in_media = 1;
+		skip_media = (opts->skip_media_types &
+			      SDP_MEDIA_TYPE_BIT(type)) != 0;
+		if (skip_media)
+			continue;
+		ret = sdp_lazy_media_add(lazy, &size, text, line.ptr);
+		if (ret < 0)
+			goto out;
+		block = &lazy->blocks[lazy->count - 1];
+	}
+	if (block != NULL)
+		block->len = len - block->offset;
+
+	if (lazy->count > 0) {
+		lazy->medias = calloc(lazy->count, sizeof(*lazy->medias));
+		if (lazy->medias == NULL) {
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+	ret = sdp_reader_finish(&reader);
+
+out:
+	if ((ret < 0) && (err != NULL))
+		*err = reader.err;
+	return ret;
+}
+
+
+int sdp_lazy_media_read(const struct sdp_lazy_media *lazy,
+			const char *text,
+			unsigned int idx,
+			struct sdp_session *session,
+			struct sdp_media **ret_obj)
+{
+	int ret;
+	struct sdp_view block = lazy->blocks[idx];
+	struct sdp_read_cbs cbs = sdp_builder_cbs;
+	struct sdp_builder builder;
+	struct sdp_reader reader;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+
+	/* The session-level lines have been read with the session */
+	cbs.on_session_field = NULL;
+	cbs.on_end = NULL;
+
+	memset(&builder, 0, sizeof(builder));
+	builder.session = session;
+	builder.skip = lazy->opts.skip;
+	builder.registry = lazy->opts.registry;
+	if (lazy->opts.flags & SDP_READ_FLAG_LAZY_ATTRS)
+		builder.text = session->text;
+	sdp_reader_init(&reader, &cbs, &builder, &lazy->opts);
+
+	sdp_scanner_init(&scanner, text + block.offset, block.len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		ret = sdp_reader_line(&reader, line);
+		if (ret < 0)
+			goto error;
+	}
+	if (builder.media == NULL) {
+		ret = -EPROTO;
+		goto error;
+	}
+
+	sdp_media_inherit(session, builder.media);
+	*ret_obj = builder.media;
+	return 0;
+
+error:
+	if (builder.media != NULL)
+		sdp_session_media_unlink(session, builder.media);
+	return ret;
+}
+
+
+static int sdp_lazy_media_build(struct sdp_session *session, unsigned int idx)
+{
+	int ret;
+	struct sdp_lazy_media *lazy = session->lazy_media;
+	struct sdp_media *media;
+	unsigned int i;
+
+	ret = sdp_lazy_media_read(lazy, session->text, idx, session, &media);
+	if (ret < 0)
+		return ret;
+
+	/* Move the media before the next built one to keep the description
+	 * order in the medias list */
+	list_del(&media->node);
+	for (i = idx + 1; i < lazy->count; i++) {
+		if (lazy->medias[i] != NULL)
+			break;
+	}
+	if (i < lazy->count)
+		list_add_before(&lazy->medias[i]->node, &media->node);
+	else
+		list_add_before(&session->medias, &media->node);
+
+	lazy->medias[idx] = media;
+	return 0;
+}
+
+
+int sdp_lazy_media_finish(struct sdp_session *session)
+{
+	int ret;
+	unsigned int i;
+
+	if (session->lazy_media == NULL)
+		return 0;
+
+	for (i = 0; i < session->lazy_media->count; i++) {
+		if (session->lazy_media->medias[i] != NULL)
+			continue;
+		ret = sdp_lazy_media_build(session, i);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* All media are in the medias list, in the description order */
+	sdp_lazy_media_destroy(session->lazy_media);
+	session->lazy_media = NULL;
+	return 0;
+}
+
+
+unsigned int sdp_session_media_get_count(const struct sdp_session *session)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(session == NULL, EINVAL, 0);
+
+	if (session->lazy_media != NULL)
+		return session->lazy_media->count;
+	return session->media_count;
+}
+
+
+int sdp_session_media_get(struct sdp_session *session,
+			  unsigned int idx,
+			  struct sdp_media **ret_obj)
+{
+	int ret;
+	struct sdp_media *media = NULL;
+
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	if (session->lazy_media != NULL) {
+		if (idx >= session->lazy_media->count)
+			return -ENOENT;
+		if (session->lazy_media->medias[idx] == NULL) {
+			ret = sdp_lazy_media_build(session, idx);
+			if (ret < 0)
+				return ret;
+		}
+		*ret_obj = session->lazy_media->medias[idx];
+		return 0;
+	}
+
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		if (idx-- == 0) {
+			*ret_obj = media;
+			return 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+
+static int sdp_description_parse_internal(const char *buf,
+					  size_t len,
+					  const struct sdp_read_cbs *cbs,
+					  void *userdata,
+					  const struct sdp_read_opts *opts,
+					  struct sdp_reader_error *err)
+{
+	int ret = 0;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+
+	sdp_reader_init(&reader, cbs, userdata, opts);
+
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		ret = sdp_reader_line(&reader, line);
+		if (ret < 0)
+			goto out;
+	}
+
+	ret = sdp_reader_finish(&reader);
+
+out:
+	if ((ret < 0) && (err != NULL))
+		*err = reader.err;
+	return ret;
+}
+
+
+int sdp_description_parse(const char *buf,
+			  size_t len,
+			  const struct sdp_read_cbs *cbs,
+			  void *userdata)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(cbs == NULL, EINVAL);
+
+	return sdp_description_parse_internal(
+		buf, len, cbs, userdata, NULL, NULL);
+}
+
+
+static int sdp_validate_attr(struct sdp_span attr_key,
+			     struct sdp_span attr_value,
+			     void *userdata)
+{
+	struct sdp_range range;
+	struct sdp_rtcp_xr xr;
+
+	(void)userdata;
+
+	/* The range and rtcp-xr attributes are checked by the session
+	 * builder, parse them in temporary objects */
+	switch (sdp_attr_key_lookup(attr_key, attr_value.len != 0)) {
+	case SDP_ATTR_KEY_RANGE:
+		memset(&range, 0, sizeof(range));
+		return sdp_range_attr_read(&range, attr_value);
+	case SDP_ATTR_KEY_RTCP_XR:
+		memset(&xr, 0, sizeof(xr));
+		return sdp_rtcp_xr_attr_read(&xr, attr_value);
+	default:
+		return 0;
+	}
+}
+
+
+static const struct sdp_read_cbs sdp_validate_cbs = {
+	.on_attr = &sdp_validate_attr,
+};
+
+
+int sdp_description_validate(const char *buf,
+			     size_t len,
+			     struct sdp_validation_report *report)
+{
+	int ret = 0;
+	struct sdp_validation_report _report;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+	const char *ctrl;
+	char *missing;
+	const struct sdp_read_opts opts = {
+		.skip = SDP_READ_SKIP_PARAM_SETS,
+	};
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+
+	if (report == NULL)
+		report = &_report;
+	memset(report, 0, sizeof(*report));
+	report->offset = len;
+
+	/* Pre-scan: reject binary data before looking at the lines; a null
+	 * character ends the description */
+	ctrl = sdp_scan_find_ctrl(buf, len);
+	if (ctrl != NULL) {
+		if (*ctrl != '\0') {
+			ULOGE("invalid character 0x%02x at offset %zu",
+			      (unsigned char)*ctrl,
+			      (size_t)(ctrl - buf));
+			report->offset = ctrl - buf;
+			ret = -EPROTO;
+			goto out;
+		}
+		len = ctrl - buf;
+		report->offset = len;
+	}
+
+	sdp_reader_init(&reader, &sdp_validate_cbs, NULL, &opts);
+
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		report->line_count++;
+		/* Lines must be in the form "<type>=<value>" with <type> being
+		 * a lowercase letter */
+		if ((line.len < 2) || (line.ptr[0] < 'a') ||
+		    (line.ptr[0] > 'z') || (line.ptr[1] != '=')) {
+			ULOGE("invalid line '%.*s'", (int)line.len, line.ptr);
+			ret = -EPROTO;
+		} else {
+			if (line.ptr[0] == SDP_TYPE_MEDIA)
+				report->media_count++;
+			ret = sdp_reader_line(&reader, line);
+		}
+		if (ret < 0) {
+			report->offset = line.ptr - buf;
+			goto out;
+		}
+	}
+
+	ret = sdp_reader_finish(&reader);
+	if (ret < 0) {
+		missing = report->missing;
+		if (!(reader.mandatory_fields &
+		      SDP_MANDATORY_TYPE_MASK_VERSION))
+			*missing++ = SDP_TYPE_VERSION;
+		if (!(reader.mandatory_fields & SDP_MANDATORY_TYPE_MASK_ORIGIN))
+			*missing++ = SDP_TYPE_ORIGIN;
+		if (!(reader.mandatory_fields &
+		      SDP_MANDATORY_TYPE_MASK_SESSION_NAME))
+			*missing++ = SDP_TYPE_SESSION_NAME;
+		if (!(reader.mandatory_fields &
+		      SDP_MANDATORY_TYPE_MASK_CONNECTION))
+			*missing++ = SDP_TYPE_CONNECTION;
+		if (!(reader.mandatory_fields & SDP_MANDATORY_TYPE_MASK_TIME))
+			*missing++ = SDP_TYPE_TIME;
+	}
+
+out:
+	report->status = ret;
+	return ret;
+}
+
+
+/* Origin of a session description found by sdp_description_peek() */
+struct sdp_peek {
+	int origin;
+	uint64_t session_id;
+	uint64_t session_version;
+	struct sdp_span server_addr;
+};
+
+
+static int sdp_peek_session_field(const struct sdp_field *field,
+				  void *userdata)
+{
+	struct sdp_peek *peek = userdata;
+
+	if (field->type != SDP_TYPE_ORIGIN)
+		return 0;
+
+	peek->origin = 1;
+	peek->session_id = field->session_id;
+	peek->session_version = field->session_version;
+	peek->server_addr = field->value;
+
+	return 0;
+}
+
+
+static const struct sdp_read_cbs sdp_peek_cbs = {
+	.on_session_field = &sdp_peek_session_field,
+};
+
+
+int sdp_description_peek(const char *buf,
+			 size_t len,
+			 uint64_t *session_id,
+			 uint64_t *session_version,
+			 int *deletion,
+			 struct sdp_span *server_addr)
+{
+	int ret, other = 0;
+	struct sdp_peek peek;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+
+	memset(&peek, 0, sizeof(peek));
+	sdp_reader_init(&reader, &sdp_peek_cbs, &peek, NULL);
+
+	/* A deletion description only has the origin field: stop at the
+	 * first other mandatory field once the origin is known */
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		/* Same line format check as sdp_reader_line() */
+		if ((line.len <= 2) || (line.ptr[1] != '='))
+			continue;
+		switch (line.ptr[0]) {
+		case SDP_TYPE_ORIGIN:
+			if (peek.origin)
+				break;
+			ret = sdp_reader_line(&reader, line);
+			if (ret < 0)
+				return ret;
+			break;
+		case SDP_TYPE_VERSION:
+		case SDP_TYPE_SESSION_NAME:
+		case SDP_TYPE_CONNECTION:
+		case SDP_TYPE_TIME:
+			other = 1;
+			break;
+		default:
+			break;
+		}
+		if ((peek.origin) && (other))
+			break;
+	}
+
+	if (!peek.origin) {
+		ULOGE("missing mandatory field origin (o=)");
+		return -EPROTO;
+	}
+
+	if (session_id != NULL)
+		*session_id = peek.session_id;
+	if (session_version != NULL)
+		*session_version = peek.session_version;
+	if (deletion != NULL)
+		*deletion = !other;
+	if (server_addr != NULL)
+		*server_addr = peek.server_addr;
+
+	return 0;
+}
+
+
+#define SDP_LINES_MIN_SIZE 32
+
+
+/* Keep a copy of the source text in the session and index its lines */
+static int sdp_session_keep_text(struct sdp_session *session,
+				 const char *buf,
+				 size_t len)
+{
+	const char *nul;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_view *lines;
+	unsigned int size = 0;
+
+	/* Nothing is read past a null character */
+	nul = memchr(buf, '\0', len);
+	if (nul != NULL)
+		len = nul - buf;
+	ULOG_ERRNO_RETURN_ERR_IF(len > UINT32_MAX, E2BIG);
+
+	session->text = malloc(len + 1);
+	ULOG_ERRNO_RETURN_ERR_IF(session->text == NULL, ENOMEM);
+	memcpy(session->text, buf, len);
+	session->text[len] = '\0';
+	session->text_len = len;
+
+	sdp_scanner_init(&scanner, session->text, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		if (session->line_count == size) {
+			size = size ? size * 2 : SDP_LINES_MIN_SIZE;
+			lines = realloc(session->lines, size * sizeof(*lines));
+			ULOG_ERRNO_RETURN_ERR_IF(lines == NULL, ENOMEM);
+			session->lines = lines;
+		}
+		lines = &session->lines[session->line_count++];
+		lines->offset = line.ptr - session->text;
+		lines->len = line.len;
+	}
+
+	/* Shrink the index to its actual size */
+	if ((session->line_count > 0) && (session->line_count < size)) {
+		lines = realloc(session->lines,
+				session->line_count * sizeof(*lines));
+		if (lines != NULL)
+			session->lines = lines;
+	}
+
+	return 0;
+}
+
+
+int sdp_description_read_err(const char *buf,
+			     size_t len,
+			     const struct sdp_read_opts *opts,
+			     struct sdp_session **ret_obj,
+			     struct sdp_error *error)
+{
+	int ret;
+	struct sdp_builder builder;
+	struct sdp_reader_error err;
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	memset(&err, 0, sizeof(err));
+	memset(&builder, 0, sizeof(builder));
+	if ((opts != NULL) && (opts->limits.max_input_size != 0) &&
+	    (len > opts->limits.max_input_size)) {
+		ULOGE("description too large (%zu bytes, max %zu)",
+		      len,
+		      opts->limits.max_input_size);
+		err.reason = SDP_ERROR_REASON_LIMIT;
+		ret = -E2BIG;
+		goto error;
+	}
+	builder.session = sdp_session_new();
+	if (builder.session == NULL) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	if (opts != NULL) {
+		builder.skip = opts->skip;
+		builder.registry = opts->registry;
+	}
+
+	if ((opts != NULL) &&
+	    (opts->flags &
+	     (SDP_READ_FLAG_LAZY_ATTRS | SDP_READ_FLAG_LAZY_MEDIA))) {
+		/* Parse the copy, the attributes are views into it */
+		ret = sdp_session_keep_text(builder.session, buf, len);
+		if (ret < 0)
+			goto error;
+		buf = builder.session->text;
+		len = builder.session->text_len;
+		builder.text = buf;
+	}
+
+	if ((opts != NULL) && (opts->flags & SDP_READ_FLAG_LAZY_MEDIA)) {
+		ret = sdp_description_parse_lazy_media(
+			buf, len, opts, &builder, &err);
+	} else if ((opts != NULL) && (opts->threads > 1)) {
+		ret = sdp_description_read_parallel(
+			buf, len, opts, &builder, &err);
+	} else {
+		ret = sdp_description_parse_internal(
+			buf, len, &sdp_builder_cbs, &builder, opts, &err);
+	}
+	if (ret < 0)
+		goto error;
+
+	*ret_obj = builder.session;
+	return 0;
+
+error:
+	/* Locate the error before the source text copy is freed */
+	if (error != NULL)
+		sdp_reader_error_locate(&err, buf, ret, error);
+	sdp_session_destroy(builder.session);
+	return ret;
+}
+
+
+int sdp_description_read_opts(const char *buf,
+			      size_t len,
+			      const struct sdp_read_opts *opts,
+			      struct sdp_session **ret_obj)
+{
+	return sdp_description_read_err(buf, len, opts, ret_obj, NULL);
+}
+
+
+int sdp_description_read_n(const char *buf,
+			   size_t len,
+			   struct sdp_session **ret_obj)
+{
+	return sdp_description_read_opts(buf, len, NULL, ret_obj);
+}
+
+
+int sdp_description_read(const char *session_desc, struct sdp_session **ret_obj)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(session_desc == NULL, EINVAL);
+
+	return sdp_description_read_n(
+		session_desc, strlen(session_desc), ret_obj);
 }
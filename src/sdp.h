@@ -30,7 +30,7 @@
 
 #include <errno.h>
 #include <libsdp.h>
-#include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,8 +40,23 @@
 #define ULOG_TAG sdp
 #include <ulog.h>
 
+/* Build with SDP_DISABLE_DEBUG_LOGS defined to compile out the debug logs,
+ * the format of their arguments is still checked */
+#ifdef SDP_DISABLE_DEBUG_LOGS
+#	undef ULOGD
+#	define ULOGD(...)                                                      \
+		do {                                                           \
+			if (0)                                                 \
+				printf(__VA_ARGS__);                           \
+		} while (0)
+#endif /* SDP_DISABLE_DEBUG_LOGS */
+
 #define SDP_DEFAULT_LEN 1024
 
+#define SDP_DEFAULT_CHUNK_COUNT 64
+
+#define SDP_ARRAY_SIZE(_a) (sizeof(_a) / sizeof((_a)[0]))
+
 #define SDP_NTP_TO_UNIX_OFFSET 2208988800ULL
 
 #define SDP_CRLF "\r\n"
@@ -138,50 +153,216 @@
 	} while (0)
 
 
+/* Strings of the session at least this long are referenced in place by
+ * the scatter/gather writer instead of being copied */
+#define SDP_EMIT_REF_MIN_LEN 32
+
+
+/* Chunk of a scatter/gather output: either a string of the session, or
+ * the next bytes of the scratch area ('base' NULL, as the scratch area
+ * can move while it grows) */
+struct sdp_chunk {
+	const char *base;
+	size_t len;
+};
+
+
+/* Output of the writer: a heap buffer grown as needed, a buffer of the
+ * caller that is never reallocated ('fixed' set, -ENOBUFS when full), or
+ * only the length of the output ('str' NULL). With 'chunks' set, the
+ * output is a list of chunks and the heap buffer is only the scratch area
+ * of the copied bytes. The buffer is always null-terminated. Errors are
+ * sticky: once an append fails the next ones do nothing and return the
+ * same error, so that a whole line can be checked once at its end. */
 struct sdp_string {
 	char *str;
 	size_t len;
 	size_t max_len;
+	int fixed;
+	int err;
+	struct sdp_chunk *chunks;
+	size_t chunk_count;
+	size_t chunk_max;
 };
 
 
-static inline int __attribute__((__format__(__printf__, 2, 0)))
-sdp_vsprintf(struct sdp_string *str, const char *fmt, va_list args)
-{
-	if (str->len >= str->max_len)
-		return -ENOBUFS;
-	size_t available = str->max_len - str->len;
-	int len = vsnprintf(str->str + str->len, available, fmt, args);
-	if (len < 0)
-		return len;
-	if (len >= (int)available) {
-		size_t new_len = (str->len + len + 1024) & ~1023;
-		void *tmp = realloc(str->str, new_len);
-		if (!tmp)
-			return -ENOMEM;
-		str->str = tmp;
-		str->max_len = new_len;
-		return -EAGAIN;
+/* Make room for 'size' more bytes plus the null character; the heap
+ * buffer size is doubled as needed */
+static inline int sdp_string_reserve(struct sdp_string *str, size_t size)
+{
+	size_t new_len;
+	void *tmp;
+
+	if (str->err < 0)
+		return str->err;
+	if ((str->str == NULL) || (str->max_len - str->len > size))
+		return 0;
+	if (str->fixed) {
+		str->err = -ENOBUFS;
+		return str->err;
 	}
-	str->len += len;
+	new_len = (str->max_len > 0) ? str->max_len : SDP_DEFAULT_LEN;
+	while (new_len - str->len <= size)
+		new_len *= 2;
+	tmp = realloc(str->str, new_len);
+	if (!tmp) {
+		str->err = -ENOMEM;
+		return str->err;
+	}
+	str->str = tmp;
+	str->max_len = new_len;
 	return 0;
 }
 
 
-static inline int FUTILS_ATTRIBUTE_FORMAT_PRINTF(2, 3)
-	sdp_sprintf(struct sdp_string *str, const char *fmt, ...)
+static inline int
+sdp_string_chunk_add(struct sdp_string *str, const char *base, size_t len)
 {
-	int ret;
-	va_list args;
-	va_start(args, fmt);
-	ret = sdp_vsprintf(str, fmt, args);
-	va_end(args);
-	if (ret == -EAGAIN) {
-		va_start(args, fmt);
-		ret = sdp_vsprintf(str, fmt, args);
-		va_end(args);
+	size_t new_max;
+	void *tmp;
+
+	if (str->chunk_count == str->chunk_max) {
+		new_max = 2 * str->chunk_max;
+		tmp = realloc(str->chunks, new_max * sizeof(*str->chunks));
+		if (!tmp) {
+			str->err = -ENOMEM;
+			return str->err;
+		}
+		str->chunks = tmp;
+		str->chunk_max = new_max;
 	}
-	return ret;
+	str->chunks[str->chunk_count].base = base;
+	str->chunks[str->chunk_count].len = len;
+	str->chunk_count++;
+	return 0;
+}
+
+
+/* Account for 'len' bytes written at the end of the buffer (room must have
+ * been made with sdp_string_reserve()) */
+static inline int sdp_string_commit(struct sdp_string *str, size_t len)
+{
+	struct sdp_chunk *last;
+
+	if (str->err < 0)
+		return str->err;
+	if (str->str != NULL)
+		str->str[str->len + len] = '\0';
+	str->len += len;
+	if ((str->chunks == NULL) || (len == 0))
+		return 0;
+	last = (str->chunk_count > 0) ? &str->chunks[str->chunk_count - 1]
+				       : NULL;
+	if ((last != NULL) && (last->base == NULL)) {
+		last->len += len;
+		return 0;
+	}
+	return sdp_string_chunk_add(str, NULL, len);
+}
+
+
+static inline int sdp_emit(struct sdp_string *str, const char *s, size_t len)
+{
+	if (sdp_string_reserve(str, len) < 0)
+		return str->err;
+	if (str->str != NULL)
+		memcpy(str->str + str->len, s, len);
+	return sdp_string_commit(str, len);
+}
+
+
+/* String that lives as long as the session: referenced in place by the
+ * scatter/gather writer when long enough, copied otherwise */
+static inline int
+sdp_emit_ref(struct sdp_string *str, const char *s, size_t len)
+{
+	if ((str->chunks == NULL) || (len < SDP_EMIT_REF_MIN_LEN))
+		return sdp_emit(str, s, len);
+	if (str->err < 0)
+		return str->err;
+	return sdp_string_chunk_add(str, s, len);
+}
+
+
+static inline int sdp_emit_ref_str(struct sdp_string *str, const char *s)
+{
+	return sdp_emit_ref(str, s, strlen(s));
+}
+
+
+static inline int sdp_emit_ref_span(struct sdp_string *str,
+				    struct sdp_span span)
+{
+	return sdp_emit_ref(str, span.ptr, span.len);
+}
+
+
+/* String literal, its length being known at compile time */
+#define sdp_emit_lit(_str, _lit) sdp_emit(_str, "" _lit, sizeof(_lit) - 1)
+
+
+static inline int sdp_emit_str(struct sdp_string *str, const char *s)
+{
+	return sdp_emit(str, s, strlen(s));
+}
+
+
+static inline int sdp_emit_span(struct sdp_string *str, struct sdp_span span)
+{
+	return sdp_emit(str, span.ptr, span.len);
+}
+
+
+static inline int sdp_emit_char(struct sdp_string *str, char c)
+{
+	return sdp_emit(str, &c, 1);
+}
+
+
+/* Start of a line: <type>= */
+static inline int sdp_emit_type(struct sdp_string *str, char type)
+{
+	char field[2] = {type, '='};
+	return sdp_emit(str, field, sizeof(field));
+}
+
+
+static inline int sdp_emit_crlf(struct sdp_string *str)
+{
+	return sdp_emit_lit(str, SDP_CRLF);
+}
+
+
+/* Decimal value, left-padded with zeros to at least 'width' digits */
+static inline int
+sdp_emit_uint(struct sdp_string *str, uint64_t val, unsigned int width)
+{
+	char buf[20];
+	size_t i = sizeof(buf);
+
+	do {
+		buf[--i] = '0' + val % 10;
+		val /= 10;
+	} while ((i > 0) && ((val != 0) || (sizeof(buf) - i < width)));
+	return sdp_emit(str, buf + i, sizeof(buf) - i);
+}
+
+
+static inline int sdp_emit_int(struct sdp_string *str, int64_t val)
+{
+	if (val >= 0)
+		return sdp_emit_uint(str, (uint64_t)val, 0);
+	sdp_emit_char(str, '-');
+	return sdp_emit_uint(str, -(uint64_t)val, 0);
+}
+
+
+/* Byte in upper case hexadecimal, 2 digits */
+static inline int sdp_emit_hex8(struct sdp_string *str, uint8_t val)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	char buf[2] = {digits[val >> 4], digits[val & 0xF]};
+	return sdp_emit(str, buf, sizeof(buf));
 }
 
 
@@ -191,9 +372,558 @@ static inline char *xstrdup(const char *s)
 }
 
 
+static inline struct sdp_span sdp_span_make(const char *ptr, size_t len)
+{
+	struct sdp_span span = {.ptr = ptr, .len = len};
+	return span;
+}
+
+
+static inline int sdp_span_eq(struct sdp_span span, const char *str)
+{
+	size_t len = strlen(str);
+	return (span.len == len) && (memcmp(span.ptr, str, len) == 0);
+}
+
+
+#define SDP_SCAN_BLOCK_SIZE 64
+
+/* Below this length, a plain loop beats the vectorized search setup */
+#define SDP_SCAN_FIND_MIN_LEN 16
+
+
+const char *sdp_scan_find(const char *ptr, size_t len, char c);
+
+
+/* Finds the first control character other than TAB, CR and LF (including
+ * the null character and DEL), returns NULL if there is none */
+const char *sdp_scan_find_ctrl(const char *ptr, size_t len);
+
+
+/* Returns a pointer to the first occurrence of 'c' in the span, or NULL */
+static inline const char *sdp_span_find(struct sdp_span span, char c)
+{
+	size_t i;
+
+	if (span.len >= SDP_SCAN_FIND_MIN_LEN)
+		return sdp_scan_find(span.ptr, span.len, c);
+	for (i = 0; i < span.len; i++) {
+		if (span.ptr[i] == c)
+			return span.ptr + i;
+	}
+	return NULL;
+}
+
+
+/* Same behavior as strtok_r(): leading delimiters are skipped, the token
+ * ends at the next delimiter (which is consumed) or at the end of 'src' */
+static inline struct sdp_span sdp_span_tok(struct sdp_span *src, char delim)
+{
+	struct sdp_span tok;
+	const char *p;
+
+	while ((src->len > 0) && (*src->ptr == delim)) {
+		src->ptr++;
+		src->len--;
+	}
+	tok.ptr = src->ptr;
+	p = sdp_span_find(*src, delim);
+	if (p == NULL) {
+		tok.len = src->len;
+		src->ptr += src->len;
+		src->len = 0;
+	} else {
+		tok.len = p - src->ptr;
+		src->len -= tok.len + 1;
+		src->ptr = p + 1;
+	}
+	return tok;
+}
+
+
+/* Same behavior as strchr() + '\0' replacement: 'span' is truncated before
+ * the first 'delim' and the remainder is returned (empty if not found) */
+static inline struct sdp_span sdp_span_split(struct sdp_span *span, char delim)
+{
+	struct sdp_span rest;
+	const char *p = sdp_span_find(*span, delim);
+
+	if (p == NULL) {
+		rest.ptr = span->ptr + span->len;
+		rest.len = 0;
+		return rest;
+	}
+	rest.ptr = p + 1;
+	rest.len = span->len - (rest.ptr - span->ptr);
+	span->len = p - span->ptr;
+	return rest;
+}
+
+
+static inline int sdp_span_has(struct sdp_span span, char c)
+{
+	return sdp_span_find(span, c) != NULL;
+}
+
+
+/* Returns NULL for an empty span, like xstrdup() does for a NULL string */
+static inline char *sdp_span_strdup(struct sdp_span span)
+{
+	char *s;
+
+	if (span.len == 0)
+		return NULL;
+	s = malloc(span.len + 1);
+	if (s == NULL)
+		return NULL;
+	memcpy(s, span.ptr, span.len);
+	s[span.len] = '\0';
+	return s;
+}
+
+
+/* Replaces the string pointed by 'dst' by a copy of the span */
+static inline void sdp_span_set(char **dst, struct sdp_span span)
+{
+	free(*dst);
+	*dst = sdp_span_strdup(span);
+}
+
+
+/* String or view of a lazy attribute */
+static inline struct sdp_span sdp_attr_span(const struct sdp_attr *attr,
+					    const char *str,
+					    struct sdp_view view)
+{
+	if (str != NULL)
+		return sdp_span_make(str, strlen(str));
+	if (attr->text != NULL)
+		return sdp_span_make(attr->text + view.offset, view.len);
+	return sdp_span_make(NULL, 0);
+}
+
+
+static inline struct sdp_span sdp_attr_key_span(const struct sdp_attr *attr)
+{
+	return sdp_attr_span(attr, attr->key, attr->key_view);
+}
+
+
+static inline struct sdp_span sdp_attr_value_span(const struct sdp_attr *attr)
+{
+	return sdp_attr_span(attr, attr->value, attr->value_view);
+}
+
+
+/**
+ * Span number parsers: the number must start at the beginning of the span,
+ * with no leading space nor sign. They do not depend on the locale and
+ * return the number of bytes consumed (> 0), -EINVAL if the span does not
+ * start with a digit or -ERANGE if the value is greater than 'max'.
+ */
+static inline int
+sdp_span_parse_u64(struct sdp_span span, uint64_t max, uint64_t *val)
+{
+	const uint64_t max_10 = max / 10;
+	const unsigned int max_digit = (unsigned int)(max % 10);
+	uint64_t v = 0;
+	size_t i;
+
+	for (i = 0; i < span.len; i++) {
+		unsigned int d = (unsigned char)span.ptr[i] - '0';
+		if (d > 9)
+			break;
+		if ((v > max_10) || ((v == max_10) && (d > max_digit)))
+			return -ERANGE;
+		v = v * 10 + d;
+	}
+	if (i == 0)
+		return -EINVAL;
+	*val = v;
+	return (int)i;
+}
+
+
+static inline int
+sdp_span_parse_u32(struct sdp_span span, uint32_t max, uint32_t *val)
+{
+	uint64_t v;
+	int ret = sdp_span_parse_u64(span, max, &v);
+	if (ret > 0)
+		*val = (uint32_t)v;
+	return ret;
+}
+
+
+static inline int
+sdp_span_parse_hex(struct sdp_span span, uint64_t max, uint64_t *val)
+{
+	uint64_t v = 0;
+	size_t i;
+
+	for (i = 0; i < span.len; i++) {
+		unsigned int c = (unsigned char)span.ptr[i];
+		unsigned int d;
+		if (c - '0' <= 9)
+			d = c - '0';
+		else if ((c | 0x20) - 'a' <= 5)
+			d = (c | 0x20) - 'a' + 10;
+		else
+			break;
+		if (v > (max >> 4))
+			return -ERANGE;
+		v = (v << 4) | d;
+		if (v > max)
+			return -ERANGE;
+	}
+	if (i == 0)
+		return -EINVAL;
+	*val = v;
+	return (int)i;
+}
+
+
+/* Same as sdp_span_parse_u64()/sdp_span_parse_u32(), but the whole span must
+ * be the number; returns 0 on success */
+static inline int
+sdp_span_to_u64(struct sdp_span span, uint64_t max, uint64_t *val)
+{
+	int ret = sdp_span_parse_u64(span, max, val);
+	if (ret < 0)
+		return ret;
+	return ((size_t)ret == span.len) ? 0 : -EINVAL;
+}
+
+
+static inline int
+sdp_span_to_u32(struct sdp_span span, uint32_t max, uint32_t *val)
+{
+	int ret = sdp_span_parse_u32(span, max, val);
+	if (ret < 0)
+		return ret;
+	return ((size_t)ret == span.len) ? 0 : -EINVAL;
+}
+
+
+/* Attribute keys handled by the reader */
+enum sdp_attr_key {
+	SDP_ATTR_KEY_UNKNOWN = 0,
+	SDP_ATTR_KEY_TOOL,
+	SDP_ATTR_KEY_RECVONLY,
+	SDP_ATTR_KEY_SENDRECV,
+	SDP_ATTR_KEY_SENDONLY,
+	SDP_ATTR_KEY_INACTIVE,
+	SDP_ATTR_KEY_TYPE,
+	SDP_ATTR_KEY_CHARSET,
+	SDP_ATTR_KEY_RTPAVP_RTPMAP,
+	SDP_ATTR_KEY_FMTP,
+	SDP_ATTR_KEY_CONTROL_URL,
+	SDP_ATTR_KEY_RANGE,
+	SDP_ATTR_KEY_RTCP_PORT,
+	SDP_ATTR_KEY_RTCP_XR,
+};
+
+
+/* The attribute is only recognized when it has a value */
+#define SDP_ATTR_KEY_FLAG_VALUE (1 << 0)
+
+struct sdp_attr_key_entry {
+	const char *str;
+	uint8_t len;
+	uint8_t flags;
+	uint8_t key;
+};
+
+/**
+ * Perfect hash of the attribute keys handled by the reader:
+ * (key[0] + 2 * key[len - 1] + 4 * len) % 32 is unique for each of them,
+ * so a lookup is one hash, one length check and one memcmp() whatever the
+ * number of keys. When adding a key, the constants must be adjusted if its
+ * slot is already taken ('sdp-bench attr' checks that every key is found).
+ */
+#define SDP_ATTR_KEY_HASH(_str, _len)                                          \
+	(((uint8_t)(_str)[0] + 2 * (uint8_t)(_str)[(_len)-1] + 4 * (_len)) &   \
+	 31)
+
+static const struct sdp_attr_key_entry sdp_attr_keys[32] = {
+	[2] = {SDP_ATTR_RTCP_PORT,
+	       sizeof(SDP_ATTR_RTCP_PORT) - 1,
+	       SDP_ATTR_KEY_FLAG_VALUE,
+	       SDP_ATTR_KEY_RTCP_PORT},
+	[4] = {SDP_ATTR_RECVONLY,
+	       sizeof(SDP_ATTR_RECVONLY) - 1,
+	       0,
+	       SDP_ATTR_KEY_RECVONLY},
+	[5] = {SDP_ATTR_SENDONLY,
+	       sizeof(SDP_ATTR_SENDONLY) - 1,
+	       0,
+	       SDP_ATTR_KEY_SENDONLY},
+	[7] = {SDP_ATTR_CHARSET,
+	       sizeof(SDP_ATTR_CHARSET) - 1,
+	       0,
+	       SDP_ATTR_KEY_CHARSET},
+	[10] = {SDP_ATTR_RTPAVP_RTPMAP,
+		sizeof(SDP_ATTR_RTPAVP_RTPMAP) - 1,
+		SDP_ATTR_KEY_FLAG_VALUE,
+		SDP_ATTR_KEY_RTPAVP_RTPMAP},
+	[14] = {SDP_ATTR_TYPE,
+		sizeof(SDP_ATTR_TYPE) - 1,
+		0,
+		SDP_ATTR_KEY_TYPE},
+	[16] = {SDP_ATTR_RANGE,
+		sizeof(SDP_ATTR_RANGE) - 1,
+		SDP_ATTR_KEY_FLAG_VALUE,
+		SDP_ATTR_KEY_RANGE},
+	[18] = {SDP_ATTR_RTCP_XR,
+		sizeof(SDP_ATTR_RTCP_XR) - 1,
+		SDP_ATTR_KEY_FLAG_VALUE,
+		SDP_ATTR_KEY_RTCP_XR},
+	[19] = {SDP_ATTR_INACTIVE,
+		sizeof(SDP_ATTR_INACTIVE) - 1,
+		0,
+		SDP_ATTR_KEY_INACTIVE},
+	[22] = {SDP_ATTR_FMTP,
+		sizeof(SDP_ATTR_FMTP) - 1,
+		SDP_ATTR_KEY_FLAG_VALUE,
+		SDP_ATTR_KEY_FMTP},
+	[23] = {SDP_ATTR_CONTROL_URL,
+		sizeof(SDP_ATTR_CONTROL_URL) - 1,
+		0,
+		SDP_ATTR_KEY_CONTROL_URL},
+	[28] = {SDP_ATTR_TOOL,
+		sizeof(SDP_ATTR_TOOL) - 1,
+		0,
+		SDP_ATTR_KEY_TOOL},
+	[31] = {SDP_ATTR_SENDRECV,
+		sizeof(SDP_ATTR_SENDRECV) - 1,
+		0,
+		SDP_ATTR_KEY_SENDRECV},
+};
+
+
+static inline enum sdp_attr_key sdp_attr_key_lookup(struct sdp_span key,
+						    int has_value)
+{
+	const struct sdp_attr_key_entry *entry;
+
+	if (key.len == 0)
+		return SDP_ATTR_KEY_UNKNOWN;
+	entry = &sdp_attr_keys[SDP_ATTR_KEY_HASH(key.ptr, key.len)];
+	if ((entry->len != key.len) || (memcmp(entry->str, key.ptr, key.len)))
+		return SDP_ATTR_KEY_UNKNOWN;
+	if ((entry->flags & SDP_ATTR_KEY_FLAG_VALUE) && (!has_value))
+		return SDP_ATTR_KEY_UNKNOWN;
+	return (enum sdp_attr_key)entry->key;
+}
+
+
+/* Line scanner: iterates over the lines of a session description; lines are
+ * separated by any run of CR and LF characters, a null character ends the
+ * description. The line delimiters are located by classifying the input in
+ * blocks of SDP_SCAN_BLOCK_SIZE bytes into bitmasks (SIMD-accelerated when
+ * available, see sdp_scan.c); the mask of the current block is kept so that
+ * consecutive lines in the same block are found without rescanning. */
+struct sdp_scanner {
+	const char *buf;
+	size_t len;
+	size_t pos;
+	size_t block;
+	uint64_t mask;
+};
+
+
+void sdp_scanner_init(struct sdp_scanner *scanner, const char *buf, size_t len);
+
+
+int sdp_scanner_next_line(struct sdp_scanner *scanner, struct sdp_span *line);
+
+
+#ifdef SDP_TEST_HOOKS
+/* Test hook, only built in tests/sdp_check.c (see atom.mk): select the
+ * delimiter scan implementation by name for the whole library (not
+ * thread-safe), returns -ENOENT if it is not built in and -ENOTSUP if the
+ * CPU does not support it */
+int sdp_scan_select(const char *name);
+#endif /* SDP_TEST_HOOKS */
+
+
+/* First error of a reader, in the source text */
+struct sdp_reader_error {
+	enum sdp_error_reason reason;
+	/* Line type, or type of the missing mandatory field */
+	char type;
+	/* Start of the line and position of the error in the line, NULL if
+	 * the error is not related to a line */
+	const char *line;
+	const char *pos;
+};
+
+
+/* Reader state, carried from one line to the next */
+struct sdp_reader {
+	const struct sdp_read_cbs *cbs;
+	void *userdata;
+	struct sdp_read_opts opts;
+	uint32_t mandatory_fields;
+	/* Current media, payload type from the m= line */
+	int in_media;
+	int skip_media;
+	unsigned int payload_type;
+	int h264;
+	/* Resources used so far, see struct sdp_read_limits */
+	unsigned int media_count;
+	unsigned int attr_count;
+	size_t heap_size;
+	struct sdp_reader_error err;
+};
+
+
+void sdp_reader_init(struct sdp_reader *reader,
+		     const struct sdp_read_cbs *cbs,
+		     void *userdata,
+		     const struct sdp_read_opts *opts);
+
+
+int sdp_reader_line(struct sdp_reader *reader, struct sdp_span line);
+
+
+int sdp_reader_finish(struct sdp_reader *reader);
+
+
+/* Record the line of the first error of the reader; errors without a
+ * specific reason (callbacks) are located at the line value. Returns
+ * 'ret' */
+int sdp_reader_line_error(struct sdp_reader *reader,
+			  struct sdp_span line,
+			  int ret);
+
+
+/* Account memory of the session object against the heap limit; 'pos' is
+ * the position of the error in the current line, NULL if none */
+int sdp_reader_alloc(struct sdp_reader *reader, size_t size, const char *pos);
+
+
+/* Count a media line against the media limit */
+int sdp_reader_media_count(struct sdp_reader *reader, struct sdp_span line);
+
+
+/* Media sections of a session read with SDP_READ_FLAG_LAZY_MEDIA */
+struct sdp_lazy_media {
+	/* Options to build the media with */
+	struct sdp_read_opts opts;
+	unsigned int count;
+	/* Media sections in the source text of the session */
+	struct sdp_view *blocks;
+	/* Built media, NULL if not built yet */
+	struct sdp_media **medias;
+};
+
+
+void sdp_lazy_media_destroy(struct sdp_lazy_media *lazy);
+
+
+/* Build the media not built yet of a lazy session and drop its lazy state,
+ * before the media indexes change; no-op if the session is not lazy */
+int sdp_lazy_media_finish(struct sdp_session *session);
+
+
+/* Add a media at the end of the medias list of a session being read, without
+ * building the media of a lazy session */
+void sdp_session_media_append(struct sdp_session *session,
+			      struct sdp_media *media);
+
+
+/* Build the media section 'idx' of the source text of a lazy session at the
+ * end of the medias list of 'session'; its attributes are views into the
+ * source text only if 'session' keeps it */
+int sdp_lazy_media_read(const struct sdp_lazy_media *lazy,
+			const char *text,
+			unsigned int idx,
+			struct sdp_session *session,
+			struct sdp_media **ret_obj);
+
+
+/* Type registered for an attribute key, NULL if none */
+const struct sdp_attr_type *
+sdp_attr_registry_lookup(const struct sdp_attr_registry *registry,
+			 struct sdp_span key);
+
+
+/* Objects and strings of a previous description, reused by the builder
+ * instead of allocating new ones (see sdp_builder_reuse()) */
+struct sdp_builder_spare {
+	/* Strings of the session; the attrs and medias lists hold the spare
+	 * attribute and media objects */
+	struct sdp_session session;
+	/* Strings and parameter sets of the current media */
+	struct sdp_media media;
+};
+
+
+/* Session tree builder, consumer of the reader events */
+struct sdp_builder {
+	struct sdp_session *session;
+	struct sdp_media *media;
+	/* Bitfield of enum sdp_read_skip values */
+	uint32_t skip;
+	/* Reused objects and strings, NULL if the session is built from
+	 * scratch */
+	struct sdp_builder_spare *spare;
+	/* Source text for lazy attributes, NULL if the attributes are
+	 * copied */
+	const char *text;
+	/* Typed attributes to decode, NULL if none */
+	const struct sdp_attr_registry *registry;
+};
+
+
+extern const struct sdp_read_cbs sdp_builder_cbs;
+
+
+void sdp_builder_spare_init(struct sdp_builder_spare *spare);
+
+
+/* Move the content of an existing session to the spare objects and strings
+ * and build the next description into this session */
+void sdp_builder_reuse(struct sdp_builder *builder,
+		       struct sdp_session *session,
+		       struct sdp_builder_spare *spare);
+
+
+/* Free the spare objects and strings that were not reused */
+void sdp_builder_spare_flush(struct sdp_builder *builder);
+
+
+/* Minimum number of media sections for sdp_description_read_parallel() to
+ * dispatch them to worker threads */
+#define SDP_READ_PARALLEL_MIN_MEDIAS 8
+
+/* Maximum number of threads of sdp_description_read_parallel() */
+#define SDP_READ_PARALLEL_MAX_THREADS 16
+
+
+/* 'err' gets the first error in the description order (optional) */
+int sdp_description_read_parallel(const char *buf,
+				  size_t len,
+				  const struct sdp_read_opts *opts,
+				  struct sdp_builder *builder,
+				  struct sdp_reader_error *err);
+
+
 int sdp_base64_encode(const void *data, size_t size, char **out);
 
-int sdp_base64_decode(const char *str, void **out, size_t *out_size);
+#define SDP_BASE64_DECODED_SIZE(_len) (((_len) / 4) * 3)
+
+int sdp_base64_decode_buf(const char *str,
+			  size_t len,
+			  void *buf,
+			  size_t size,
+			  size_t *out_size);
+
+int sdp_base64_decode(const char *str,
+		      size_t len,
+		      void **out,
+		      size_t *out_size);
 
 
 #endif /* !_SDP_H_ */
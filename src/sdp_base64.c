@@ -94,13 +94,17 @@ int sdp_base64_encode(const void *data, size_t size, char **out)
 }
 
 
-int sdp_base64_decode(const char *str, void **out, size_t *out_size)
+int sdp_base64_decode_buf(const char *str,
+			  size_t len,
+			  void *buf,
+			  size_t size,
+			  size_t *out_size)
 {
-	ULOG_ERRNO_RETURN_ERR_IF(out == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(out_size == NULL, EINVAL);
 	ULOG_ERRNO_RETURN_ERR_IF(str == NULL, EINVAL);
-	ULOG_ERRNO_RETURN_ERR_IF(strlen(str) == 0, EINVAL);
-	size_t n = strlen(str);
+	ULOG_ERRNO_RETURN_ERR_IF(len == 0, EINVAL);
+	size_t n = len;
 	ULOG_ERRNO_RETURN_ERR_IF((n % 4) != 0, EINVAL);
 
 	size_t padding = 0;
@@ -113,9 +117,9 @@ int sdp_base64_decode(const char *str, void **out, size_t *out_size)
 		return -EINVAL;
 	}
 
-	size_t out_len = (n / 4) * 3;
-	uint8_t *_out = calloc(out_len, 1);
-	ULOG_ERRNO_RETURN_ERR_IF(_out == NULL, ENOMEM);
+	size_t out_len = SDP_BASE64_DECODED_SIZE(n);
+	ULOG_ERRNO_RETURN_ERR_IF(size < out_len, ENOBUFS);
+	uint8_t *_out = buf;
 
 	size_t j = 0;
 	uint32_t acc = 0;
@@ -147,12 +151,38 @@ int sdp_base64_decode(const char *str, void **out, size_t *out_size)
 		}
 	}
 
-	*out = (void *)_out;
 	*out_size = out_len;
 	return 0;
 
 error:
-	free(_out);
 	ULOGE("%s: invalid input base64 string", __func__);
 	return -EINVAL;
 }
+
+
+int sdp_base64_decode(const char *str,
+		      size_t len,
+		      void **out,
+		      size_t *out_size)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(out == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(out_size == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(str == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(len == 0, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF((len % 4) != 0, EINVAL);
+
+	size_t out_len = SDP_BASE64_DECODED_SIZE(len);
+	uint8_t *_out = calloc(out_len, 1);
+	ULOG_ERRNO_RETURN_ERR_IF(_out == NULL, ENOMEM);
+
+	ret = sdp_base64_decode_buf(str, len, _out, out_len, out_size);
+	if (ret < 0) {
+		free(_out);
+		return ret;
+	}
+
+	*out = (void *)_out;
+	return 0;
+}
@@ -0,0 +1,449 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+
+#include "sdp.h"
+
+
+#define SDP_PARALLEL_JOBS_MIN_SIZE 16
+
+#define SDP_PARALLEL_FIELDS_MIN_SIZE 4
+
+
+/* Media section, parsed by any of the threads */
+struct sdp_parallel_job {
+	/* From the m= line up to the next one */
+	struct sdp_span block;
+	/* Parsed media, detached from the scratch session of the thread;
+	 * NULL if the media type is skipped */
+	struct sdp_media *media;
+	/* Session-level fields found in the media section, replayed in
+	 * order on the session once all the threads are done */
+	struct sdp_field *fields;
+	unsigned int field_count;
+	unsigned int field_size;
+	uint32_t mandatory_fields;
+	size_t heap_size;
+	int ret;
+	struct sdp_reader_error err;
+};
+
+
+/* Builder of a thread; the sdp_builder callbacks get a pointer to this
+ * structure as a struct sdp_builder, it must remain the first member */
+struct sdp_parallel_builder {
+	struct sdp_builder builder;
+	struct sdp_parallel_job *job;
+};
+
+
+/* Batch of independent descriptions */
+struct sdp_batch {
+	struct sdp_batch_item *items;
+	unsigned int count;
+	struct sdp_read_opts opts;
+	/* Index of the next item to read, shared by the threads */
+	unsigned int next_item;
+};
+
+
+struct sdp_parallel {
+	const struct sdp_read_opts *opts;
+	/* Source text for lazy attributes */
+	const char *text;
+	struct sdp_parallel_job *jobs;
+	unsigned int job_count;
+	unsigned int job_size;
+	/* Index of the next job to run, shared by the threads */
+	unsigned int next_job;
+};
+
+
+static int sdp_parallel_is_media(struct sdp_span line)
+{
+	/* Same condition as sdp_reader_line() for a media line */
+	return (line.len > 2) && (line.ptr[0] == SDP_TYPE_MEDIA) &&
+	       (line.ptr[1] == '=');
+}
+
+
+static int sdp_parallel_job_add(struct sdp_parallel *parallel,
+				const char *ptr)
+{
+	struct sdp_parallel_job *job;
+
+	if (parallel->job_count == parallel->job_size) {
+		unsigned int size = parallel->job_size
+					    ? parallel->job_size * 2
+					    : SDP_PARALLEL_JOBS_MIN_SIZE;
+		job = realloc(parallel->jobs, size * sizeof(*job));
+		ULOG_ERRNO_RETURN_ERR_IF(job == NULL, ENOMEM);
+		parallel->jobs = job;
+		parallel->job_size = size;
+	}
+
+	job = &parallel->jobs[parallel->job_count++];
+	memset(job, 0, sizeof(*job));
+	job->block.ptr = ptr;
+
+	return 0;
+}
+
+
+static int sdp_parallel_session_field(const struct sdp_field *field,
+				     void *userdata)
+{
+	struct sdp_parallel_builder *pbuilder = userdata;
+	struct sdp_parallel_job *job = pbuilder->job;
+
+	if (job->field_count == job->field_size) {
+		unsigned int size = job->field_size
+					    ? job->field_size * 2
+					    : SDP_PARALLEL_FIELDS_MIN_SIZE;
+		struct sdp_field *fields =
+			realloc(job->fields, size * sizeof(*fields));
+		ULOG_ERRNO_RETURN_ERR_IF(fields == NULL, ENOMEM);
+		job->fields = fields;
+		job->field_size = size;
+	}
+	job->fields[job->field_count++] = *field;
+
+	return 0;
+}
+
+
+static int sdp_parallel_job_run(struct sdp_parallel *parallel,
+				struct sdp_parallel_job *job,
+				struct sdp_parallel_builder *pbuilder)
+{
+	int ret;
+	struct sdp_read_cbs cbs = sdp_builder_cbs;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+	struct sdp_media *media;
+
+	cbs.on_session_field = &sdp_parallel_session_field;
+	sdp_reader_init(&reader, &cbs, pbuilder, parallel->opts);
+	pbuilder->builder.media = NULL;
+	pbuilder->job = job;
+
+	sdp_scanner_init(&scanner, job->block.ptr, job->block.len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		ret = sdp_reader_line(&reader, line);
+		if (ret < 0) {
+			job->err = reader.err;
+			return ret;
+		}
+	}
+	job->mandatory_fields = reader.mandatory_fields;
+	job->heap_size = reader.heap_size;
+
+	/* Detach the media from the scratch session */
+	media = pbuilder->builder.media;
+	if (media != NULL) {
+		list_del(&media->node);
+		pbuilder->builder.session->media_count--;
+		job->media = media;
+	}
+
+	return 0;
+}
+
+
+static void *sdp_parallel_thread(void *userdata)
+{
+	struct sdp_parallel *parallel = userdata;
+	struct sdp_parallel_job *job;
+	struct sdp_parallel_builder pbuilder;
+	unsigned int i;
+
+	/* The media of the jobs are first added to a scratch session */
+	memset(&pbuilder, 0, sizeof(pbuilder));
+	pbuilder.builder.skip = parallel->opts->skip;
+	pbuilder.builder.registry = parallel->opts->registry;
+	pbuilder.builder.text = parallel->text;
+	pbuilder.builder.session = sdp_session_new();
+
+	while (1) {
+		i = __atomic_fetch_add(
+			&parallel->next_job, 1, __ATOMIC_RELAXED);
+		if (i >= parallel->job_count)
+			break;
+		job = &parallel->jobs[i];
+		if (pbuilder.builder.session == NULL) {
+			job->ret = -ENOMEM;
+			continue;
+		}
+		job->ret = sdp_parallel_job_run(parallel, job, &pbuilder);
+	}
+
+	sdp_session_destroy(pbuilder.builder.session);
+	return NULL;
+}
+
+
+/* Run the function on thread_count threads, the calling thread included */
+static void sdp_parallel_run(void *(*func)(void *),
+			     void *userdata,
+			     unsigned int thread_count)
+{
+	int err;
+	unsigned int i, count = 0;
+	pthread_t threads[SDP_READ_PARALLEL_MAX_THREADS];
+
+	if (thread_count > SDP_READ_PARALLEL_MAX_THREADS)
+		thread_count = SDP_READ_PARALLEL_MAX_THREADS;
+
+	for (i = 0; i + 1 < thread_count; i++) {
+		err = pthread_create(&threads[count], NULL, func, userdata);
+		if (err != 0) {
+			/* Go on with the threads already created */
+			ULOG_ERRNO("pthread_create", err);
+			break;
+		}
+		count++;
+	}
+
+	(*func)(userdata);
+
+	for (i = 0; i < count; i++)
+		pthread_join(threads[i], NULL);
+}
+
+
+int sdp_description_read_parallel(const char *buf,
+				  size_t len,
+				  const struct sdp_read_opts *opts,
+				  struct sdp_builder *builder,
+				  struct sdp_reader_error *err)
+{
+	int ret = 0;
+	struct sdp_parallel parallel;
+	struct sdp_parallel_job *job;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+	struct sdp_reader reader;
+	unsigned int i, j, thread_count;
+
+	memset(&parallel, 0, sizeof(parallel));
+	parallel.opts = opts;
+	parallel.text = builder->text;
+	sdp_reader_init(&reader, &sdp_builder_cbs, builder, opts);
+
+	/* Parse the session level and locate the media sections */
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		if (sdp_parallel_is_media(line)) {
+			ret = sdp_reader_media_count(&reader, line);
+			if (ret < 0) {
+				sdp_reader_line_error(&reader, line, ret);
+				goto out;
+			}
+			ret = sdp_parallel_job_add(&parallel, line.ptr);
+			if (ret < 0)
+				goto out;
+		} else if (parallel.job_count == 0) {
+			ret = sdp_reader_line(&reader, line);
+			if (ret < 0)
+				goto out;
+		}
+	}
+	for (i = 0; i < parallel.job_count; i++) {
+		job = &parallel.jobs[i];
+		job->block.len = ((i + 1 < parallel.job_count)
+					  ? parallel.jobs[i + 1].block.ptr
+					  : buf + len) -
+				 job->block.ptr;
+	}
+
+	if (parallel.job_count < SDP_READ_PARALLEL_MIN_MEDIAS) {
+		/* Not worth the threads, go on with the session reader; the
+		 * media are counted again */
+		reader.media_count = 0;
+		for (i = 0; i < parallel.job_count; i++) {
+			job = &parallel.jobs[i];
+			sdp_scanner_init(
+				&scanner, job->block.ptr, job->block.len);
+			while (sdp_scanner_next_line(&scanner, &line)) {
+				ret = sdp_reader_line(&reader, line);
+				if (ret < 0)
+					goto out;
+			}
+		}
+		ret = sdp_reader_finish(&reader);
+		goto out;
+	}
+
+	thread_count = opts->threads;
+	if (thread_count > parallel.job_count)
+		thread_count = parallel.job_count;
+	sdp_parallel_run(&sdp_parallel_thread, &parallel, thread_count);
+
+	/* Link the media in order; the first error in the description order
+	 * wins, the media after it are dropped */
+	for (i = 0; i < parallel.job_count; i++) {
+		job = &parallel.jobs[i];
+		if ((ret == 0) && (job->ret < 0)) {
+			ret = job->ret;
+			reader.err = job->err;
+		}
+		for (j = 0; (ret == 0) && (j < job->field_count); j++) {
+			ret = sdp_builder_cbs.on_session_field(
+				&job->fields[j], builder);
+		}
+		if ((ret == 0) && (job->media != NULL)) {
+			sdp_session_media_append(builder->session, job->media);
+			job->media = NULL;
+		}
+		sdp_media_destroy(job->media);
+		reader.mandatory_fields |= job->mandatory_fields;
+		if (ret == 0)
+			ret = sdp_reader_alloc(&reader, job->heap_size, NULL);
+	}
+	if (ret < 0)
+		goto out;
+
+	/* Session to media inheritance happens here */
+	ret = sdp_reader_finish(&reader);
+
+out:
+	if ((ret < 0) && (err != NULL))
+		*err = reader.err;
+	for (i = 0; i < parallel.job_count; i++)
+		free(parallel.jobs[i].fields);
+	free(parallel.jobs);
+	return ret;
+}
+
+
+static int sdp_batch_is_version(struct sdp_span line)
+{
+	/* Same condition as sdp_reader_line() for a version line */
+	return (line.len > 2) && (line.ptr[0] == SDP_TYPE_VERSION) &&
+	       (line.ptr[1] == '=');
+}
+
+
+int sdp_description_split(const char *buf,
+			  size_t len,
+			  struct sdp_batch_item **ret_items,
+			  unsigned int *ret_count)
+{
+	struct sdp_batch_item *items = NULL, *tmp;
+	unsigned int i, count = 0, size = 0;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_items == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_count == NULL, EINVAL);
+
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		if (!sdp_batch_is_version(line))
+			continue;
+		if (count == size) {
+			size = size ? size * 2 : SDP_PARALLEL_JOBS_MIN_SIZE;
+			tmp = realloc(items, size * sizeof(*items));
+			if (tmp == NULL) {
+				free(items);
+				ULOG_ERRNO("realloc", ENOMEM);
+				return -ENOMEM;
+			}
+			items = tmp;
+		}
+		memset(&items[count], 0, sizeof(items[count]));
+		items[count].buf = line.ptr;
+		count++;
+	}
+
+	/* Each description ends where the next one begins, the last one at
+	 * the end of the buffer (the reader stops at a null character) */
+	for (i = 0; i < count; i++) {
+		items[i].len =
+			((i + 1 < count) ? items[i + 1].buf : buf + len) -
+			items[i].buf;
+	}
+
+	*ret_items = items;
+	*ret_count = count;
+	return 0;
+}
+
+
+static void *sdp_batch_thread(void *userdata)
+{
+	struct sdp_batch *batch = userdata;
+	struct sdp_batch_item *item;
+	unsigned int i;
+
+	while (1) {
+		i = __atomic_fetch_add(&batch->next_item, 1, __ATOMIC_RELAXED);
+		if (i >= batch->count)
+			break;
+		item = &batch->items[i];
+		item->session = NULL;
+		if (item->buf == NULL) {
+			item->status = -EINVAL;
+			continue;
+		}
+		item->status = sdp_description_read_opts(
+			item->buf, item->len, &batch->opts, &item->session);
+	}
+
+	return NULL;
+}
+
+
+int sdp_description_read_batch(struct sdp_batch_item *items,
+			       unsigned int count,
+			       const struct sdp_read_opts *opts)
+{
+	struct sdp_batch batch;
+	unsigned int thread_count;
+
+	ULOG_ERRNO_RETURN_ERR_IF((items == NULL) && (count > 0), EINVAL);
+
+	memset(&batch, 0, sizeof(batch));
+	batch.items = items;
+	batch.count = count;
+	if (opts != NULL)
+		batch.opts = *opts;
+
+	/* The threads parse whole descriptions, not their media sections */
+	thread_count = batch.opts.threads;
+	batch.opts.threads = 0;
+	if (thread_count > count)
+		thread_count = count;
+	if (thread_count > 1)
+		sdp_parallel_run(&sdp_batch_thread, &batch, thread_count);
+	else
+		sdp_batch_thread(&batch);
+
+	return 0;
+}
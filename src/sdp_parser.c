@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sdp.h"
+
+
+#define SDP_PARSER_CARRY_MIN_SIZE 256
+
+
+struct sdp_parser {
+	struct sdp_reader reader;
+	struct sdp_builder builder;
+	struct sdp_read_opts opts;
+	/* Objects and strings reused by sdp_description_read_into() */
+	struct sdp_builder_spare spare;
+
+	/* Incomplete last line of the previous chunks */
+	char *carry;
+	size_t carry_len;
+	size_t carry_size;
+
+	/* Size of the chunks of the description */
+	size_t input_size;
+	/* A null character ended the description */
+	int done;
+	/* Sticky parse error, returned until sdp_parser_finish() */
+	int error;
+};
+
+
+struct sdp_parser *sdp_parser_new(void)
+{
+	struct sdp_parser *parser = calloc(1, sizeof(*parser));
+	ULOG_ERRNO_RETURN_VAL_IF(parser == NULL, ENOMEM, NULL);
+
+	sdp_reader_init(
+		&parser->reader, &sdp_builder_cbs, &parser->builder, NULL);
+	sdp_builder_spare_init(&parser->spare);
+
+	return parser;
+}
+
+
+static void sdp_parser_reset(struct sdp_parser *parser)
+{
+	sdp_session_destroy(parser->builder.session);
+	memset(&parser->builder, 0, sizeof(parser->builder));
+	parser->builder.skip = parser->opts.skip;
+	parser->builder.registry = parser->opts.registry;
+	sdp_reader_init(&parser->reader,
+			&sdp_builder_cbs,
+			&parser->builder,
+			&parser->opts);
+	parser->carry_len = 0;
+	parser->input_size = 0;
+	parser->done = 0;
+	parser->error = 0;
+}
+
+
+int sdp_parser_destroy(struct sdp_parser *parser)
+{
+	if (parser == NULL)
+		return 0;
+
+	sdp_parser_reset(parser);
+	free(parser->carry);
+	free(parser);
+
+	return 0;
+}
+
+
+int sdp_parser_set_opts(struct sdp_parser *parser,
+			const struct sdp_read_opts *opts)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(parser == NULL, EINVAL);
+
+	if (opts != NULL)
+		parser->opts = *opts;
+	else
+		memset(&parser->opts, 0, sizeof(parser->opts));
+
+	/* Apply now if no description is being parsed */
+	if (parser->builder.session == NULL)
+		sdp_parser_reset(parser);
+
+	return 0;
+}
+
+
+static int sdp_parser_carry_append(struct sdp_parser *parser,
+				   const char *buf,
+				   size_t len)
+{
+	if (parser->carry_len + len > parser->carry_size) {
+		size_t size = parser->carry_size ? parser->carry_size
+						 : SDP_PARSER_CARRY_MIN_SIZE;
+		while (size < parser->carry_len + len)
+			size *= 2;
+		char *tmp = realloc(parser->carry, size);
+		ULOG_ERRNO_RETURN_ERR_IF(tmp == NULL, ENOMEM);
+		parser->carry = tmp;
+		parser->carry_size = size;
+	}
+	memcpy(parser->carry + parser->carry_len, buf, len);
+	parser->carry_len += len;
+
+	return 0;
+}
+
+
+static int sdp_parser_carry_flush(struct sdp_parser *parser)
+{
+	int ret;
+
+	if (parser->carry_len == 0)
+		return 0;
+	ret = sdp_reader_line(
+		&parser->reader,
+		sdp_span_make(parser->carry, parser->carry_len));
+	parser->carry_len = 0;
+	return ret;
+}
+
+
+static int sdp_parser_feed_internal(struct sdp_parser *parser,
+				    const char *buf,
+				    size_t len)
+{
+	int ret;
+	const char *nul;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+
+	if (parser->builder.session == NULL) {
+		parser->builder.session = sdp_session_new();
+		if (parser->builder.session == NULL)
+			return -ENOMEM;
+	}
+
+	/* A null character ends the description, ignore what follows */
+	nul = memchr(buf, '\0', len);
+	if (nul != NULL) {
+		len = nul - buf;
+		parser->done = 1;
+	}
+
+	/* Bound the carried line as well as the whole description */
+	parser->input_size += len;
+	if ((parser->opts.limits.max_input_size != 0) &&
+	    (parser->input_size > parser->opts.limits.max_input_size)) {
+		ULOGE("description too large (max %zu bytes)",
+		      parser->opts.limits.max_input_size);
+		return -E2BIG;
+	}
+
+	/* Complete the pending line with the beginning of the chunk */
+	if (parser->carry_len > 0) {
+		size_t n = 0;
+		while ((n < len) && (buf[n] != '\r') && (buf[n] != '\n'))
+			n++;
+		ret = sdp_parser_carry_append(parser, buf, n);
+		if (ret < 0)
+			return ret;
+		if (n == len)
+			return 0;
+		ret = sdp_parser_carry_flush(parser);
+		if (ret < 0)
+			return ret;
+		buf += n;
+		len -= n;
+	}
+
+	/* Parse the complete lines in place, keep the last one if it is not
+	 * terminated yet */
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		if (line.ptr + line.len == buf + len) {
+			return sdp_parser_carry_append(
+				parser, line.ptr, line.len);
+		}
+		ret = sdp_reader_line(&parser->reader, line);
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+
+int sdp_parser_feed(struct sdp_parser *parser, const char *buf, size_t len)
+{
+	ULOG_ERRNO_RETURN_ERR_IF(parser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF((buf == NULL) && (len > 0), EINVAL);
+
+	if (parser->error < 0)
+		return parser->error;
+	if ((parser->done) || (len == 0))
+		return 0;
+
+	parser->error = sdp_parser_feed_internal(parser, buf, len);
+	return parser->error;
+}
+
+
+int sdp_parser_finish(struct sdp_parser *parser, struct sdp_session **ret_obj)
+{
+	int ret;
+
+	ULOG_ERRNO_RETURN_ERR_IF(parser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(ret_obj == NULL, EINVAL);
+
+	ret = parser->error;
+	if (ret < 0)
+		goto out;
+
+	if (parser->builder.session == NULL) {
+		parser->builder.session = sdp_session_new();
+		if (parser->builder.session == NULL) {
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+	/* The last line does not need to be terminated */
+	ret = sdp_parser_carry_flush(parser);
+	if (ret < 0)
+		goto out;
+
+	ret = sdp_reader_finish(&parser->reader);
+	if (ret < 0)
+		goto out;
+
+	*ret_obj = parser->builder.session;
+	parser->builder.session = NULL;
+
+out:
+	/* Ready for the next description */
+	sdp_parser_reset(parser);
+	return ret;
+}
+
+
+int sdp_description_read_into(struct sdp_parser *parser,
+			      struct sdp_session *session,
+			      const char *buf,
+			      size_t len)
+{
+	int ret = 0;
+	struct sdp_scanner scanner;
+	struct sdp_span line;
+
+	ULOG_ERRNO_RETURN_ERR_IF(parser == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(session == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(buf == NULL, EINVAL);
+	/* Not while a description is fed in chunks */
+	ULOG_ERRNO_RETURN_ERR_IF(parser->builder.session != NULL, EBUSY);
+	if ((parser->opts.limits.max_input_size != 0) &&
+	    (len > parser->opts.limits.max_input_size)) {
+		ULOGE("description too large (%zu bytes, max %zu)",
+		      len,
+		      parser->opts.limits.max_input_size);
+		return -E2BIG;
+	}
+
+	sdp_builder_reuse(&parser->builder, session, &parser->spare);
+	parser->builder.skip = parser->opts.skip;
+	parser->builder.registry = parser->opts.registry;
+	sdp_reader_init(&parser->reader,
+			&sdp_builder_cbs,
+			&parser->builder,
+			&parser->opts);
+
+	sdp_scanner_init(&scanner, buf, len);
+	while (sdp_scanner_next_line(&scanner, &line)) {
+		ret = sdp_reader_line(&parser->reader, line);
+		if (ret < 0)
+			break;
+	}
+	if (ret == 0)
+		ret = sdp_reader_finish(&parser->reader);
+
+	/* On success the spare objects have been flushed at the end of the
+	 * description, this is a no-op */
+	sdp_builder_spare_flush(&parser->builder);
+
+	/* The session belongs to the caller */
+	parser->builder.session = NULL;
+	sdp_parser_reset(parser);
+	return ret;
+}
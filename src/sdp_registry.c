@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sdp.h"
+
+
+#define SDP_ATTR_REGISTRY_MIN_SIZE 16
+
+
+struct sdp_attr_registry_slot {
+	const struct sdp_attr_type *type;
+	size_t len;
+};
+
+
+/* Open addressing hash table of the registered types, at most half full;
+ * the size is a power of 2 */
+struct sdp_attr_registry {
+	struct sdp_attr_registry_slot *slots;
+	size_t size;
+	size_t count;
+};
+
+
+/* FNV-1a hash of an attribute key */
+static uint32_t sdp_attr_registry_hash(struct sdp_span key)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < key.len; i++) {
+		hash ^= (uint8_t)key.ptr[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/* Slot of a key: the slot of its type, or the empty slot ending its probe
+ * sequence */
+static struct sdp_attr_registry_slot *
+sdp_attr_registry_slot(struct sdp_attr_registry_slot *slots,
+		       size_t size,
+		       struct sdp_span key)
+{
+	size_t i = sdp_attr_registry_hash(key) & (size - 1);
+
+	while ((slots[i].type != NULL) &&
+	       ((slots[i].len != key.len) ||
+		(memcmp(slots[i].type->key, key.ptr, key.len) != 0)))
+		i = (i + 1) & (size - 1);
+	return &slots[i];
+}
+
+
+static int sdp_attr_registry_grow(struct sdp_attr_registry *registry)
+{
+	struct sdp_attr_registry_slot *slots, *slot;
+	size_t i, size;
+
+	size = (registry->size != 0) ? registry->size * 2
+				     : SDP_ATTR_REGISTRY_MIN_SIZE;
+	slots = calloc(size, sizeof(*slots));
+	ULOG_ERRNO_RETURN_ERR_IF(slots == NULL, ENOMEM);
+
+	for (i = 0; i < registry->size; i++) {
+		if (registry->slots[i].type == NULL)
+			continue;
+		slot = sdp_attr_registry_slot(
+			slots,
+			size,
+			sdp_span_make(registry->slots[i].type->key,
+				      registry->slots[i].len));
+		*slot = registry->slots[i];
+	}
+
+	free(registry->slots);
+	registry->slots = slots;
+	registry->size = size;
+
+	return 0;
+}
+
+
+struct sdp_attr_registry *sdp_attr_registry_new(void)
+{
+	struct sdp_attr_registry *registry = calloc(1, sizeof(*registry));
+	ULOG_ERRNO_RETURN_VAL_IF(registry == NULL, ENOMEM, NULL);
+
+	return registry;
+}
+
+
+int sdp_attr_registry_destroy(struct sdp_attr_registry *registry)
+{
+	if (registry == NULL)
+		return 0;
+
+	free(registry->slots);
+	free(registry);
+
+	return 0;
+}
+
+
+int sdp_attr_registry_add(struct sdp_attr_registry *registry,
+			  const struct sdp_attr_type *type)
+{
+	int ret;
+	struct sdp_span key;
+	struct sdp_attr_registry_slot *slot;
+
+	ULOG_ERRNO_RETURN_ERR_IF(registry == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(type == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(type->key == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(*type->key == '\0', EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(type->parse == NULL, EINVAL);
+	ULOG_ERRNO_RETURN_ERR_IF(type->free == NULL, EINVAL);
+
+	key = sdp_span_make(type->key, strlen(type->key));
+	if ((sdp_attr_key_lookup(key, 0) != SDP_ATTR_KEY_UNKNOWN) ||
+	    (sdp_attr_key_lookup(key, 1) != SDP_ATTR_KEY_UNKNOWN)) {
+		ULOGE("attribute '%s' is handled by the library", type->key);
+		return -EEXIST;
+	}
+	if ((registry->size != 0) &&
+	    (sdp_attr_registry_slot(registry->slots, registry->size, key)
+		     ->type != NULL)) {
+		ULOGE("attribute '%s' is already registered", type->key);
+		return -EEXIST;
+	}
+
+	if ((registry->count + 1) * 2 > registry->size) {
+		ret = sdp_attr_registry_grow(registry);
+		if (ret < 0)
+			return ret;
+	}
+
+	slot = sdp_attr_registry_slot(registry->slots, registry->size, key);
+	slot->type = type;
+	slot->len = key.len;
+	registry->count++;
+
+	return 0;
+}
+
+
+const struct sdp_attr_type *
+sdp_attr_registry_find(const struct sdp_attr_registry *registry,
+		       const char *key)
+{
+	ULOG_ERRNO_RETURN_VAL_IF(registry == NULL, EINVAL, NULL);
+	ULOG_ERRNO_RETURN_VAL_IF(key == NULL, EINVAL, NULL);
+
+	return sdp_attr_registry_lookup(registry,
+					sdp_span_make(key, strlen(key)));
+}
+
+
+const struct sdp_attr_type *
+sdp_attr_registry_lookup(const struct sdp_attr_registry *registry,
+			 struct sdp_span key)
+{
+	if ((registry->count == 0) || (key.len == 0))
+		return NULL;
+
+	return sdp_attr_registry_slot(registry->slots, registry->size, key)
+		->type;
+}
@@ -0,0 +1,471 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "sdp.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#	define SDP_SCAN_X86
+#	include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define SDP_SCAN_NEON
+#	include <arm_neon.h>
+#endif
+
+
+/**
+ * Delimiter classification: each implementation returns, for a block of
+ * SDP_SCAN_BLOCK_SIZE bytes, a bitmask of the line delimiters (CR, LF and
+ * the null character, bit i is set for byte i), and searches a single field
+ * delimiter using the same per-block compare and mask extraction.
+ * The control characters search (see sdp_scan_find_ctrl()) uses the same
+ * compare and mask extraction with a range compare.
+ */
+struct sdp_scan_impl {
+	const char *name;
+	uint64_t (*line_mask)(const char *block);
+	const char *(*find)(const char *ptr, size_t len, char c);
+	const char *(*find_ctrl)(const char *ptr, size_t len);
+};
+
+
+static inline int sdp_scan_is_ctrl(char c)
+{
+	unsigned char u = (unsigned char)c;
+	return ((u < 0x20) && (u != '\t') && (u != '\r') && (u != '\n')) ||
+	       (u == 0x7f);
+}
+
+
+static uint64_t scalar_line_mask(const char *block)
+{
+	uint64_t mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < SDP_SCAN_BLOCK_SIZE; i++) {
+		char c = block[i];
+		if ((c == '\r') || (c == '\n') || (c == '\0'))
+			mask |= UINT64_C(1) << i;
+	}
+	return mask;
+}
+
+
+static const char *scalar_find(const char *ptr, size_t len, char c)
+{
+	return memchr(ptr, c, len);
+}
+
+
+static const char *scalar_find_ctrl(const char *ptr, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (sdp_scan_is_ctrl(ptr[i]))
+			return ptr + i;
+	}
+	return NULL;
+}
+
+
+static const struct sdp_scan_impl scalar_impl = {
+	.name = "scalar",
+	.line_mask = &scalar_line_mask,
+	.find = &scalar_find,
+	.find_ctrl = &scalar_find_ctrl,
+};
+
+
+#ifdef SDP_SCAN_X86
+
+__attribute__((target("sse2"))) static uint64_t
+sse2_line_mask(const char *block)
+{
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i nul = _mm_setzero_si128();
+	uint64_t mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < SDP_SCAN_BLOCK_SIZE; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(block + i));
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, cr),
+				     _mm_cmpeq_epi8(v, lf)),
+			_mm_cmpeq_epi8(v, nul));
+		mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(m) << i;
+	}
+	return mask;
+}
+
+
+__attribute__((target("sse2"))) static const char *
+sse2_find(const char *ptr, size_t len, char c)
+{
+	const __m128i d = _mm_set1_epi8(c);
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(ptr + i));
+		unsigned int m = _mm_movemask_epi8(_mm_cmpeq_epi8(v, d));
+		if (m != 0)
+			return ptr + i + __builtin_ctz(m);
+	}
+	return memchr(ptr + i, c, len - i);
+}
+
+
+__attribute__((target("sse2"))) static const char *
+sse2_find_ctrl(const char *ptr, size_t len)
+{
+	const __m128i max = _mm_set1_epi8(0x1f);
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i del = _mm_set1_epi8(0x7f);
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(ptr + i));
+		/* v <= 0x1f (unsigned) */
+		__m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(v, max), v);
+		__m128i allowed = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, tab),
+				     _mm_cmpeq_epi8(v, cr)),
+			_mm_cmpeq_epi8(v, lf));
+		__m128i m = _mm_or_si128(_mm_andnot_si128(allowed, ctrl),
+					 _mm_cmpeq_epi8(v, del));
+		unsigned int bits = _mm_movemask_epi8(m);
+		if (bits != 0)
+			return ptr + i + __builtin_ctz(bits);
+	}
+	return scalar_find_ctrl(ptr + i, len - i);
+}
+
+
+static const struct sdp_scan_impl sse2_impl = {
+	.name = "sse2",
+	.line_mask = &sse2_line_mask,
+	.find = &sse2_find,
+	.find_ctrl = &sse2_find_ctrl,
+};
+
+
+__attribute__((target("avx2"))) static uint64_t
+avx2_line_mask(const char *block)
+{
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i nul = _mm256_setzero_si256();
+	uint64_t mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < SDP_SCAN_BLOCK_SIZE; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(block + i));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+					_mm256_cmpeq_epi8(v, lf)),
+			_mm256_cmpeq_epi8(v, nul));
+		mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << i;
+	}
+	return mask;
+}
+
+
+__attribute__((target("avx2"))) static const char *
+avx2_find(const char *ptr, size_t len, char c)
+{
+	const __m256i d = _mm256_set1_epi8(c);
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(ptr + i));
+		uint32_t m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, d));
+		if (m != 0)
+			return ptr + i + __builtin_ctz(m);
+	}
+	return sse2_find(ptr + i, len - i, c);
+}
+
+
+__attribute__((target("avx2"))) static const char *
+avx2_find_ctrl(const char *ptr, size_t len)
+{
+	const __m256i max = _mm256_set1_epi8(0x1f);
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i del = _mm256_set1_epi8(0x7f);
+	size_t i;
+
+	for (i = 0; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(ptr + i));
+		/* v <= 0x1f (unsigned) */
+		__m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, max), v);
+		__m256i allowed = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, tab),
+					_mm256_cmpeq_epi8(v, cr)),
+			_mm256_cmpeq_epi8(v, lf));
+		__m256i m = _mm256_or_si256(
+			_mm256_andnot_si256(allowed, ctrl),
+			_mm256_cmpeq_epi8(v, del));
+		uint32_t bits = _mm256_movemask_epi8(m);
+		if (bits != 0)
+			return ptr + i + __builtin_ctz(bits);
+	}
+	return sse2_find_ctrl(ptr + i, len - i);
+}
+
+
+static const struct sdp_scan_impl avx2_impl = {
+	.name = "avx2",
+	.line_mask = &avx2_line_mask,
+	.find = &avx2_find,
+	.find_ctrl = &avx2_find_ctrl,
+};
+
+#endif /* SDP_SCAN_X86 */
+
+
+#ifdef SDP_SCAN_NEON
+
+static inline uint16_t neon_movemask(uint8x16_t v)
+{
+	const uint8x16_t bits = {
+		1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+	uint8x16_t m = vandq_u8(v, bits);
+	uint8x8_t t = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+	t = vpadd_u8(t, t);
+	t = vpadd_u8(t, t);
+	return vget_lane_u16(vreinterpret_u16_u8(t), 0);
+}
+
+
+static uint64_t neon_line_mask(const char *block)
+{
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	const uint8x16_t lf = vdupq_n_u8('\n');
+	const uint8x16_t nul = vdupq_n_u8(0);
+	uint64_t mask = 0;
+	unsigned int i;
+
+	for (i = 0; i < SDP_SCAN_BLOCK_SIZE; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(block + i));
+		uint8x16_t m = vorrq_u8(
+			vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, lf)),
+			vceqq_u8(v, nul));
+		mask |= (uint64_t)neon_movemask(m) << i;
+	}
+	return mask;
+}
+
+
+static const char *neon_find(const char *ptr, size_t len, char c)
+{
+	const uint8x16_t d = vdupq_n_u8((uint8_t)c);
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(ptr + i));
+		uint16_t m = neon_movemask(vceqq_u8(v, d));
+		if (m != 0)
+			return ptr + i + __builtin_ctz(m);
+	}
+	return memchr(ptr + i, c, len - i);
+}
+
+
+static const char *neon_find_ctrl(const char *ptr, size_t len)
+{
+	const uint8x16_t min = vdupq_n_u8(0x20);
+	const uint8x16_t tab = vdupq_n_u8('\t');
+	const uint8x16_t cr = vdupq_n_u8('\r');
+	const uint8x16_t lf = vdupq_n_u8('\n');
+	const uint8x16_t del = vdupq_n_u8(0x7f);
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)(ptr + i));
+		uint8x16_t allowed = vorrq_u8(
+			vorrq_u8(vceqq_u8(v, tab), vceqq_u8(v, cr)),
+			vceqq_u8(v, lf));
+		uint8x16_t m = vorrq_u8(vbicq_u8(vcltq_u8(v, min), allowed),
+					vceqq_u8(v, del));
+		uint16_t bits = neon_movemask(m);
+		if (bits != 0)
+			return ptr + i + __builtin_ctz(bits);
+	}
+	return scalar_find_ctrl(ptr + i, len - i);
+}
+
+
+static const struct sdp_scan_impl neon_impl = {
+	.name = "neon",
+	.line_mask = &neon_line_mask,
+	.find = &neon_find,
+	.find_ctrl = &neon_find_ctrl,
+};
+
+#endif /* SDP_SCAN_NEON */
+
+
+static const struct sdp_scan_impl *sdp_scan = &scalar_impl;
+
+
+__attribute__((constructor)) static void sdp_scan_init(void)
+{
+#if defined(SDP_SCAN_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		sdp_scan = &avx2_impl;
+	else if (__builtin_cpu_supports("sse2"))
+		sdp_scan = &sse2_impl;
+#elif defined(SDP_SCAN_NEON)
+	sdp_scan = &neon_impl;
+#endif
+	ULOGD("delimiter scan implementation: %s", sdp_scan->name);
+}
+
+
+const char *sdp_scan_find(const char *ptr, size_t len, char c)
+{
+	return (*sdp_scan->find)(ptr, len, c);
+}
+
+
+const char *sdp_scan_find_ctrl(const char *ptr, size_t len)
+{
+	return (*sdp_scan->find_ctrl)(ptr, len);
+}
+
+
+#ifdef SDP_TEST_HOOKS
+int sdp_scan_select(const char *name)
+{
+	const struct sdp_scan_impl *impl = NULL;
+	int supported = 1;
+
+	ULOG_ERRNO_RETURN_ERR_IF(name == NULL, EINVAL);
+
+	if (strcmp(name, scalar_impl.name) == 0)
+		impl = &scalar_impl;
+#if defined(SDP_SCAN_X86)
+	__builtin_cpu_init();
+	if (strcmp(name, sse2_impl.name) == 0) {
+		impl = &sse2_impl;
+		supported = __builtin_cpu_supports("sse2");
+	} else if (strcmp(name, avx2_impl.name) == 0) {
+		impl = &avx2_impl;
+		supported = __builtin_cpu_supports("avx2");
+	}
+#elif defined(SDP_SCAN_NEON)
+	if (strcmp(name, neon_impl.name) == 0)
+		impl = &neon_impl;
+#endif
+	if (impl == NULL)
+		return -ENOENT;
+	if (!supported)
+		return -ENOTSUP;
+
+	sdp_scan = impl;
+	return 0;
+}
+#endif /* SDP_TEST_HOOKS */
+
+
+void sdp_scanner_init(struct sdp_scanner *scanner, const char *buf, size_t len)
+{
+	scanner->buf = buf;
+	scanner->len = len;
+	scanner->pos = 0;
+	scanner->block = SIZE_MAX;
+	scanner->mask = 0;
+}
+
+
+/* Loads the line delimiters mask of the block starting at offset 'block' */
+static void sdp_scanner_load(struct sdp_scanner *scanner, size_t block)
+{
+	size_t remaining = scanner->len - block;
+
+	scanner->block = block;
+	if (remaining >= SDP_SCAN_BLOCK_SIZE) {
+		scanner->mask = (*sdp_scan->line_mask)(scanner->buf + block);
+	} else {
+		/* Last partial block: classify a padded copy and drop the
+		 * bits past the end of the buffer */
+		char tmp[SDP_SCAN_BLOCK_SIZE];
+		memset(tmp, ' ', sizeof(tmp));
+		memcpy(tmp, scanner->buf + block, remaining);
+		scanner->mask = (*sdp_scan->line_mask)(tmp) &
+				((UINT64_C(1) << remaining) - 1);
+	}
+}
+
+
+int sdp_scanner_next_line(struct sdp_scanner *scanner, struct sdp_span *line)
+{
+	const char *buf = scanner->buf;
+	size_t pos = scanner->pos;
+	size_t block;
+	uint64_t mask;
+
+	/* Skip the line delimiters */
+	while ((pos < scanner->len) &&
+	       ((buf[pos] == '\r') || (buf[pos] == '\n')))
+		pos++;
+	if ((pos >= scanner->len) || (buf[pos] == '\0')) {
+		scanner->pos = scanner->len;
+		return 0;
+	}
+
+	/* Find the end of the line from the delimiters masks, classifying
+	 * a new block only when the current one is exhausted */
+	block = pos & ~(size_t)(SDP_SCAN_BLOCK_SIZE - 1);
+	if (block != scanner->block)
+		sdp_scanner_load(scanner, block);
+	mask = scanner->mask & (~UINT64_C(0) << (pos - block));
+	while (mask == 0) {
+		block += SDP_SCAN_BLOCK_SIZE;
+		if (block >= scanner->len)
+			break;
+		sdp_scanner_load(scanner, block);
+		mask = scanner->mask;
+	}
+
+	line->ptr = buf + pos;
+	if (mask == 0) {
+		line->len = scanner->len - pos;
+		scanner->pos = scanner->len;
+	} else {
+		size_t end = block + __builtin_ctzll(mask);
+		line->len = end - pos;
+		/* A null character ends the description */
+		scanner->pos = (buf[end] == '\0') ? scanner->len : end;
+	}
+	return 1;
+}
@@ -0,0 +1,1377 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The benchmarks exercise internal helpers of the library */
+#include "sdp.h"
+ULOG_DECLARE_TAG(sdp);
+
+
+#define BENCH_TARGET_OPS 10000000
+
+#define BENCH_ARRAY_SIZE(_a) (sizeof(_a) / sizeof((_a)[0]))
+
+
+struct bench_file {
+	char *data;
+	size_t len;
+};
+
+
+static uint64_t bench_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static int bench_load_file(const char *path, struct bench_file *file)
+{
+	int err;
+	long size;
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		err = -errno;
+		ULOG_ERRNO("fopen('%s')", -err, path);
+		return err;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (size < 0) {
+		err = -errno;
+		ULOG_ERRNO("ftell", -err);
+		fclose(f);
+		return err;
+	}
+	file->data = calloc(size + 1, 1);
+	if (file->data == NULL) {
+		fclose(f);
+		return -ENOMEM;
+	}
+	file->len = size;
+	if ((size > 0) && (fread(file->data, size, 1, f) != 1)) {
+		err = -EIO;
+		ULOG_ERRNO("fread", -err);
+		free(file->data);
+		file->data = NULL;
+		fclose(f);
+		return err;
+	}
+	fclose(f);
+	return 0;
+}
+
+
+/* Attribute keys frequently found in real-world SDPs besides the ones
+ * handled by the reader */
+static const char *const bench_attr_extra_keys[] = {
+	"candidate",
+	"ice-ufrag",
+	"ice-pwd",
+	"ice-options",
+	"fingerprint",
+	"setup",
+	"mid",
+	"extmap",
+	"msid",
+	"msid-semantic",
+	"ssrc",
+	"ssrc-group",
+	"rtcp-mux",
+	"rtcp-rsize",
+	"rtcp-fb",
+	"group",
+	"framerate",
+	"x-dimensions",
+	"ptime",
+	"maxptime",
+};
+
+
+/* Reference: the strcmp() chain previously used by sdp_attr_read() */
+static enum sdp_attr_key bench_attr_key_strcmp(const char *key, int has_value)
+{
+	if ((strcmp(key, SDP_ATTR_RTPAVP_RTPMAP) == 0) && (has_value))
+		return SDP_ATTR_KEY_RTPAVP_RTPMAP;
+	else if ((strcmp(key, SDP_ATTR_FMTP) == 0) && (has_value))
+		return SDP_ATTR_KEY_FMTP;
+	else if (strcmp(key, SDP_ATTR_TOOL) == 0)
+		return SDP_ATTR_KEY_TOOL;
+	else if (strcmp(key, SDP_ATTR_TYPE) == 0)
+		return SDP_ATTR_KEY_TYPE;
+	else if (strcmp(key, SDP_ATTR_CHARSET) == 0)
+		return SDP_ATTR_KEY_CHARSET;
+	else if (strcmp(key, SDP_ATTR_CONTROL_URL) == 0)
+		return SDP_ATTR_KEY_CONTROL_URL;
+	else if ((strcmp(key, SDP_ATTR_RANGE) == 0) && (has_value))
+		return SDP_ATTR_KEY_RANGE;
+	else if (strcmp(key, SDP_ATTR_RECVONLY) == 0)
+		return SDP_ATTR_KEY_RECVONLY;
+	else if (strcmp(key, SDP_ATTR_SENDRECV) == 0)
+		return SDP_ATTR_KEY_SENDRECV;
+	else if (strcmp(key, SDP_ATTR_SENDONLY) == 0)
+		return SDP_ATTR_KEY_SENDONLY;
+	else if (strcmp(key, SDP_ATTR_INACTIVE) == 0)
+		return SDP_ATTR_KEY_INACTIVE;
+	else if ((strcmp(key, SDP_ATTR_RTCP_XR) == 0) && (has_value))
+		return SDP_ATTR_KEY_RTCP_XR;
+	else if ((strcmp(key, SDP_ATTR_RTCP_PORT) == 0) && (has_value))
+		return SDP_ATTR_KEY_RTCP_PORT;
+	return SDP_ATTR_KEY_UNKNOWN;
+}
+
+
+static int bench_attr(struct bench_file *files, unsigned int file_count)
+{
+	int status = 0;
+	unsigned int i, j, count = 0, max_count = 0, iterations;
+	unsigned int sink = 0;
+	char **keys = NULL;
+	uint64_t t0, t1, t2;
+
+	/* Collect the attribute keys of the corpus, the keys handled by the
+	 * reader and the common extra keys */
+	for (i = 0; i < file_count; i++)
+		max_count += files[i].len / 3;
+	max_count += BENCH_ARRAY_SIZE(sdp_attr_keys) +
+		     BENCH_ARRAY_SIZE(bench_attr_extra_keys);
+	keys = calloc(max_count, sizeof(*keys));
+	if (keys == NULL)
+		return -ENOMEM;
+	for (i = 0; i < file_count; i++) {
+		const char *line = files[i].data;
+		while ((line != NULL) && (*line != '\0')) {
+			if ((line[0] == 'a') && (line[1] == '=')) {
+				size_t len = strcspn(line + 2, ":\r\n");
+				if (len > 0)
+					keys[count++] = strndup(line + 2, len);
+			}
+			line = strchr(line, '\n');
+			if (line != NULL)
+				line++;
+		}
+	}
+	for (i = 0; i < BENCH_ARRAY_SIZE(sdp_attr_keys); i++) {
+		if (sdp_attr_keys[i].str != NULL)
+			keys[count++] = strdup(sdp_attr_keys[i].str);
+	}
+	for (i = 0; i < BENCH_ARRAY_SIZE(bench_attr_extra_keys); i++)
+		keys[count++] = strdup(bench_attr_extra_keys[i]);
+
+	/* Both lookups must agree */
+	for (i = 0; i < count; i++) {
+		struct sdp_span key = sdp_span_make(keys[i], strlen(keys[i]));
+		if (sdp_attr_key_lookup(key, 1) !=
+		    bench_attr_key_strcmp(keys[i], 1)) {
+			fprintf(stderr, "attr: lookup mismatch for '%s'\n",
+				keys[i]);
+			status = -EPROTO;
+			goto out;
+		}
+	}
+
+	iterations = BENCH_TARGET_OPS / count + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < count; i++)
+			sink += bench_attr_key_strcmp(keys[i], 1);
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < count; i++) {
+			struct sdp_span key =
+				sdp_span_make(keys[i], strlen(keys[i]));
+			sink += sdp_attr_key_lookup(key, 1);
+		}
+	}
+	t2 = bench_time_ns();
+
+	printf("attr: %u keys x %u iterations\n", count, iterations);
+	printf("attr:   strcmp chain  %6.2f ns/attribute\n",
+	       (double)(t1 - t0) / ((double)count * iterations));
+	printf("attr:   perfect hash  %6.2f ns/attribute\n",
+	       (double)(t2 - t1) / ((double)count * iterations));
+	if (sink == 0)
+		printf("\n");
+
+out:
+	for (i = 0; i < count; i++)
+		free(keys[i]);
+	free(keys);
+	return status;
+}
+
+
+/* Values looked up by the 'lookup' bench: control URLs and H.264 parameter
+ * sets sizes */
+struct bench_lookup {
+	size_t control_len;
+	unsigned int sps_size;
+	unsigned int pps_size;
+};
+
+
+static int bench_lookup_attr(struct sdp_span key,
+			     struct sdp_span value,
+			     void *userdata)
+{
+	struct bench_lookup *lookup = userdata;
+
+	if (sdp_span_eq(key, SDP_ATTR_CONTROL_URL))
+		lookup->control_len += value.len;
+	return 0;
+}
+
+
+static int bench_lookup_fmtp_h264(const struct sdp_h264_fmtp *fmtp,
+				  void *userdata)
+{
+	struct bench_lookup *lookup = userdata;
+
+	lookup->sps_size += fmtp->sps_size;
+	lookup->pps_size += fmtp->pps_size;
+	return 0;
+}
+
+
+static const struct sdp_read_cbs bench_lookup_cbs = {
+	.on_attr = &bench_lookup_attr,
+	.on_fmtp_h264 = &bench_lookup_fmtp_h264,
+};
+
+
+static int bench_lookup_tree(struct bench_file *file,
+			     struct bench_lookup *lookup)
+{
+	int err;
+	struct sdp_session *session = NULL;
+	struct sdp_media *media;
+
+	err = sdp_description_read_n(file->data, file->len, &session);
+	if (err < 0)
+		return err;
+	if (session->control_url != NULL)
+		lookup->control_len += strlen(session->control_url);
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		if (media->control_url != NULL)
+			lookup->control_len += strlen(media->control_url);
+		lookup->sps_size += media->h264_fmtp.sps_size;
+		lookup->pps_size += media->h264_fmtp.pps_size;
+	}
+	sdp_session_destroy(session);
+	return 0;
+}
+
+
+static int bench_lookup(struct bench_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i, j, iterations;
+	size_t total_len = 0;
+	struct bench_lookup tree, cbs;
+	uint64_t t0, t1, t2;
+
+	if (file_count == 0) {
+		fprintf(stderr, "lookup: no input file\n");
+		return -EINVAL;
+	}
+
+	/* Both readers must find the same values */
+	for (i = 0; i < file_count; i++) {
+		memset(&tree, 0, sizeof(tree));
+		memset(&cbs, 0, sizeof(cbs));
+		err = bench_lookup_tree(&files[i], &tree);
+		if (err < 0)
+			return err;
+		err = sdp_description_parse(
+			files[i].data, files[i].len, &bench_lookup_cbs, &cbs);
+		if (err < 0)
+			return err;
+		if (memcmp(&tree, &cbs, sizeof(tree)) != 0) {
+			fprintf(stderr, "lookup: mismatch for file %u\n", i);
+			return -EPROTO;
+		}
+		total_len += files[i].len;
+	}
+
+	iterations = BENCH_TARGET_OPS / (total_len + 1) + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++)
+			bench_lookup_tree(&files[i], &tree);
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			sdp_description_parse(files[i].data,
+					      files[i].len,
+					      &bench_lookup_cbs,
+					      &cbs);
+		}
+	}
+	t2 = bench_time_ns();
+
+	printf("lookup: %u files x %u iterations\n", file_count, iterations);
+	printf("lookup:   session tree  %8.1f ns/description\n",
+	       (double)(t1 - t0) / ((double)file_count * iterations));
+	printf("lookup:   callbacks     %8.1f ns/description\n",
+	       (double)(t2 - t1) / ((double)file_count * iterations));
+
+	return 0;
+}
+
+
+static int bench_validate(struct bench_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i, j, iterations;
+	size_t total_len = 0;
+	struct sdp_session *session;
+	uint64_t t0, t1, t2, t3;
+
+	if (file_count == 0) {
+		fprintf(stderr, "validate: no input file\n");
+		return -EINVAL;
+	}
+
+	/* Both must agree */
+	for (i = 0; i < file_count; i++) {
+		session = NULL;
+		err = sdp_description_read_n(
+			files[i].data, files[i].len, &session);
+		sdp_session_destroy(session);
+		if ((err == 0) !=
+		    (sdp_description_validate(files[i].data,
+					      files[i].len,
+					      NULL) == 0)) {
+			fprintf(stderr, "validate: mismatch for file %u\n", i);
+			return -EPROTO;
+		}
+		total_len += files[i].len;
+	}
+
+	iterations = BENCH_TARGET_OPS / (total_len + 1) + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			session = NULL;
+			sdp_description_read_n(
+				files[i].data, files[i].len, &session);
+			sdp_session_destroy(session);
+		}
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			sdp_description_validate(
+				files[i].data, files[i].len, NULL);
+		}
+	}
+	t2 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			sdp_description_peek(files[i].data,
+					     files[i].len,
+					     NULL,
+					     NULL,
+					     NULL,
+					     NULL);
+		}
+	}
+	t3 = bench_time_ns();
+
+	printf("validate: %u files x %u iterations\n",
+	       file_count,
+	       iterations);
+	printf("validate:   read and destroy  %8.1f ns/description\n",
+	       (double)(t1 - t0) / ((double)file_count * iterations));
+	printf("validate:   validate          %8.1f ns/description\n",
+	       (double)(t2 - t1) / ((double)file_count * iterations));
+	printf("validate:   peek origin       %8.1f ns/description\n",
+	       (double)(t3 - t2) / ((double)file_count * iterations));
+
+	return 0;
+}
+
+
+#define BENCH_NUM_COUNT 1024
+
+
+static int bench_num(struct bench_file *files, unsigned int file_count)
+{
+	unsigned int i, j, iterations;
+	char dec[BENCH_NUM_COUNT][24];
+	char hex[BENCH_NUM_COUNT][8];
+	uint64_t sink = 0, v;
+	uint64_t t0, t1, t2, t3, t4, t5;
+
+	(void)files;
+	(void)file_count;
+
+	/* Decimal numbers of 1 to 20 digits (ports, payload types, session
+	 * ids...) and 6-digit hexadecimal numbers (profile-level-id) */
+	srand(1);
+	for (i = 0; i < BENCH_NUM_COUNT; i++) {
+		v = ((uint64_t)rand() << 32) | (uint64_t)rand();
+		v >>= rand() % 64;
+		snprintf(dec[i], sizeof(dec[i]), "%" PRIu64, v);
+		snprintf(hex[i], sizeof(hex[i]), "%06X", rand() & 0xFFFFFF);
+	}
+
+	/* Both must agree */
+	for (i = 0; i < BENCH_NUM_COUNT; i++) {
+		struct sdp_span d = sdp_span_make(dec[i], strlen(dec[i]));
+		struct sdp_span h = sdp_span_make(hex[i], strlen(hex[i]));
+		if ((sdp_span_to_u64(d, UINT64_MAX, &v) < 0) ||
+		    (v != strtoull(dec[i], NULL, 10)) ||
+		    (sdp_span_parse_hex(h, 0xFFFFFF, &v) != 6) ||
+		    (v != strtoull(hex[i], NULL, 16))) {
+			fprintf(stderr, "num: mismatch for %s/%s\n",
+				dec[i],
+				hex[i]);
+			return -EPROTO;
+		}
+	}
+
+	iterations = BENCH_TARGET_OPS / BENCH_NUM_COUNT + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < BENCH_NUM_COUNT; i++)
+			sink += atoll(dec[i]);
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < BENCH_NUM_COUNT; i++)
+			sink += strtoull(dec[i], NULL, 10);
+	}
+	t2 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < BENCH_NUM_COUNT; i++) {
+			struct sdp_span d =
+				sdp_span_make(dec[i], strlen(dec[i]));
+			sdp_span_to_u64(d, UINT64_MAX, &v);
+			sink += v;
+		}
+	}
+	t3 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < BENCH_NUM_COUNT; i++) {
+			unsigned int x = 0;
+			sscanf(hex[i], "%6X", &x);
+			sink += x;
+		}
+	}
+	t4 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < BENCH_NUM_COUNT; i++) {
+			struct sdp_span h = sdp_span_make(hex[i], 6);
+			sdp_span_parse_hex(h, 0xFFFFFF, &v);
+			sink += v;
+		}
+	}
+	t5 = bench_time_ns();
+
+	printf("num: %u numbers x %u iterations\n",
+	       BENCH_NUM_COUNT,
+	       iterations);
+	printf("num:   atoll              %6.2f ns/number\n",
+	       (double)(t1 - t0) / ((double)BENCH_NUM_COUNT * iterations));
+	printf("num:   strtoull           %6.2f ns/number\n",
+	       (double)(t2 - t1) / ((double)BENCH_NUM_COUNT * iterations));
+	printf("num:   sdp_span_to_u64    %6.2f ns/number\n",
+	       (double)(t3 - t2) / ((double)BENCH_NUM_COUNT * iterations));
+	printf("num:   sscanf %%6X         %6.2f ns/number\n",
+	       (double)(t4 - t3) / ((double)BENCH_NUM_COUNT * iterations));
+	printf("num:   sdp_span_parse_hex %6.2f ns/number\n",
+	       (double)(t5 - t4) / ((double)BENCH_NUM_COUNT * iterations));
+	if (sink == 0)
+		printf("\n");
+
+	return 0;
+}
+
+
+static int bench_reuse(struct bench_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i, j, iterations;
+	size_t total_len = 0;
+	struct sdp_parser *parser;
+	struct sdp_session *session, *reused;
+	uint64_t t0, t1, t2;
+
+	if (file_count == 0) {
+		fprintf(stderr, "reuse: no input file\n");
+		return -EINVAL;
+	}
+	for (i = 0; i < file_count; i++)
+		total_len += files[i].len;
+
+	parser = sdp_parser_new();
+	reused = sdp_session_new();
+	if ((parser == NULL) || (reused == NULL)) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	iterations = BENCH_TARGET_OPS / (total_len + 1) + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			session = NULL;
+			sdp_description_read_n(
+				files[i].data, files[i].len, &session);
+			sdp_session_destroy(session);
+		}
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			sdp_description_read_into(
+				parser, reused, files[i].data, files[i].len);
+		}
+	}
+	t2 = bench_time_ns();
+
+	printf("reuse: %u files x %u iterations\n", file_count, iterations);
+	printf("reuse:   read and destroy  %8.1f ns/description\n",
+	       (double)(t1 - t0) / ((double)file_count * iterations));
+	printf("reuse:   read into         %8.1f ns/description\n",
+	       (double)(t2 - t1) / ((double)file_count * iterations));
+
+out:
+	sdp_session_destroy(reused);
+	sdp_parser_destroy(parser);
+	return err;
+}
+
+
+#define BENCH_MEDIA_COPIES 64
+
+
+static int bench_media(struct bench_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i, j, k, iterations;
+	const char *media = NULL;
+	char *buf;
+	size_t session_len, media_len, len;
+	struct sdp_session *session;
+	struct sdp_media *media_obj;
+	struct sdp_read_opts opts;
+	static const unsigned int threads[] = {0, 2, 4, 8};
+	uint64_t t0, t1;
+
+	/* Large description: the media sections of the first file with some
+	 * repeated BENCH_MEDIA_COPIES times */
+	for (i = 0; (i < file_count) && (media == NULL); i++)
+		media = strstr(files[i].data, "m=");
+	if (media == NULL) {
+		fprintf(stderr, "media: no input file with media\n");
+		return -EINVAL;
+	}
+	i--;
+	session_len = media - files[i].data;
+	media_len = files[i].len - session_len;
+	len = session_len + media_len * BENCH_MEDIA_COPIES;
+	buf = malloc(len);
+	if (buf == NULL)
+		return -ENOMEM;
+	memcpy(buf, files[i].data, session_len);
+	for (j = 0; j < BENCH_MEDIA_COPIES; j++)
+		memcpy(buf + session_len + j * media_len, media, media_len);
+
+	session = NULL;
+	err = sdp_description_read_n(buf, len, &session);
+	if (err < 0) {
+		fprintf(stderr, "media: invalid description\n");
+		goto out;
+	}
+	iterations = BENCH_TARGET_OPS / len + 1;
+	printf("media: %u media x %u iterations\n",
+	       session->media_count,
+	       iterations);
+	sdp_session_destroy(session);
+
+	for (k = 0; k < BENCH_ARRAY_SIZE(threads); k++) {
+		memset(&opts, 0, sizeof(opts));
+		opts.threads = threads[k];
+		t0 = bench_time_ns();
+		for (j = 0; j < iterations; j++) {
+			session = NULL;
+			sdp_description_read_opts(buf, len, &opts, &session);
+			sdp_session_destroy(session);
+		}
+		t1 = bench_time_ns();
+		printf("media:   %u thread(s)       %8.1f us/description\n",
+		       threads[k] ? threads[k] : 1,
+		       (double)(t1 - t0) / (1000. * iterations));
+	}
+
+	/* Session level and first media only */
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = SDP_READ_FLAG_LAZY_MEDIA;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		session = NULL;
+		sdp_description_read_opts(buf, len, &opts, &session);
+		if (session != NULL)
+			sdp_session_media_get(session, 0, &media_obj);
+		sdp_session_destroy(session);
+	}
+	t1 = bench_time_ns();
+	printf("media:   lazy, first media  %8.1f us/description\n",
+	       (double)(t1 - t0) / (1000. * iterations));
+
+out:
+	free(buf);
+	return err;
+}
+
+
+#define BENCH_LIMITS_HEADER                                                    \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 10.0.0.1\r\n"                                          \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 239.255.42.1/127\r\n"                                        \
+	"t=0 0\r\n"
+
+#define BENCH_LIMITS_MEDIA                                                     \
+	"m=video 5000 RTP/AVP 96\r\n"                                          \
+	"a=rtpmap:96 H264/90000\r\n"
+
+/* Size ratio between the large and the small inputs */
+#define BENCH_LIMITS_SCALE 8
+
+/* Maximum ratio of the time per byte between the large and the small
+ * inputs, above it the parse time is not considered linear */
+#define BENCH_LIMITS_MAX_RATIO 3.0
+
+#define BENCH_LIMITS_RUNS 5
+
+
+/* Pathological description: prefix, unit repeated count times, suffix */
+struct bench_limits_case {
+	const char *name;
+	const char *prefix;
+	const char *unit;
+	const char *suffix;
+	unsigned int count;
+	/* Expected to exceed the limits of bench_limits() */
+	int limited;
+};
+
+
+static const struct bench_limits_case bench_limits_cases[] = {
+	{"session attributes",
+	 BENCH_LIMITS_HEADER,
+	 "a=x-attr\r\n",
+	 "",
+	 3200,
+	 1},
+	{"media", BENCH_LIMITS_HEADER, BENCH_LIMITS_MEDIA, "", 640, 1},
+	{"long line", BENCH_LIMITS_HEADER "a=x-attr:", "x", "\r\n", 32768, 1},
+	{"empty lines", BENCH_LIMITS_HEADER, "\r", "", 32768, 0},
+	{"parameter sets",
+	 BENCH_LIMITS_HEADER BENCH_LIMITS_MEDIA
+	 "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=",
+	 "Z0LA",
+	 "\r\n",
+	 8192,
+	 1},
+	{"repeated fields",
+	 BENCH_LIMITS_HEADER,
+	 "s=session name\r\n",
+	 "",
+	 2048,
+	 1},
+};
+
+
+static char *bench_limits_gen(const struct bench_limits_case *c,
+			      unsigned int count,
+			      size_t *len)
+{
+	size_t prefix_len = strlen(c->prefix);
+	size_t unit_len = strlen(c->unit);
+	size_t suffix_len = strlen(c->suffix);
+	unsigned int i;
+	char *buf, *p;
+
+	*len = prefix_len + unit_len * count + suffix_len;
+	buf = malloc(*len);
+	if (buf == NULL)
+		return NULL;
+	p = buf;
+	memcpy(p, c->prefix, prefix_len);
+	p += prefix_len;
+	for (i = 0; i < count; i++, p += unit_len)
+		memcpy(p, c->unit, unit_len);
+	memcpy(p, c->suffix, suffix_len);
+
+	return buf;
+}
+
+
+/* Best time of a few reads of the description, in ns */
+static uint64_t bench_limits_time(const char *buf,
+				  size_t len,
+				  const struct sdp_read_opts *opts,
+				  int *status)
+{
+	unsigned int i;
+	uint64_t t0, t, best = UINT64_MAX;
+	struct sdp_session *session;
+
+	for (i = 0; i < BENCH_LIMITS_RUNS; i++) {
+		session = NULL;
+		t0 = bench_time_ns();
+		*status = sdp_description_read_opts(buf, len, opts, &session);
+		t = bench_time_ns() - t0;
+		sdp_session_destroy(session);
+		if (t < best)
+			best = t;
+	}
+
+	return best;
+}
+
+
+static int bench_limits(struct bench_file *files, unsigned int file_count)
+{
+	int err = 0, status;
+	unsigned int i;
+	const struct bench_limits_case *c;
+	char *small = NULL, *large = NULL;
+	size_t small_len, large_len;
+	double small_ns, large_ns, ratio;
+	uint64_t t;
+	struct sdp_read_opts opts;
+
+	(void)files;
+	(void)file_count;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.limits.max_input_size = 1024 * 1024;
+	opts.limits.max_media = 64;
+	opts.limits.max_attrs = 256;
+	opts.limits.max_param_sets_size = 4096;
+	opts.limits.max_heap_size = 128 * 1024;
+
+	for (i = 0; i < BENCH_ARRAY_SIZE(bench_limits_cases); i++) {
+		c = &bench_limits_cases[i];
+		small = bench_limits_gen(c, c->count, &small_len);
+		large = bench_limits_gen(
+			c, c->count * BENCH_LIMITS_SCALE, &large_len);
+		if ((small == NULL) || (large == NULL)) {
+			err = -ENOMEM;
+			goto out;
+		}
+
+		/* Without limits: the time per byte must not grow with the
+		 * input size */
+		small_ns = (double)bench_limits_time(
+				   small, small_len, NULL, &status) /
+			   small_len;
+		large_ns = (double)bench_limits_time(
+				   large, large_len, NULL, &status) /
+			   large_len;
+		ratio = large_ns / small_ns;
+		printf("limits: %-20s %6.2f ns/byte, x%d input: "
+		       "%6.2f ns/byte (ratio %.2f)\n",
+		       c->name,
+		       small_ns,
+		       BENCH_LIMITS_SCALE,
+		       large_ns,
+		       ratio);
+		if (ratio > BENCH_LIMITS_MAX_RATIO) {
+			fprintf(stderr,
+				"limits: %s: parse time is not linear\n",
+				c->name);
+			err = -ERANGE;
+		}
+
+		/* With limits: the large input fails fast if it exceeds them */
+		t = bench_limits_time(large, large_len, &opts, &status);
+		printf("limits: %-20s limited: %s in %.1f us\n",
+		       c->name,
+		       (status == 0) ? "ok" : strerror(-status),
+		       (double)t / 1000.);
+		if ((c->limited) ? (status != -E2BIG) : (status != 0)) {
+			fprintf(stderr,
+				"limits: %s: unexpected status %d\n",
+				c->name,
+				status);
+			err = -EPROTO;
+		}
+
+		free(small);
+		free(large);
+		small = NULL;
+		large = NULL;
+	}
+
+out:
+	free(small);
+	free(large);
+	return err;
+}
+
+
+/* Parse, patch the media ports and write back, as an RTSP proxy does; the
+ * written description must be stable when read and written again */
+static int bench_proxy_once(const char *buf, size_t len, char **ret_str)
+{
+	int err;
+	struct sdp_read_opts opts;
+	struct sdp_session *session = NULL;
+	struct sdp_media *media = NULL;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = SDP_READ_FLAG_RAW_LINES;
+	err = sdp_description_read_opts(buf, len, &opts, &session);
+	if (err < 0)
+		return err;
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		media->dst_stream_port |= 1;
+	}
+	err = sdp_description_write(session, ret_str);
+	sdp_session_destroy(session);
+	return err;
+}
+
+
+static int bench_proxy(struct bench_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i, j, iterations;
+	size_t total_len = 0;
+	char *first, *second;
+	uint64_t t0, t1;
+
+	if (file_count == 0) {
+		fprintf(stderr, "proxy: no input file\n");
+		return -EINVAL;
+	}
+	for (i = 0; i < file_count; i++) {
+		total_len += files[i].len;
+		first = NULL;
+		second = NULL;
+		err = bench_proxy_once(files[i].data, files[i].len, &first);
+		if (err == 0) {
+			err = bench_proxy_once(
+				first, strlen(first), &second);
+		}
+		if ((err == 0) && (strcmp(first, second) != 0)) {
+			fprintf(stderr, "proxy: file %u not stable\n", i);
+			err = -EPROTO;
+		}
+		free(first);
+		free(second);
+		if (err < 0)
+			return err;
+	}
+
+	iterations = BENCH_TARGET_OPS / (total_len + 1) + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			first = NULL;
+			bench_proxy_once(files[i].data, files[i].len, &first);
+			free(first);
+		}
+	}
+	t1 = bench_time_ns();
+
+	printf("proxy: %u files x %u iterations\n", file_count, iterations);
+	printf("proxy:   read, patch and write  %8.1f ns/description\n",
+	       (double)(t1 - t0) / ((double)file_count * iterations));
+
+	return 0;
+}
+
+
+#define BENCH_TYPED_MEDIA_COUNT 16
+
+#define BENCH_TYPED_MEDIA                                                      \
+	"m=video 5000 RTP/AVP 96\r\n"                                          \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"a=x-dimensions:1920,1080\r\n"                                         \
+	"a=framerate:30\r\n"
+
+
+struct bench_typed_dimensions {
+	unsigned int width;
+	unsigned int height;
+};
+
+
+static int bench_typed_scan(const char *value,
+			    size_t len,
+			    struct bench_typed_dimensions *dim)
+{
+	char buf[32];
+
+	if ((len == 0) || (len >= sizeof(buf)))
+		return -EINVAL;
+	memcpy(buf, value, len);
+	buf[len] = '\0';
+	if (sscanf(buf, "%u,%u", &dim->width, &dim->height) != 2)
+		return -EINVAL;
+	return 0;
+}
+
+
+static int bench_typed_parse(const struct sdp_attr_type *type,
+			     struct sdp_span value,
+			     void **ret_data)
+{
+	int ret;
+	struct bench_typed_dimensions *dim = calloc(1, sizeof(*dim));
+
+	(void)type;
+
+	if (dim == NULL)
+		return -ENOMEM;
+	ret = bench_typed_scan(value.ptr, value.len, dim);
+	if (ret < 0) {
+		free(dim);
+		return ret;
+	}
+	*ret_data = dim;
+	return 0;
+}
+
+
+static int bench_typed_write(const struct sdp_attr_type *type,
+			     const void *data,
+			     char *buf,
+			     size_t size)
+{
+	const struct bench_typed_dimensions *dim = data;
+
+	(void)type;
+
+	return snprintf(buf, size, "%u,%u", dim->width, dim->height);
+}
+
+
+static void bench_typed_free(const struct sdp_attr_type *type, void *data)
+{
+	(void)type;
+
+	free(data);
+}
+
+
+static const struct sdp_attr_type bench_typed_type = {
+	.key = "x-dimensions",
+	.parse = &bench_typed_parse,
+	.write = &bench_typed_write,
+	.free = &bench_typed_free,
+};
+
+
+/* Sum of the dimensions of the media, from the attribute strings or from
+ * the typed attributes */
+static unsigned int bench_typed_sum(struct sdp_session *session, int typed)
+{
+	unsigned int sum = 0;
+	struct sdp_media *media = NULL;
+	struct sdp_attr *attr = NULL;
+	struct bench_typed_dimensions dim;
+
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		list_walk_entry_forward(&media->attrs, attr, node)
+		{
+			if (typed) {
+				if (attr->type != &bench_typed_type)
+					continue;
+				dim = *(struct bench_typed_dimensions *)
+					       attr->data;
+			} else {
+				if (strcmp(attr->key, "x-dimensions") != 0)
+					continue;
+				if (bench_typed_scan(attr->value,
+						     strlen(attr->value),
+						     &dim) < 0)
+					continue;
+			}
+			sum += dim.width + dim.height;
+		}
+	}
+	return sum;
+}
+
+
+static int bench_typed(struct bench_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i, iterations, sum_strings = 0, sum_typed = 0;
+	char buf[sizeof(BENCH_LIMITS_HEADER) +
+		 BENCH_TYPED_MEDIA_COUNT * sizeof(BENCH_TYPED_MEDIA)];
+	char *out = NULL;
+	size_t len, out_len;
+	struct sdp_attr_registry *registry;
+	struct sdp_read_opts opts;
+	struct sdp_session *plain = NULL, *typed = NULL, *session;
+	uint64_t t0, t1, t2, t3, t4;
+
+	(void)files;
+	(void)file_count;
+
+	strcpy(buf, BENCH_LIMITS_HEADER);
+	for (i = 0; i < BENCH_TYPED_MEDIA_COUNT; i++)
+		strcat(buf, BENCH_TYPED_MEDIA);
+	len = strlen(buf);
+
+	registry = sdp_attr_registry_new();
+	if (registry == NULL)
+		return -ENOMEM;
+	err = sdp_attr_registry_add(registry, &bench_typed_type);
+	if (err < 0)
+		goto out;
+	memset(&opts, 0, sizeof(opts));
+	err = sdp_description_read_opts(buf, len, &opts, &plain);
+	if (err < 0)
+		goto out;
+	opts.registry = registry;
+	err = sdp_description_read_opts(buf, len, &opts, &typed);
+	if (err < 0)
+		goto out;
+
+	/* Both accesses must agree, and the typed values are written back */
+	if ((bench_typed_sum(plain, 0) != bench_typed_sum(typed, 1)) ||
+	    (bench_typed_sum(typed, 1) == 0)) {
+		fprintf(stderr, "typed: value mismatch\n");
+		err = -EPROTO;
+		goto out;
+	}
+	err = sdp_description_write(typed, &out);
+	if (err < 0)
+		goto out;
+	if (strstr(out, "a=x-dimensions:1920,1080\r\n") == NULL) {
+		fprintf(stderr, "typed: attribute not written back\n");
+		err = -EPROTO;
+		goto out;
+	}
+	err = sdp_description_write_size(typed, &out_len);
+	if (err < 0)
+		goto out;
+	if (out_len != strlen(out)) {
+		fprintf(stderr, "typed: write size mismatch\n");
+		err = -EPROTO;
+		goto out;
+	}
+
+	iterations = BENCH_TARGET_OPS / len + 1;
+	t0 = bench_time_ns();
+	for (i = 0; i < iterations; i++) {
+		session = NULL;
+		opts.registry = NULL;
+		sdp_description_read_opts(buf, len, &opts, &session);
+		sdp_session_destroy(session);
+	}
+	t1 = bench_time_ns();
+	for (i = 0; i < iterations; i++) {
+		session = NULL;
+		opts.registry = registry;
+		sdp_description_read_opts(buf, len, &opts, &session);
+		sdp_session_destroy(session);
+	}
+	t2 = bench_time_ns();
+	for (i = 0; i < iterations; i++)
+		sum_strings += bench_typed_sum(plain, 0);
+	t3 = bench_time_ns();
+	for (i = 0; i < iterations; i++)
+		sum_typed += bench_typed_sum(typed, 1);
+	t4 = bench_time_ns();
+
+	printf("typed: %u media x %u iterations\n",
+	       BENCH_TYPED_MEDIA_COUNT,
+	       iterations);
+	printf("typed:   read               %8.1f ns/description\n",
+	       (double)(t1 - t0) / iterations);
+	printf("typed:   read with registry %8.1f ns/description\n",
+	       (double)(t2 - t1) / iterations);
+	printf("typed:   access by string   %8.1f ns/attribute\n",
+	       (double)(t3 - t2) /
+		       ((double)BENCH_TYPED_MEDIA_COUNT * iterations));
+	printf("typed:   access by type     %8.1f ns/attribute\n",
+	       (double)(t4 - t3) /
+		       ((double)BENCH_TYPED_MEDIA_COUNT * iterations));
+	if (sum_strings != sum_typed)
+		printf("\n");
+
+out:
+	free(out);
+	sdp_session_destroy(typed);
+	sdp_session_destroy(plain);
+	sdp_attr_registry_destroy(registry);
+	return err;
+}
+
+
+/* The chunks of the scatter/gather output must give the same text */
+static int bench_write_iov_check(struct sdp_session *session, const char *str)
+{
+	int err;
+	size_t i, len = 0, count;
+	struct iovec *iov;
+
+	err = sdp_description_write_iov(session, &iov, &count);
+	if (err < 0)
+		return err;
+	for (i = 0; i < count; i++) {
+		if (strncmp(str + len, iov[i].iov_base, iov[i].iov_len) != 0)
+			break;
+		len += iov[i].iov_len;
+	}
+	if ((i < count) || (len != strlen(str)))
+		err = -EPROTO;
+	free(iov);
+	return err;
+}
+
+
+/* The size query must match the allocated output, and writing into a
+ * reused buffer or as chunks must give the same text */
+static int bench_write(struct bench_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i, j, iterations;
+	size_t total_len = 0, len, buf_size = 0;
+	struct sdp_session **sessions;
+	char *str, *buf = NULL, *tmp;
+	struct iovec *iov;
+	uint64_t t0, t1, t2, t3, t4;
+
+	if (file_count == 0) {
+		fprintf(stderr, "write: no input file\n");
+		return -EINVAL;
+	}
+	sessions = calloc(file_count, sizeof(*sessions));
+	if (sessions == NULL)
+		return -ENOMEM;
+	for (i = 0; i < file_count; i++) {
+		err = sdp_description_read_opts(
+			files[i].data, files[i].len, NULL, &sessions[i]);
+		if (err < 0)
+			goto out;
+		str = NULL;
+		err = sdp_description_write(sessions[i], &str);
+		if (err < 0)
+			goto out;
+		err = sdp_description_write_size(sessions[i], &len);
+		if ((err == 0) && (len != strlen(str))) {
+			fprintf(stderr, "write: file %u size mismatch\n", i);
+			err = -EPROTO;
+		}
+		if ((err == 0) && (len + 1 > buf_size)) {
+			tmp = realloc(buf, len + 1);
+			if (tmp == NULL)
+				err = -ENOMEM;
+			else
+				buf = tmp;
+			buf_size = len + 1;
+		}
+		if ((err == 0) &&
+		    (sdp_description_write_buf(sessions[i], buf, len, NULL) !=
+		     -ENOBUFS)) {
+			fprintf(stderr, "write: file %u no overflow\n", i);
+			err = -EPROTO;
+		}
+		if (err == 0) {
+			err = sdp_description_write_buf(
+				sessions[i], buf, len + 1, NULL);
+		}
+		if ((err == 0) && (strcmp(buf, str) != 0)) {
+			fprintf(stderr, "write: file %u text mismatch\n", i);
+			err = -EPROTO;
+		}
+		if ((err == 0) &&
+		    (bench_write_iov_check(sessions[i], str) < 0)) {
+			fprintf(stderr, "write: file %u chunks mismatch\n", i);
+			err = -EPROTO;
+		}
+		total_len += len;
+		free(str);
+		if (err < 0)
+			goto out;
+	}
+
+	iterations = BENCH_TARGET_OPS / (total_len + 1) + 1;
+	t0 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			str = NULL;
+			sdp_description_write(sessions[i], &str);
+			free(str);
+		}
+	}
+	t1 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++)
+			sdp_description_write_size(sessions[i], &len);
+	}
+	t2 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			sdp_description_write_buf(
+				sessions[i], buf, buf_size, NULL);
+		}
+	}
+	t3 = bench_time_ns();
+	for (j = 0; j < iterations; j++) {
+		for (i = 0; i < file_count; i++) {
+			iov = NULL;
+			sdp_description_write_iov(sessions[i], &iov, &len);
+			free(iov);
+		}
+	}
+	t4 = bench_time_ns();
+
+	printf("write: %u files x %u iterations\n", file_count, iterations);
+	printf("write:   allocated        %8.1f ns/description\n",
+	       (double)(t1 - t0) / ((double)file_count * iterations));
+	printf("write:   size query       %8.1f ns/description\n",
+	       (double)(t2 - t1) / ((double)file_count * iterations));
+	printf("write:   caller buffer    %8.1f ns/description\n",
+	       (double)(t3 - t2) / ((double)file_count * iterations));
+	printf("write:   chunks           %8.1f ns/description\n",
+	       (double)(t4 - t3) / ((double)file_count * iterations));
+	printf("write:   allocated        %8.1f MB/s\n",
+	       (double)total_len * iterations * 1000. / (double)(t1 - t0));
+
+out:
+	for (i = 0; i < file_count; i++)
+		sdp_session_destroy(sessions[i]);
+	free(sessions);
+	free(buf);
+	return err;
+}
+
+
+struct bench {
+	const char *name;
+	const char *desc;
+	int (*run)(struct bench_file *files, unsigned int file_count);
+};
+
+
+static const struct bench benches[] = {
+	{"attr", "attribute key dispatch", &bench_attr},
+	{"lookup", "control URLs and parameter sets lookup", &bench_lookup},
+	{"validate", "validation without session object", &bench_validate},
+	{"num", "numeric fields parsing", &bench_num},
+	{"media", "media sections parsing on threads", &bench_media},
+	{"reuse", "parsing into a reused session", &bench_reuse},
+	{"limits", "linear parse time and resource limits", &bench_limits},
+	{"proxy", "pass-through of unmodeled lines", &bench_proxy},
+	{"typed", "typed attributes decoded once", &bench_typed},
+	{"write", "writing into a caller buffer or as chunks", &bench_write},
+};
+
+
+static void usage(const char *prog_name)
+{
+	unsigned int i;
+
+	printf("Usage: %s [<bench>|all] [<file>...]\n"
+	       "  Run the library microbenchmarks, using the given SDP files "
+	       "as corpus\n\n"
+	       "Benchmarks:\n",
+	       prog_name);
+	for (i = 0; i < BENCH_ARRAY_SIZE(benches); i++)
+		printf("  %-8s %s\n", benches[i].name, benches[i].desc);
+}
+
+
+int main(int argc, char **argv)
+{
+	int status = EXIT_SUCCESS, err;
+	const char *name = "all";
+	struct bench_file *files = NULL;
+	unsigned int i, file_count = 0, run = 0;
+
+	if (argc >= 2) {
+		if ((strcmp(argv[1], "-h") == 0) ||
+		    (strcmp(argv[1], "--help") == 0)) {
+			usage(argv[0]);
+			exit(EXIT_SUCCESS);
+		}
+		name = argv[1];
+	}
+
+	if (argc > 2) {
+		files = calloc(argc - 2, sizeof(*files));
+		if (files == NULL) {
+			ULOG_ERRNO("calloc", ENOMEM);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 2; i < (unsigned int)argc; i++) {
+		err = bench_load_file(argv[i], &files[file_count]);
+		if (err < 0) {
+			status = EXIT_FAILURE;
+			goto cleanup;
+		}
+		file_count++;
+	}
+
+	for (i = 0; i < BENCH_ARRAY_SIZE(benches); i++) {
+		if ((strcmp(name, "all") != 0) &&
+		    (strcmp(name, benches[i].name) != 0))
+			continue;
+		run++;
+		err = benches[i].run(files, file_count);
+		if (err < 0) {
+			ULOG_ERRNO("bench '%s'", -err, benches[i].name);
+			status = EXIT_FAILURE;
+		}
+	}
+	if (run == 0) {
+		usage(argv[0]);
+		status = EXIT_FAILURE;
+	}
+
+cleanup:
+	for (i = 0; i < file_count; i++)
+		free(files[i].data);
+	free(files);
+	exit(status);
+}
@@ -0,0 +1,1387 @@
+/**
+ * Copyright (c) 2026 Parrot Drones SAS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the copyright holders nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The checks exercise internal helpers of the library, built in with
+ * SDP_TEST_HOOKS (see atom.mk) */
+#include "sdp.h"
+
+
+#define CHECK_ARRAY_SIZE(_a) (sizeof(_a) / sizeof((_a)[0]))
+
+#define CHECK(_cond)                                                           \
+	do {                                                                   \
+		if (!(_cond)) {                                                \
+			fprintf(stderr,                                        \
+				"%s:%d: check failed: %s\n",                   \
+				__FILE__,                                      \
+				__LINE__,                                      \
+				#_cond);                                       \
+			return -EPROTO;                                        \
+		}                                                              \
+	} while (0)
+
+
+struct check_file {
+	char *data;
+	size_t len;
+};
+
+
+static int check_load_file(const char *path, struct check_file *file)
+{
+	int err;
+	long size;
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		err = -errno;
+		ULOG_ERRNO("fopen('%s')", -err, path);
+		return err;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (size < 0) {
+		err = -errno;
+		ULOG_ERRNO("ftell", -err);
+		fclose(f);
+		return err;
+	}
+	file->data = calloc(size + 1, 1);
+	if (file->data == NULL) {
+		fclose(f);
+		return -ENOMEM;
+	}
+	file->len = size;
+	if ((size > 0) && (fread(file->data, size, 1, f) != 1)) {
+		err = -EIO;
+		ULOG_ERRNO("fread", -err);
+		free(file->data);
+		file->data = NULL;
+		fclose(f);
+		return err;
+	}
+	fclose(f);
+	return 0;
+}
+
+
+/* Deterministic pseudo-random numbers (xorshift32) */
+static uint32_t check_random(uint32_t *state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+
+#define CHECK_SCAN_BUFFERS 20000
+
+#define CHECK_SCAN_MAX_LEN (4 * SDP_SCAN_BLOCK_SIZE + 7)
+
+
+/* Reference line splitter: lines are separated by runs of CR and LF, a
+ * null character ends the text */
+static int check_scan_ref_next_line(const char *buf,
+				    size_t len,
+				    size_t *pos,
+				    struct sdp_span *line)
+{
+	size_t i = *pos;
+
+	while ((i < len) && ((buf[i] == '\r') || (buf[i] == '\n')))
+		i++;
+	if ((i >= len) || (buf[i] == '\0')) {
+		*pos = len;
+		return 0;
+	}
+	line->ptr = buf + i;
+	while ((i < len) && (buf[i] != '\r') && (buf[i] != '\n') &&
+	       (buf[i] != '\0'))
+		i++;
+	line->len = (size_t)(buf + i - line->ptr);
+	*pos = ((i < len) && (buf[i] == '\0')) ? len : i;
+	return 1;
+}
+
+
+static const char *check_scan_ref_find_ctrl(const char *ptr, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		unsigned char u = (unsigned char)ptr[i];
+		if (((u < 0x20) && (u != '\t') && (u != '\r') && (u != '\n')) ||
+		    (u == 0x7f))
+			return ptr + i;
+	}
+	return NULL;
+}
+
+
+/* Random buffer, allocated to its exact length so that a read past the
+ * end (e.g. of the last partial block) is caught by the sanitizers */
+static char *check_scan_gen(uint32_t *state, size_t len)
+{
+	static const char alphabet[] = "ab=: /\r\n\r\n\t\x01\x7f\x1f\xff";
+	char *buf = malloc(len > 0 ? len : 1);
+	size_t i;
+
+	if (buf == NULL)
+		return NULL;
+	for (i = 0; i < len; i++) {
+		uint32_t r = check_random(state);
+		/* Mostly printable text, some delimiters, rare nulls */
+		if ((r & 0xff) == 0)
+			buf[i] = '\0';
+		else if ((r & 0x3) != 0)
+			buf[i] = 'a' + (r >> 8) % 26;
+		else
+			buf[i] = alphabet[(r >> 8) % (sizeof(alphabet) - 1)];
+	}
+	return buf;
+}
+
+
+static int check_scan_buf(const char *buf, size_t len)
+{
+	struct sdp_scanner scanner;
+	struct sdp_span line, ref;
+	size_t pos = 0, start, end;
+	int ret;
+	char c;
+
+	/* Lines */
+	sdp_scanner_init(&scanner, buf, len);
+	do {
+		ret = sdp_scanner_next_line(&scanner, &line);
+		CHECK(ret == check_scan_ref_next_line(buf, len, &pos, &ref));
+		if (ret)
+			CHECK((line.ptr == ref.ptr) && (line.len == ref.len));
+	} while (ret);
+
+	/* Single delimiter and control characters, on all sub-ranges
+	 * starting at any alignment */
+	for (start = 0; start < len; start += 1 + start / 8) {
+		end = len - (start % 5);
+		if (end < start)
+			end = start;
+		c = (start & 1) ? ':' : '\r';
+		CHECK(sdp_scan_find(buf + start, end - start, c) ==
+		      memchr(buf + start, c, end - start));
+		CHECK(sdp_scan_find_ctrl(buf + start, end - start) ==
+		      check_scan_ref_find_ctrl(buf + start, end - start));
+	}
+	return 0;
+}
+
+
+/* Every delimiter scan implementation against the reference splitter */
+static int check_scan(struct check_file *files, unsigned int file_count)
+{
+	static const char *const impls[] = {"scalar", "sse2", "avx2", "neon"};
+	int err = 0;
+	unsigned int i, j, tested = 0;
+	uint32_t state;
+	size_t len;
+	char *buf;
+
+	for (i = 0; i < CHECK_ARRAY_SIZE(impls); i++) {
+		err = sdp_scan_select(impls[i]);
+		if ((err == -ENOENT) || (err == -ENOTSUP)) {
+			printf("scan: %s not available\n", impls[i]);
+			err = 0;
+			continue;
+		} else if (err < 0) {
+			return err;
+		}
+		state = 0x2545f491;
+		for (j = 0; (j < CHECK_SCAN_BUFFERS) && (err == 0); j++) {
+			len = check_random(&state) % CHECK_SCAN_MAX_LEN;
+			buf = check_scan_gen(&state, len);
+			if (buf == NULL)
+				return -ENOMEM;
+			err = check_scan_buf(buf, len);
+			free(buf);
+		}
+		for (j = 0; (j < file_count) && (err == 0); j++) {
+			err = check_scan_buf(files[j].data, files[j].len);
+		}
+		if (err < 0) {
+			fprintf(stderr, "scan: %s differs\n", impls[i]);
+			break;
+		}
+		printf("scan: %s ok\n", impls[i]);
+		tested++;
+	}
+
+	/* Back to the best implementation */
+	for (i = CHECK_ARRAY_SIZE(impls); i > 0; i--) {
+		if (sdp_scan_select(impls[i - 1]) == 0)
+			break;
+	}
+	if ((err == 0) && (tested == 0))
+		err = -ENOENT;
+	return err;
+}
+
+
+/* Written text of a session, or NULL (in this order: error, then text) */
+static char *check_write(int err, struct sdp_session *session)
+{
+	char *str = NULL;
+
+	if ((err == 0) && (sdp_description_write(session, &str) < 0))
+		str = NULL;
+	sdp_session_destroy(session);
+	return str;
+}
+
+
+static int check_same_text(const char *a, const char *b)
+{
+	if ((a == NULL) || (b == NULL))
+		return (a == NULL) && (b == NULL);
+	return strcmp(a, b) == 0;
+}
+
+
+#define CHECK_PARSER_SAMPLE                                                    \
+	"v=0\r\n"                                                              \
+	"o=- 123456789 1 IN IP4 192.168.43.1\r\n"                              \
+	"s=Bebop2\r\n"                                                         \
+	"c=IN IP4 239.255.42.1/127\r\n"                                        \
+	"t=0 0\r\n"                                                            \
+	"a=tool:sdp_check\r\n"                                                 \
+	"a=recvonly\r\n"                                                       \
+	"m=video 55004 RTP/AVP 96\r\n"                                         \
+	"a=control:stream=0\r\n"                                               \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"a=fmtp:96 packetization-mode=1;profile-level-id=4D0A1F;"              \
+	"sprop-parameter-sets=Z00AKeKQFAe2AtwEBAaQeJEV,aO48gA==\r\n"           \
+	"a=rtcp-xr:rcvr-rtt=all:300 stat-summary=loss,jitter\r\n"              \
+	"m=audio 55006 RTP/AVP 97\r\n"                                         \
+	"a=rtpmap:97 L16/44100/2\r\n"
+
+
+/* Feed a description split at 'split', and at 'split2' if not 0 */
+static char *check_parser_feed(struct sdp_parser *parser,
+			       const char *buf,
+			       size_t len,
+			       size_t split,
+			       size_t split2)
+{
+	int err;
+	struct sdp_session *session = NULL;
+
+	if (split2 < split)
+		split2 = split;
+	err = sdp_parser_feed(parser, buf, split);
+	if (err == 0)
+		err = sdp_parser_feed(parser, buf + split, split2 - split);
+	if (err == 0)
+		err = sdp_parser_feed(parser, buf + split2, len - split2);
+	err = sdp_parser_finish(parser, &session);
+	return check_write(err, session);
+}
+
+
+static int check_parser_buf(struct sdp_parser *parser,
+			    const char *buf,
+			    size_t len,
+			    unsigned int *crlf_splits,
+			    unsigned int *line_splits)
+{
+	int err = 0;
+	size_t i;
+	struct sdp_session *session = NULL;
+	char *ref, *str;
+
+	err = sdp_description_read_n(buf, len, &session);
+	ref = check_write(err, session);
+	err = 0;
+
+	/* Two chunks, at every split point */
+	for (i = 0; (i <= len) && (err == 0); i++) {
+		str = check_parser_feed(parser, buf, len, i, 0);
+		if (!check_same_text(ref, str)) {
+			fprintf(stderr, "parser: split at %zu differs\n", i);
+			err = -EPROTO;
+		}
+		free(str);
+		if ((i > 0) && (i < len) && (buf[i - 1] == '\r') &&
+		    (buf[i] == '\n'))
+			(*crlf_splits)++;
+		else if ((i > 0) && (i < len) && (buf[i - 1] != '\n') &&
+			 (buf[i] != '\r'))
+			(*line_splits)++;
+	}
+
+	/* One byte at a time */
+	if (err == 0) {
+		for (i = 0; (i < len) && (err == 0); i++)
+			err = sdp_parser_feed(parser, buf + i, 1);
+		err = sdp_parser_finish(parser, &session);
+		str = check_write(err, session);
+		err = check_same_text(ref, str) ? 0 : -EPROTO;
+		if (err < 0)
+			fprintf(stderr, "parser: byte feeding differs\n");
+		free(str);
+	}
+
+	free(ref);
+	return err;
+}
+
+
+/* LF line endings turned into CRLF */
+static char *check_crlf(const char *buf, size_t len, size_t *ret_len)
+{
+	char *out = malloc(2 * len + 1);
+	size_t i, j = 0;
+
+	if (out == NULL)
+		return NULL;
+	for (i = 0; i < len; i++) {
+		if ((buf[i] == '\n') && ((i == 0) || (buf[i - 1] != '\r')))
+			out[j++] = '\r';
+		out[j++] = buf[i];
+	}
+	out[j] = '\0';
+	*ret_len = j;
+	return out;
+}
+
+
+/* Chunk-fed parser against sdp_description_read_n() at every split point,
+ * including CR | LF and inside a line */
+static int check_parser(struct check_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i, crlf_splits = 0, line_splits = 0;
+	struct sdp_parser *parser;
+	char *crlf;
+	size_t crlf_len;
+
+	parser = sdp_parser_new();
+	if (parser == NULL)
+		return -ENOMEM;
+
+	err = check_parser_buf(parser,
+			       CHECK_PARSER_SAMPLE,
+			       sizeof(CHECK_PARSER_SAMPLE) - 1,
+			       &crlf_splits,
+			       &line_splits);
+	for (i = 0; (i < file_count) && (err == 0); i++) {
+		err = check_parser_buf(parser,
+				       files[i].data,
+				       files[i].len,
+				       &crlf_splits,
+				       &line_splits);
+		if (err < 0)
+			break;
+		crlf = check_crlf(files[i].data, files[i].len, &crlf_len);
+		if (crlf == NULL) {
+			err = -ENOMEM;
+			break;
+		}
+		err = check_parser_buf(
+			parser, crlf, crlf_len, &crlf_splits, &line_splits);
+		free(crlf);
+	}
+
+	/* Three chunks, the middle one being a lone CR or LF */
+	for (i = 1; (i < sizeof(CHECK_PARSER_SAMPLE) - 1) && (err == 0); i++) {
+		char *ref, *str;
+		struct sdp_session *session = NULL;
+		if ((CHECK_PARSER_SAMPLE[i] != '\r') &&
+		    (CHECK_PARSER_SAMPLE[i] != '\n'))
+			continue;
+		err = sdp_description_read_n(CHECK_PARSER_SAMPLE,
+					     sizeof(CHECK_PARSER_SAMPLE) - 1,
+					     &session);
+		ref = check_write(err, session);
+		str = check_parser_feed(parser,
+					CHECK_PARSER_SAMPLE,
+					sizeof(CHECK_PARSER_SAMPLE) - 1,
+					i,
+					i + 1);
+		if (!check_same_text(ref, str)) {
+			fprintf(stderr, "parser: lone delimiter at %u\n", i);
+			err = -EPROTO;
+		}
+		free(ref);
+		free(str);
+	}
+
+	sdp_parser_destroy(parser);
+	if (err < 0)
+		return err;
+	CHECK((crlf_splits > 0) && (line_splits > 0));
+	printf("parser: %u CR|LF splits, %u in-line splits ok\n",
+	       crlf_splits,
+	       line_splits);
+	return 0;
+}
+
+
+#define CHECK_RANGE_DESC                                                       \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 127.0.0.1\r\n"                                         \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 127.0.0.1\r\n"                                               \
+	"t=0 0\r\n"                                                            \
+	"a=range:%s\r\n"
+
+
+/* Range value and its written form, NULL if it must be rejected */
+struct check_range {
+	const char *value;
+	const char *written;
+};
+
+
+static const struct check_range check_ranges[] = {
+	/* NPT: milliseconds at least, microseconds when needed */
+	{"npt=0-", "npt=0-"},
+	{"npt=1.5-", "npt=1.500-"},
+	{"npt=-5.5", "npt=-5.500"},
+	{"npt=1.123-2.1234", "npt=1.123-2.1234"},
+	{"npt=20.999999-", "npt=20.999999-"},
+	{"npt=3723.123456-86400.000001", "npt=1:02:03.123456-24:00:00.000001"},
+	{"npt=1:02:03.25-", "npt=1:02:03.250-"},
+	{"npt=4294967296.5-", "npt=1193046:28:16.500-"},
+	{"npt=1.1234567-", "npt=1.123456-"},
+	{"npt=1:60:00-", NULL},
+	{"npt=-", NULL},
+	{"npt=now-", NULL},
+
+	/* SMPTE: frames and subframes only when not 0 */
+	{"smpte=10:07:00-10:07:33:05.01", "smpte=10:07:00-10:07:33:05.01"},
+	{"smpte=0:0:1:00.50-", "smpte=00:00:01:00.50-"},
+	{"smpte-25=00:00:00:24.99-", "smpte-25=00:00:00:24.99-"},
+	{"smpte-30-drop=0:10:00:00-", "smpte-30-drop=00:10:00-"},
+	{"smpte-30-drop=0:01:00:02-", "smpte-30-drop=00:01:00:02-"},
+	{"smpte-30-drop=0:01:00:00-", NULL},
+	{"smpte-30-drop=0:01:00:01.50-", NULL},
+	{"smpte-25=00:00:00:25-", NULL},
+	{"smpte=00:00:00:30-", NULL},
+	{"smpte=-00:00:10", NULL},
+	{"smpte=100:00:00-", NULL},
+
+	/* Absolute: shortest fraction, from 1970 on */
+	{"clock=19961108T143720.25Z-", "clock=19961108T143720.25Z-"},
+	{"clock=20240229T000000Z-", "clock=20240229T000000Z-"},
+	{"clock=20000229T120000.000001Z-20991231T235959.999999Z",
+	 "clock=20000229T120000.000001Z-20991231T235959.999999Z"},
+	{"clock=19700101T000000.500Z-", "clock=19700101T000000.5Z-"},
+	{"clock=20230229T000000Z-", NULL},
+	{"clock=21000229T000000Z-", NULL},
+	{"clock=19691231T235959Z-", NULL},
+	{"clock=20240101T240000Z-", NULL},
+	{"clock=20240101T000060Z-", NULL},
+	{"clock=20240101T000000-", NULL},
+	{"clock=-20240101T000000Z", NULL},
+};
+
+
+/* Range attribute of a session read from CHECK_RANGE_DESC, its description
+ * written in 'str' */
+static int check_range_read(const char *value,
+			    struct sdp_range *range,
+			    char **str)
+{
+	int err;
+	char desc[256];
+	struct sdp_session *session = NULL;
+
+	*str = NULL;
+	snprintf(desc, sizeof(desc), CHECK_RANGE_DESC, value);
+	err = sdp_description_read(desc, &session);
+	if (err < 0)
+		return err;
+	*range = session->range;
+	*str = check_write(0, session);
+	return (*str != NULL) ? 0 : -EPROTO;
+}
+
+
+/* Range values written, read back and written again without change */
+static int check_range(struct check_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i;
+
+	(void)files;
+	(void)file_count;
+
+	for (i = 0; (i < CHECK_ARRAY_SIZE(check_ranges)) && (err == 0); i++) {
+		const struct check_range *c = &check_ranges[i];
+		struct sdp_range range, range2;
+		char *str, *str2 = NULL, *line, *end;
+
+		err = check_range_read(c->value, &range, &str);
+		if (c->written == NULL) {
+			if (err == 0) {
+				fprintf(stderr, "range: '%s' read\n", c->value);
+				err = -EPROTO;
+			} else {
+				err = 0;
+			}
+			free(str);
+			continue;
+		}
+		if (err < 0) {
+			fprintf(stderr, "range: '%s' rejected\n", c->value);
+			break;
+		}
+
+		line = strstr(str, "a=range:");
+		end = (line != NULL) ? strstr(line, "\r\n") : NULL;
+		if (end == NULL) {
+			fprintf(stderr, "range: '%s' not written\n", c->value);
+			err = -EPROTO;
+			goto next;
+		}
+		line += strlen("a=range:");
+		*end = '\0';
+		if (strcmp(line, c->written) != 0) {
+			fprintf(stderr,
+				"range: '%s' written '%s', expected '%s'\n",
+				c->value,
+				line,
+				c->written);
+			err = -EPROTO;
+			goto next;
+		}
+		*end = '\r';
+
+		err = check_range_read(c->written, &range2, &str2);
+		if (err < 0) {
+			fprintf(stderr,
+				"range: '%s' not read back\n",
+				c->written);
+			goto next;
+		}
+		if ((memcmp(&range, &range2, sizeof(range)) != 0) ||
+		    (strcmp(str, str2) != 0)) {
+			fprintf(stderr, "range: '%s' changed\n", c->value);
+			err = -EPROTO;
+		}
+next:
+		free(str);
+		free(str2);
+	}
+	if (err < 0)
+		return err;
+
+	printf("range: %u values ok\n", i);
+	return 0;
+}
+
+
+/* Descriptions of the batch check and their expected status (0 or error) */
+static const struct {
+	const char *text;
+	int ok;
+} check_batch_docs[] = {
+	{CHECK_PARSER_SAMPLE, 1},
+	/* Missing connection */
+	{"v=0\r\n"
+	 "o=- 1 1 IN IP4 127.0.0.1\r\n"
+	 "s=-\r\n"
+	 "t=0 0\r\n",
+	 0},
+	/* Invalid line */
+	{"v=0\r\n"
+	 "o=- 1 1 IN IP4 127.0.0.1\r\n"
+	 "bad line\r\n",
+	 0},
+	{CHECK_PARSER_SAMPLE, 1},
+};
+
+
+/* Split and batch read of concatenated descriptions, each item against
+ * sdp_description_read_n() of its text */
+static int check_batch(struct check_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i, j, count = 0, failed = 0;
+	unsigned int threads[] = {1, 4};
+	struct sdp_batch_item *items = NULL;
+	struct sdp_read_opts opts;
+	char *buf, *p;
+	size_t len = 0;
+
+	/* Data before the first version line is ignored */
+	len += strlen("garbage\r\n");
+	for (i = 0; i < CHECK_ARRAY_SIZE(check_batch_docs); i++)
+		len += strlen(check_batch_docs[i].text);
+	for (i = 0; i < file_count; i++)
+		len += files[i].len + 1;
+	buf = malloc(len + 1);
+	if (buf == NULL)
+		return -ENOMEM;
+	p = stpcpy(buf, "garbage\r\n");
+	for (i = 0; i < CHECK_ARRAY_SIZE(check_batch_docs); i++)
+		p = stpcpy(p, check_batch_docs[i].text);
+	for (i = 0; i < file_count; i++) {
+		memcpy(p, files[i].data, files[i].len);
+		p += files[i].len;
+		if ((files[i].len == 0) || (p[-1] != '\n'))
+			*p++ = '\n';
+	}
+	len = p - buf;
+	*p = '\0';
+
+	err = sdp_description_split(buf, len, &items, &count);
+	if (err < 0)
+		goto out;
+	if (count < CHECK_ARRAY_SIZE(check_batch_docs)) {
+		fprintf(stderr, "batch: %u items\n", count);
+		err = -EPROTO;
+		goto out;
+	}
+	for (i = 0; i < CHECK_ARRAY_SIZE(check_batch_docs); i++) {
+		if ((items[i].len != strlen(check_batch_docs[i].text)) ||
+		    (memcmp(items[i].buf,
+			    check_batch_docs[i].text,
+			    items[i].len) != 0)) {
+			fprintf(stderr, "batch: item %u split\n", i);
+			err = -EPROTO;
+			goto out;
+		}
+	}
+
+	for (j = 0; (j < CHECK_ARRAY_SIZE(threads)) && (err == 0); j++) {
+		memset(&opts, 0, sizeof(opts));
+		opts.threads = threads[j];
+		err = sdp_description_read_batch(items, count, &opts);
+		failed = 0;
+		for (i = 0; i < count; i++) {
+			struct sdp_session *session = NULL;
+			char *ref, *str;
+			int status, ok = (items[i].status == 0);
+			if ((err == 0) &&
+			    (i < CHECK_ARRAY_SIZE(check_batch_docs)) &&
+			    (ok != check_batch_docs[i].ok)) {
+				fprintf(stderr,
+					"batch: item %u status %d\n",
+					i,
+					items[i].status);
+				err = -EPROTO;
+			}
+			if ((err == 0) && (ok != (items[i].session != NULL))) {
+				fprintf(stderr, "batch: item %u session\n", i);
+				err = -EPROTO;
+			}
+			status = sdp_description_read_n(
+				items[i].buf, items[i].len, &session);
+			ref = check_write(status, session);
+			str = check_write(items[i].status, items[i].session);
+			items[i].session = NULL;
+			if ((err == 0) && ((status != items[i].status) ||
+					   !check_same_text(ref, str))) {
+				fprintf(stderr, "batch: item %u differs\n", i);
+				err = -EPROTO;
+			}
+			failed += (items[i].status < 0);
+			free(ref);
+			free(str);
+		}
+	}
+	if (err == 0)
+		printf("batch: %u items, %u errors ok\n", count, failed);
+
+out:
+	free(items);
+	free(buf);
+	return err;
+}
+
+
+#define CHECK_LAZY_SAMPLE                                                      \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 127.0.0.1\r\n"                                         \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 127.0.0.1\r\n"                                               \
+	"t=0 0\r\n"                                                            \
+	"a=x-check:session\r\n"                                                \
+	"a=x-flag\r\n"                                                         \
+	"m=video 5004 RTP/AVP 96\r\n"                                          \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"a=x-check:media 0\r\n"                                                \
+	"m=audio 5006 RTP/AVP 97\r\n"                                          \
+	"a=rtpmap:97 L16/44100/2\r\n"                                          \
+	"a=x-check:media 1\r\n"                                                \
+	"a=x-empty:\r\n"
+
+
+/* Number of lazy attributes of a session and its media */
+static unsigned int check_lazy_attr_count(const struct sdp_session *session)
+{
+	unsigned int count = 0;
+	struct sdp_attr *attr = NULL;
+	struct sdp_media *media = NULL;
+
+	list_walk_entry_forward(&session->attrs, attr, node)
+	{
+		count += (attr->text != NULL);
+	}
+	list_walk_entry_forward(&session->medias, media, node)
+	{
+		list_walk_entry_forward(&media->attrs, attr, node)
+		{
+			count += (attr->text != NULL);
+		}
+	}
+	return count;
+}
+
+
+/* Lazy read of a description against sdp_description_read_n(), for the
+ * session and for its copy once the session is destroyed; with lazy media,
+ * only the last media is built before the copy */
+static int check_lazy_buf(const char *buf,
+			  size_t len,
+			  uint32_t flags,
+			  unsigned int *lazy_count)
+{
+	int err, status;
+	unsigned int count;
+	struct sdp_read_opts opts;
+	struct sdp_session *session = NULL, *copy = NULL;
+	struct sdp_media *media;
+	char *ref, *str = NULL, *str2 = NULL;
+
+	status = sdp_description_read_n(buf, len, &session);
+	ref = check_write(status, session);
+
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = flags;
+	session = NULL;
+	err = sdp_description_read_opts(buf, len, &opts, &session);
+	if ((err < 0) && (status == 0)) {
+		fprintf(stderr, "lazy: status %d, expected 0\n", err);
+		err = -EPROTO;
+		goto out;
+	}
+	if (err < 0) {
+		err = 0;
+		goto out;
+	}
+	*lazy_count += check_lazy_attr_count(session);
+
+	count = sdp_session_media_get_count(session);
+	if ((flags & SDP_READ_FLAG_LAZY_MEDIA) && (count > 0)) {
+		err = sdp_session_media_get(session, count - 1, &media);
+		if (err < 0)
+			goto error;
+	}
+	copy = sdp_session_new();
+	if (copy == NULL) {
+		err = -ENOMEM;
+		goto out;
+	}
+	err = sdp_session_copy(session, copy);
+	if (err < 0)
+		goto error;
+	if ((flags & SDP_READ_FLAG_LAZY_MEDIA) && (count > 1) &&
+	    (session->media_count != 1)) {
+		fprintf(stderr, "lazy: media built in the source session\n");
+		err = -EPROTO;
+		goto out;
+	}
+	err = sdp_session_materialize(session);
+	if (err < 0)
+		goto error;
+	err = sdp_description_write(session, &str);
+	if (err < 0)
+		goto out;
+	sdp_session_destroy(session);
+	session = NULL;
+	if ((copy->media_count != count) ||
+	    (check_lazy_attr_count(copy) != 0)) {
+		fprintf(stderr, "lazy: copy not materialized\n");
+		err = -EPROTO;
+		goto out;
+	}
+	str2 = check_write(0, copy);
+	copy = NULL;
+	if (!check_same_text(ref, str) || !check_same_text(ref, str2)) {
+		fprintf(stderr, "lazy: written text differs\n");
+		err = -EPROTO;
+	}
+	goto out;
+
+error:
+	/* Errors in the media sections are only found when building them */
+	if ((flags & SDP_READ_FLAG_LAZY_MEDIA) && (status < 0))
+		err = 0;
+
+out:
+	sdp_session_destroy(session);
+	sdp_session_destroy(copy);
+	free(ref);
+	free(str);
+	free(str2);
+	return err;
+}
+
+
+/* Media added or removed after a lazy read: all the media are built first,
+ * so the indexes, the count and the written text include them */
+static int check_lazy_edit(void)
+{
+	int err;
+	struct sdp_session *session = NULL;
+	struct sdp_media *media, *added;
+	struct sdp_read_opts opts;
+	char *str;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = SDP_READ_FLAG_LAZY_MEDIA;
+
+	/* Add a media once the first one is built */
+	err = sdp_description_read_opts(CHECK_LAZY_SAMPLE,
+					sizeof(CHECK_LAZY_SAMPLE) - 1,
+					&opts,
+					&session);
+	CHECK(err == 0);
+	err = sdp_session_media_get(session, 0, &media);
+	CHECK(err == 0);
+	err = sdp_session_media_add(session, &added);
+	CHECK(err == 0);
+	err = sdp_media_copy(media, added);
+	CHECK(err == 0);
+	added->dst_stream_port = 5008;
+	CHECK(sdp_session_media_get_count(session) == 3);
+	err = sdp_session_media_get(session, 1, &media);
+	CHECK((err == 0) && (media->dst_stream_port == 5006));
+	err = sdp_session_media_get(session, 2, &media);
+	CHECK((err == 0) && (media == added));
+	str = check_write(0, session);
+	CHECK(str != NULL);
+	err = ((strstr(str, "m=audio 5006 ") != NULL) &&
+	       (strstr(str, "m=video 5008 ") != NULL))
+		      ? 0
+		      : -EPROTO;
+	free(str);
+	CHECK(err == 0);
+
+	/* Remove a built media: it is not built again */
+	session = NULL;
+	err = sdp_description_read_opts(CHECK_LAZY_SAMPLE,
+					sizeof(CHECK_LAZY_SAMPLE) - 1,
+					&opts,
+					&session);
+	CHECK(err == 0);
+	err = sdp_session_media_get(session, 1, &media);
+	CHECK(err == 0);
+	err = sdp_session_media_remove(session, media);
+	CHECK(err == 0);
+	CHECK(sdp_session_media_get_count(session) == 1);
+	err = sdp_session_media_get(session, 1, &media);
+	CHECK(err == -ENOENT);
+	err = sdp_session_media_get(session, 0, &media);
+	CHECK((err == 0) && (media->dst_stream_port == 5004));
+	str = check_write(0, session);
+	CHECK(str != NULL);
+	err = (strstr(str, "m=audio ") == NULL) ? 0 : -EPROTO;
+	free(str);
+	CHECK(err == 0);
+
+	return 0;
+}
+
+
+/* Lazy reads: same written text, and copies that are built entirely and no
+ * longer depend on the source text */
+static int check_lazy(struct check_file *files, unsigned int file_count)
+{
+	int err = 0;
+	unsigned int i, j, lazy_count = 0;
+	static const uint32_t flags[] = {
+		SDP_READ_FLAG_LAZY_ATTRS,
+		SDP_READ_FLAG_LAZY_MEDIA,
+		SDP_READ_FLAG_LAZY_ATTRS | SDP_READ_FLAG_LAZY_MEDIA,
+	};
+
+	for (j = 0; (j < CHECK_ARRAY_SIZE(flags)) && (err == 0); j++) {
+		err = check_lazy_buf(CHECK_LAZY_SAMPLE,
+				     sizeof(CHECK_LAZY_SAMPLE) - 1,
+				     flags[j],
+				     &lazy_count);
+		for (i = 0; (i < file_count) && (err == 0); i++) {
+			err = check_lazy_buf(files[i].data,
+					     files[i].len,
+					     flags[j],
+					     &lazy_count);
+		}
+	}
+	if (err < 0)
+		return err;
+	CHECK(lazy_count > 0);
+	err = check_lazy_edit();
+	if (err < 0)
+		return err;
+
+	printf("lazy: %u lazy attributes ok\n", lazy_count);
+	return 0;
+}
+
+
+#define CHECK_INHERIT_SAMPLE                                                   \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 127.0.0.1\r\n"                                         \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 239.255.42.1/127\r\n"                                        \
+	"t=0 0\r\n"                                                            \
+	"a=sendonly\r\n"                                                       \
+	"a=rtcp-xr:pkt-loss-rle\r\n"                                           \
+	"m=video 5004 RTP/AVP 96\r\n"                                          \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"m=video 5006 RTP/AVP 96\r\n"                                          \
+	"c=IN IP4 239.255.42.2/127\r\n"                                        \
+	"a=rtpmap:96 H264/90000\r\n"
+
+#define CHECK_INHERIT_ALL                                                      \
+	(SDP_MEDIA_INHERIT_CONNECTION_ADDR | SDP_MEDIA_INHERIT_START_MODE |    \
+	 SDP_MEDIA_INHERIT_RTCP_XR)
+
+
+static struct sdp_media *check_inherit_first(struct sdp_session *session)
+{
+	return list_entry(list_first(&session->medias), struct sdp_media, node);
+}
+
+
+/* Connection address, start mode and RTCP extended reports of a media,
+ * inherited from its session (flagged, not copied) or its own ('own'
+ * bitfield of enum sdp_media_inherit values) */
+static int check_inherit_media(const struct sdp_media *media,
+			       const struct sdp_session *session,
+			       const char *addr,
+			       enum sdp_start_mode start_mode,
+			       uint16_t reports,
+			       unsigned int own)
+{
+	const char *media_addr;
+	const struct sdp_rtcp_xr *rtcp_xr;
+	int multicast = 0;
+
+	media_addr = sdp_media_get_connection_addr(media, session, &multicast);
+	CHECK((media_addr != NULL) && (strcmp(media_addr, addr) == 0));
+	CHECK(multicast);
+	CHECK(sdp_media_get_start_mode(media, session) == start_mode);
+	rtcp_xr = sdp_media_get_rtcp_xr(media, session);
+	CHECK((rtcp_xr != NULL) && (rtcp_xr->reports == reports));
+
+	if (own & SDP_MEDIA_INHERIT_CONNECTION_ADDR) {
+		CHECK(media->connection_addr == media_addr);
+	} else {
+		CHECK(media->inherited & SDP_MEDIA_INHERIT_CONNECTION_ADDR);
+		CHECK(media->connection_addr == NULL);
+	}
+	if (own & SDP_MEDIA_INHERIT_START_MODE) {
+		CHECK(media->start_mode == start_mode);
+	} else {
+		CHECK(media->inherited & SDP_MEDIA_INHERIT_START_MODE);
+		CHECK(media->start_mode == SDP_START_MODE_UNSPECIFIED);
+	}
+	if (own & SDP_MEDIA_INHERIT_RTCP_XR) {
+		CHECK(rtcp_xr == &media->rtcp_xr);
+	} else {
+		CHECK(media->inherited & SDP_MEDIA_INHERIT_RTCP_XR);
+		CHECK(!media->rtcp_xr.valid);
+	}
+	return 0;
+}
+
+
+/* Inherited session-level values: resolved from the session of the media,
+ * including after a copy, and replaced by the caller like any other media
+ * value */
+static int check_inherit(struct check_file *files, unsigned int file_count)
+{
+	int err;
+	struct sdp_session *session = NULL, *copy = NULL, *other = NULL;
+	struct sdp_media *media;
+	char *str = NULL;
+	uint16_t loss = SDP_RTCP_XR_REPORT_BIT(SDP_RTCP_XR_REPORT_LOSS_RLE);
+	uint16_t dup = SDP_RTCP_XR_REPORT_BIT(SDP_RTCP_XR_REPORT_DUP_RLE);
+
+	(void)files;
+	(void)file_count;
+
+	err = sdp_description_read(CHECK_INHERIT_SAMPLE, &session);
+	if (err < 0)
+		return err;
+	media = check_inherit_first(session);
+	err = check_inherit_media(media,
+				  session,
+				  "239.255.42.1",
+				  SDP_START_MODE_SENDONLY,
+				  loss,
+				  0);
+	if (err < 0)
+		goto out;
+
+	/* The session copy resolves the values from its own session */
+	copy = sdp_session_new();
+	if (copy == NULL) {
+		err = -ENOMEM;
+		goto out;
+	}
+	err = sdp_session_copy(session, copy);
+	if (err < 0)
+		goto out;
+	free(session->connection_addr);
+	session->connection_addr = strdup("239.255.42.3");
+	err = check_inherit_media(check_inherit_first(copy),
+				  copy,
+				  "239.255.42.1",
+				  SDP_START_MODE_SENDONLY,
+				  loss,
+				  0);
+	if (err < 0)
+		goto out;
+	err = check_inherit_media(media,
+				  session,
+				  "239.255.42.3",
+				  SDP_START_MODE_SENDONLY,
+				  loss,
+				  0);
+	if (err < 0)
+		goto out;
+
+	/* So does a media copied in another session */
+	other = sdp_session_new();
+	if (other == NULL) {
+		err = -ENOMEM;
+		goto out;
+	}
+	other->connection_addr = strdup("239.255.42.5");
+	other->multicast = 1;
+	other->start_mode = SDP_START_MODE_INACTIVE;
+	other->rtcp_xr.valid = 1;
+	other->rtcp_xr.reports = dup;
+	err = sdp_session_media_add(other, &media);
+	if (err < 0)
+		goto out;
+	err = sdp_media_copy(check_inherit_first(session), media);
+	if (err < 0)
+		goto out;
+	err = check_inherit_media(
+		media, other, "239.255.42.5", SDP_START_MODE_INACTIVE, dup, 0);
+	if (err < 0)
+		goto out;
+
+	/* Replaced by the caller: owned, and written */
+	media = check_inherit_first(session);
+	free(media->connection_addr);
+	media->connection_addr = strdup("239.255.42.4");
+	media->multicast = 1;
+	media->start_mode = SDP_START_MODE_RECVONLY;
+	media->rtcp_xr = session->rtcp_xr;
+	media->rtcp_xr.reports |= dup;
+	err = check_inherit_media(media,
+				  session,
+				  "239.255.42.4",
+				  SDP_START_MODE_RECVONLY,
+				  loss | dup,
+				  CHECK_INHERIT_ALL);
+	if (err < 0)
+		goto out;
+	err = sdp_description_write(session, &str);
+	if (err < 0)
+		goto out;
+	if ((strstr(str,
+		    "m=video 5004 RTP/AVP 96\r\n"
+		    "c=IN IP4 239.255.42.4/127\r\n"
+		    "a=recvonly\r\n"
+		    "a=rtpmap:96 H264/90000\r\n"
+		    "a=rtcp-xr:pkt-loss-rle pkt-dup-rle\r\n") == NULL) ||
+	    (strstr(str,
+		    "m=video 5006 RTP/AVP 96\r\n"
+		    "c=IN IP4 239.255.42.2/127\r\n"
+		    "a=rtpmap:96 H264/90000\r\n") == NULL)) {
+		fprintf(stderr, "inherit: media values not written:\n%s", str);
+		err = -EPROTO;
+		goto out;
+	}
+
+	printf("inherit: ok\n");
+
+out:
+	sdp_session_destroy(session);
+	sdp_session_destroy(copy);
+	sdp_session_destroy(other);
+	free(str);
+	return err;
+}
+
+
+/* Invalid description and its expected error */
+struct check_error {
+	const char *text;
+	struct sdp_error error;
+};
+
+
+static const struct check_error check_errors[] = {
+	{"v=1\r\n", {1, 3, 'v', SDP_ERROR_REASON_UNSUPPORTED}},
+	{"v=0\n"
+	 "o=- 12x 1 IN IP4 127.0.0.1\n",
+	 {2, 5, 'o', SDP_ERROR_REASON_INVALID_VALUE}},
+	{"v=0\r\n"
+	 "o=- 1 1 IN IP4 127.0.0.1\r\n"
+	 "s=-\r\n"
+	 "c=IN IP4 127.0.0.1\r\n"
+	 "t=0 0\r\n"
+	 "m=video 5004 RTP/AVP 96\r\n"
+	 "a=rtpmap:97 H264/90000\r\n",
+	 {7, 10, 'a', SDP_ERROR_REASON_PAYLOAD_TYPE_MISMATCH}},
+	{"v=0\r\n"
+	 "o=- 1 1 IN IP4 127.0.0.1\r\n"
+	 "c=IN IP4 127.0.0.1\r\n"
+	 "t=0 0\r\n",
+	 {0, 0, 's', SDP_ERROR_REASON_MISSING_FIELD}},
+	{"v=0\r\n"
+	 "o=- 1 1 IN IP4 127.0.0.1\r\n"
+	 "s=-\r\n"
+	 "t=0 0\r\n"
+	 "m=video 5004 RTP/AVP 96\r\n",
+	 {0, 0, 'c', SDP_ERROR_REASON_MISSING_FIELD}},
+};
+
+
+/* Position, type and reason of read errors */
+static int check_error(struct check_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i;
+
+	(void)files;
+	(void)file_count;
+
+	for (i = 0; i < CHECK_ARRAY_SIZE(check_errors); i++) {
+		const struct sdp_error *ref = &check_errors[i].error;
+		struct sdp_session *session = NULL;
+		struct sdp_error error;
+
+		memset(&error, 0, sizeof(error));
+		err = sdp_description_read_err(check_errors[i].text,
+					       strlen(check_errors[i].text),
+					       NULL,
+					       &session,
+					       &error);
+		sdp_session_destroy(session);
+		if ((err == 0) || (error.line != ref->line) ||
+		    (error.column != ref->column) ||
+		    (error.type != ref->type) ||
+		    (error.reason != ref->reason)) {
+			fprintf(stderr,
+				"error: %u: %d, line %u column %u type '%c' "
+				"reason %d\n",
+				i,
+				err,
+				error.line,
+				error.column,
+				error.type ? error.type : ' ',
+				error.reason);
+			return -EPROTO;
+		}
+	}
+
+	printf("error: %u errors ok\n", i);
+	return 0;
+}
+
+
+/* Description read with SDP_READ_FLAG_RAW_LINES, and its written form */
+#define CHECK_RAW_SAMPLE                                                       \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 127.0.0.1\r\n"                                         \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 127.0.0.1\r\n"                                               \
+	"t=0 0\r\n"                                                            \
+	"b=AS:100\r\n"                                                         \
+	"m=video 5004 RTP/AVP 96 97\r\n"                                       \
+	"b=AS:50\r\n"                                                          \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"a=rtpmap:97 VP8/90000\r\n"                                            \
+	"a=x-check:1\r\n"                                                      \
+	"a=control:trackID=1\r\n"                                              \
+	"k=clear:key\r\n"
+
+#define CHECK_RAW_WRITTEN                                                      \
+	"v=0\r\n"                                                              \
+	"o=- 1 1 IN IP4 127.0.0.1\r\n"                                         \
+	"s=-\r\n"                                                              \
+	"c=IN IP4 127.0.0.1\r\n"                                               \
+	"b=AS:100\r\n"                                                         \
+	"t=0 0\r\n"                                                            \
+	"m=video 5004 RTP/AVP 96 97\r\n"                                       \
+	"b=AS:50\r\n"                                                          \
+	"k=clear:key\r\n"                                                      \
+	"a=control:trackID=1\r\n"                                              \
+	"a=rtpmap:96 H264/90000\r\n"                                           \
+	"a=rtpmap:97 VP8/90000\r\n"                                            \
+	"a=x-check:1\r\n"
+
+
+/* Raw lines written at their documented position, and unchanged when
+ * written again */
+static int check_raw(struct check_file *files, unsigned int file_count)
+{
+	int err;
+	unsigned int i;
+	const char *text = CHECK_RAW_SAMPLE;
+	struct sdp_read_opts opts;
+	char *str = NULL;
+
+	(void)files;
+	(void)file_count;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.flags = SDP_READ_FLAG_RAW_LINES;
+	for (i = 0; i < 2; i++) {
+		struct sdp_session *session = NULL;
+		err = sdp_description_read_opts(
+			text, strlen(text), &opts, &session);
+		free(str);
+		str = check_write(err, session);
+		if (!check_same_text(str, CHECK_RAW_WRITTEN)) {
+			fprintf(stderr, "raw: written text differs:\n%s", str);
+			free(str);
+			return -EPROTO;
+		}
+		text = str;
+	}
+	free(str);
+
+	printf("raw: ok\n");
+	return 0;
+}
+
+
+struct check {
+	const char *name;
+	const char *desc;
+	int (*run)(struct check_file *files, unsigned int file_count);
+};
+
+
+static const struct check checks[] = {
+	{"scan", "delimiter scan implementations", &check_scan},
+	{"parser", "chunk-fed parser at every split point", &check_parser},
+	{"range", "range attribute write and read back", &check_range},
+	{"batch", "split and batch read, status of each item", &check_batch},
+	{"lazy", "lazy read output and copy", &check_lazy},
+	{"inherit", "inherited session-level values", &check_inherit},
+	{"error", "position and reason of read errors", &check_error},
+	{"raw", "raw lines position when writing", &check_raw},
+};
+
+
+static void usage(const char *prog_name)
+{
+	unsigned int i;
+
+	printf("Usage: %s [<check>|all] [<file>...]\n"
+	       "  Run the library checks, using the given SDP files "
+	       "as corpus\n\n"
+	       "Checks:\n",
+	       prog_name);
+	for (i = 0; i < CHECK_ARRAY_SIZE(checks); i++)
+		printf("  %-8s %s\n", checks[i].name, checks[i].desc);
+}
+
+
+int main(int argc, char **argv)
+{
+	int status = EXIT_SUCCESS, err;
+	const char *name = "all";
+	struct check_file *files = NULL;
+	unsigned int i, file_count = 0, run = 0;
+
+	if (argc >= 2) {
+		if ((strcmp(argv[1], "-h") == 0) ||
+		    (strcmp(argv[1], "--help") == 0)) {
+			usage(argv[0]);
+			exit(EXIT_SUCCESS);
+		}
+		name = argv[1];
+	}
+
+	if (argc > 2) {
+		files = calloc(argc - 2, sizeof(*files));
+		if (files == NULL) {
+			ULOG_ERRNO("calloc", ENOMEM);
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 2; i < (unsigned int)argc; i++) {
+		err = check_load_file(argv[i], &files[file_count]);
+		if (err < 0) {
+			status = EXIT_FAILURE;
+			goto cleanup;
+		}
+		file_count++;
+	}
+
+	for (i = 0; i < CHECK_ARRAY_SIZE(checks); i++) {
+		if ((strcmp(name, "all") != 0) &&
+		    (strcmp(name, checks[i].name) != 0))
+			continue;
+		run++;
+		err = checks[i].run(files, file_count);
+		if (err < 0) {
+			ULOG_ERRNO("check '%s'", -err, checks[i].name);
+			status = EXIT_FAILURE;
+		}
+	}
+	if (run == 0) {
+		usage(argv[0]);
+		status = EXIT_FAILURE;
+	}
+
+cleanup:
+	for (i = 0; i < file_count; i++)
+		free(files[i].data);
+	free(files);
+	printf("%s\n", (status == EXIT_SUCCESS) ? "Done!" : "Failed!");
+	exit(status);
+}
@@ -73,63 +73,51 @@ static void print_h264_fmtp(struct sdp_h264_fmtp *fmtp, const char *prefix)
 }
 
 
-static void print_rtcp_xr_info(struct sdp_rtcp_xr *xr, const char *prefix)
+static void print_rtcp_xr_info(const struct sdp_rtcp_xr *xr,
+			       const char *prefix)
 {
+	unsigned int i;
+
 	if (!xr)
 		return;
 
 	printf("%s-- RTCP XR\n", prefix);
-	printf("%s   -- loss RLE report: %d (%d)\n",
-	       prefix,
-	       xr->loss_rle_report,
-	       xr->loss_rle_report_max_size);
-	printf("%s   -- duplicate RLE report: %d (%d)\n",
-	       prefix,
-	       xr->dup_rle_report,
-	       xr->dup_rle_report_max_size);
-	printf("%s   -- packet receipt times report: %d (%d)\n",
-	       prefix,
-	       xr->pkt_receipt_times_report,
-	       xr->pkt_receipt_times_report_max_size);
-	printf("%s   -- receiver reference time report: %d (%d)\n",
-	       prefix,
-	       xr->rtt_report,
-	       xr->rtt_report_max_size);
-	printf("%s   -- statistics summary report (loss): %d\n",
-	       prefix,
-	       xr->stats_summary_report_loss);
-	printf("%s   -- statistics summary report (dup): %d\n",
-	       prefix,
-	       xr->stats_summary_report_dup);
-	printf("%s   -- statistics summary report (jitter): %d\n",
-	       prefix,
-	       xr->stats_summary_report_jitter);
-	printf("%s   -- statistics summary report (ttl): %d\n",
-	       prefix,
-	       xr->stats_summary_report_ttl);
-	printf("%s   -- statistics summary report (hl): %d\n",
-	       prefix,
-	       xr->stats_summary_report_hl);
-	printf("%s   -- VOIP metrics report: %d\n",
-	       prefix,
-	       xr->voip_metrics_report);
-	printf("%s   -- de-jitter buffer metrics report: %d\n",
-	       prefix,
-	       xr->djb_metrics_report);
+	for (i = 0; i < SDP_RTCP_XR_REPORT_MAX; i++) {
+		printf("%s   -- %s report: %d",
+		       prefix,
+		       sdp_rtcp_xr_report_str(i),
+		       (xr->reports & SDP_RTCP_XR_REPORT_BIT(i)) != 0);
+		if (i == SDP_RTCP_XR_REPORT_RTT) {
+			printf(" %s",
+			       sdp_rtcp_xr_rtt_report_mode_str(xr->rtt_report));
+		}
+		if (i < SDP_RTCP_XR_SIZED_REPORT_COUNT)
+			printf(" (%u)", xr->max_size[i]);
+		printf("\n");
+	}
 }
 
 
-static void print_media_info(struct sdp_media *media)
+static void print_media_info(struct sdp_media *media,
+			     struct sdp_session *session)
 {
+	const char *connection_addr;
+	const struct sdp_rtcp_xr *rtcp_xr;
+	int multicast = 0;
+
 	if (!media)
 		return;
 
+	connection_addr =
+		sdp_media_get_connection_addr(media, session, &multicast);
+	rtcp_xr = sdp_media_get_rtcp_xr(media, session);
+
 	printf("-- Media\n");
 	printf("   -- type: %s\n", sdp_media_type_str(media->type));
 	printf("   -- media title: %s\n", media->media_title);
 	printf("   -- connection address: %s%s\n",
-	       media->connection_addr,
-	       (media->multicast) ? " (multicast)" : "");
+	       connection_addr,
+	       (multicast) ? " (multicast)" : "");
 	printf("   -- control URL: %s\n", media->control_url);
 	if ((media->range.start.format == SDP_TIME_FORMAT_NPT) &&
 	    (!media->range.start.npt.now) &&
@@ -141,7 +129,8 @@ static void print_media_info(struct sdp_media *media)
 		       (long)media->range.stop.npt.sec,
 		       media->range.stop.npt.usec / 1000);
 	}
-	printf("   -- start mode: %s\n", sdp_start_mode_str(media->start_mode));
+	printf("   -- start mode: %s\n",
+	       sdp_start_mode_str(sdp_media_get_start_mode(media, session)));
 	printf("   -- stream port: %d\n", media->dst_stream_port);
 	printf("   -- control port: %d\n", media->dst_control_port);
 	printf("   -- payload type: %d\n", media->payload_type);
@@ -150,8 +139,8 @@ static void print_media_info(struct sdp_media *media)
 	printf("   -- clock rate: %d\n", media->clock_rate);
 	if (media->h264_fmtp.valid)
 		print_h264_fmtp(&media->h264_fmtp, "   ");
-	if (media->rtcp_xr.valid)
-		print_rtcp_xr_info(&media->rtcp_xr, "   ");
+	if (rtcp_xr != NULL)
+		print_rtcp_xr_info(rtcp_xr, "   ");
 	struct sdp_attr *attr = NULL;
 	list_walk_entry_forward(&media->attrs, attr, node)
 	{
@@ -208,7 +197,7 @@ static void print_session_info(struct sdp_session *session)
 	}
 	struct sdp_media *media = NULL;
 	list_walk_entry_forward(&session->medias, media, node)
-		print_media_info(media);
+		print_media_info(media, session);
 }
 
 
@@ -280,8 +269,9 @@ int main(int argc, char **argv)
 		session->tool = strdup(argv[0]);
 		session->type = strdup("broadcast");
 		session->rtcp_xr.valid = 1;
-		session->rtcp_xr.loss_rle_report = 1;
-		session->rtcp_xr.djb_metrics_report = 1;
+		session->rtcp_xr.reports =
+			SDP_RTCP_XR_REPORT_BIT(SDP_RTCP_XR_REPORT_LOSS_RLE) |
+			SDP_RTCP_XR_REPORT_BIT(SDP_RTCP_XR_REPORT_DJB_METRICS);
 		session->range.start.format = SDP_TIME_FORMAT_NPT;
 		session->range.start.npt.sec = 0;
 		session->range.start.npt.usec = 0;